@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+// Standard allocator interface on top of a memory resource, so it can be the Allocator of std containers and
+// Hashmap. Resource is anything with
+//   void* allocate(size_t bytes, size_t alignment)
+//   void deallocate(void* p, size_t bytes, size_t alignment)
+// which is both NodePool (PoolAllocator) and std::pmr::memory_resource (ArenaAllocator).
+//
+// Containers rebind it to their node type (std::list<T, PoolAllocator<T>> really allocates list nodes), all
+// the rebound copies keep pointing at the same resource.
+// Unlike std::pmr::polymorphic_allocator it propagates on copy / move / swap, so a copy of a container stays
+// on the same pool or arena as the original.
+// A default constructed one has no resource and just uses ::operator new / delete.
+// Only a pointer, its as thread safe as the resource behind it.
+template <typename T, typename Resource>
+class ResourceAllocator {
+public:
+    using value_type = T;
+
+    ResourceAllocator() noexcept = default;
+
+    explicit ResourceAllocator(Resource* resource) noexcept: mResource(resource) {}
+
+    // converting constructor, used by rebind
+    template <typename U>
+    ResourceAllocator(const ResourceAllocator<U, Resource>& other) noexcept: mResource(other.resource()) {}
+
+    T* allocate(size_t n) {
+        if (!mResource) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+        }
+        return static_cast<T*>(mResource->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        if (!mResource) {
+            ::operator delete(p, std::align_val_t{alignof(T)});
+            return;
+        }
+        mResource->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    Resource* resource() const noexcept {
+        return mResource;
+    }
+
+    // containers keep using the same resource when they are copied / moved / swapped
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    // memory from one can be freed through the other iff they share a resource
+    template <typename U>
+    friend bool operator==(const ResourceAllocator& a, const ResourceAllocator<U, Resource>& b) noexcept {
+        return a.resource() == b.resource();
+    }
+
+private:
+    Resource* mResource = nullptr;
+};
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include "../ResourceAllocator.hpp"
+
+// MonotonicArena is a bump allocator: it hands out memory by moving a cursor forward through big chunks
+// and never frees anything on its own. deallocate is a no-op, all the memory comes back at once in reset().
+//
+// Good for things that are built up together and then thrown away together, eg everything a server builds
+// while handling one request. Instead of one malloc + one free per Vector buffer / String / Hashmap node,
+// its a pointer bump per allocation and one reset at the end.
+//
+//   allocate -> align the cursor, bump it. Out of room -> chain a new chunk, twice as big as the last one
+//   reset    -> rewind to the start. If it took more than one chunk they get merged into a single chunk as
+//               big as all of them together, so the next request of the same size fits in it and from
+//               then on a request costs zero mallocs
+//   release  -> give every chunk back
+//
+// It is a std::pmr::memory_resource, so Vector, String (pass it in the constructor), Hashmap (through
+// ArenaAllocator below) and the std::pmr containers can all share one arena.
+// Nothing destroys the objects living in the arena: destroy the containers first, then reset.
+// No locking, one arena belongs to one thread at a time (std::pmr::synchronized_pool_resource is the shared kind).
+//
+//   MonotonicArena arena;
+//   {
+//       Vector<int> ids(&arena);
+//       String body(payload, &arena);
+//       ...
+//   }
+//   arena.reset();
+
+class MonotonicArena : public std::pmr::memory_resource {
+public:
+    static constexpr size_t kDefaultChunkSize = 4096;
+
+    struct Stats {
+        size_t chunksAllocated = 0; // calls to ::operator new for chunks
+        size_t bytesReserved = 0;   // total size of the chunks held right now
+        size_t allocations = 0;     // allocate calls since the last reset
+        size_t bytesAllocated = 0;  // bytes handed out since the last reset (without alignment padding)
+        size_t resets = 0;
+    };
+
+    explicit MonotonicArena(size_t chunkSize = kDefaultChunkSize): mNextChunkSize(std::max(chunkSize, size_t{64})) {}
+
+    // Uses buffer (eg an array on the stack) as the first chunk, and only goes to the heap once it is full.
+    // buffer is never freed by the arena and has to outlive it.
+    MonotonicArena(void* buffer, size_t size)
+        : mInitialBuffer(static_cast<char*>(buffer)), mInitialSize(size), mNextChunkSize(std::max(size, size_t{64})) {
+        rewindToInitial();
+    }
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    ~MonotonicArena() override {
+        freeChunks(nullptr);
+    }
+
+    // Everything handed out so far is invalid after this.
+    // With an initial buffer that is used again first and the chunks are given back.
+    void reset() {
+        if (mInitialBuffer) {
+            freeChunks(nullptr);
+            rewindToInitial();
+        } else if (mChunks && mChunks->next) {
+            size_t total = mStats.bytesReserved;
+            freeChunks(nullptr);
+            newChunk(total);
+        } else if (mChunks) {
+            mCursor = reinterpret_cast<char*>(mChunks + 1);
+            mEnd = mCursor + mChunks->size;
+        }
+        mStats.allocations = 0;
+        mStats.bytesAllocated = 0;
+        mStats.resets++;
+    }
+
+    // like reset, but gives every chunk back to the system
+    void release() {
+        freeChunks(nullptr);
+        mCursor = nullptr;
+        mEnd = nullptr;
+        if (mInitialBuffer) {
+            rewindToInitial();
+        }
+        mStats.allocations = 0;
+        mStats.bytesAllocated = 0;
+    }
+
+    const Stats& stats() const {
+        return mStats;
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        char* p = alignUp(mCursor, alignment);
+        if (!p || p + bytes > mEnd) {
+            newChunk(bytes + alignment);
+            p = alignUp(mCursor, alignment);
+        }
+        mCursor = p + bytes;
+        mStats.allocations++;
+        mStats.bytesAllocated += bytes;
+        return p;
+    }
+
+    // the memory comes back in reset()
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    // chunk header sits at the front of every chunk, the chain is newest first
+    struct alignas(std::max_align_t) Chunk {
+        Chunk* next;
+        size_t size; // usable bytes after the header
+    };
+
+    static char* alignUp(char* p, size_t alignment) {
+        if (!p) {
+            return nullptr;
+        }
+        auto addr = reinterpret_cast<uintptr_t>(p);
+        return p + ((alignment - addr % alignment) % alignment);
+    }
+
+    void newChunk(size_t atLeast) {
+        // each chunk is twice as big as the one before, so a big request only costs log(n) chunks
+        size_t size = std::max(mNextChunkSize, atLeast);
+        Chunk* chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + size));
+        chunk->next = mChunks;
+        chunk->size = size;
+        mChunks = chunk;
+        // the tail of the old chunk just gets wasted
+        mCursor = reinterpret_cast<char*>(chunk + 1);
+        mEnd = mCursor + size;
+        mNextChunkSize = size * 2;
+        mStats.chunksAllocated++;
+        mStats.bytesReserved += size;
+    }
+
+    // frees every chunk in the chain except keep (which becomes the only one left)
+    void freeChunks(Chunk* keep) {
+        Chunk* chunk = mChunks;
+        while (chunk) {
+            Chunk* next = chunk->next;
+            if (chunk != keep) {
+                mStats.bytesReserved -= chunk->size;
+                ::operator delete(chunk);
+            }
+            chunk = next;
+        }
+        mChunks = keep;
+        if (keep) {
+            keep->next = nullptr;
+        }
+    }
+
+    void rewindToInitial() {
+        mCursor = mInitialBuffer;
+        mEnd = mInitialBuffer + mInitialSize;
+    }
+
+    char* mInitialBuffer = nullptr;
+    size_t mInitialSize = 0;
+    size_t mNextChunkSize;
+    Chunk* mChunks = nullptr;
+    char* mCursor = nullptr;
+    char* mEnd = nullptr;
+    Stats mStats;
+};
+
+// Any std::pmr::memory_resource (normally a MonotonicArena) as the Allocator of containers that take an
+// Allocator type like Hashmap (see ResourceAllocator.hpp)
+//
+//   MonotonicArena arena;
+//   using Alloc = ArenaAllocator<std::pair<const int, int>>;
+//   Hashmap<int, int, std::hash<int>, std::equal_to<int>, Alloc> map{Alloc{&arena}};
+template <typename T>
+using ArenaAllocator = ResourceAllocator<T, std::pmr::memory_resource>;
@@ -0,0 +1,107 @@
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MonotonicArena.hpp"
+#include "../../data-structures/hashmap/Hashmap.hpp"
+#include "../../data-structures/vector/Vector.hpp"
+#include "../../string/String.hpp"
+
+// Google Benchmark, link with -lbenchmark -lbenchmark_main -pthread, and ../../string/String.cpp
+// Counts every malloc / realloc in the process (operator new ends up in malloc too), so the numbers show how
+// many trips to the heap a request makes.
+
+namespace {
+size_t gHeapAllocations = 0;
+}
+
+// glibc's own entry points, our malloc / realloc below replace the public ones for the whole binary
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_realloc(void* p, size_t size);
+
+extern "C" void* malloc(size_t size) {
+    gHeapAllocations++;
+    return __libc_malloc(size);
+}
+
+extern "C" void* realloc(void* p, size_t size) {
+    gHeapAllocations++;
+    return __libc_realloc(p, size);
+}
+
+namespace {
+
+using HeapMap = Hashmap<uint32_t, uint32_t>;
+using ArenaMap = Hashmap<uint32_t, uint32_t, std::hash<uint32_t>, std::equal_to<uint32_t>,
+                         ArenaAllocator<std::pair<const uint32_t, uint32_t>>>;
+
+// what a request handler might build: header values (too long for String's small buffer),
+// an id -> position index and a list of token offsets. Everything is thrown away at the end.
+struct Payload {
+    std::vector<std::string> headers;
+    std::vector<uint32_t> ids;
+};
+
+Payload makePayload(size_t headers) {
+    Payload payload;
+    for (size_t i = 0; i < headers; i++) {
+        payload.headers.push_back(std::string(160 + i % 64, static_cast<char>('a' + i % 26)));
+        payload.ids.push_back(static_cast<uint32_t>(i * 2654435761u));
+    }
+    return payload;
+}
+
+// resource == nullptr -> everything on the normal heap
+template <typename Map>
+size_t handleRequest(const Payload& payload, std::pmr::memory_resource* resource, const Map& prototype) {
+    Vector<String> headers(resource);
+    Vector<uint32_t> offsets(resource);
+    Map index(prototype.get_allocator());
+    for (size_t i = 0; i < payload.headers.size(); i++) {
+        headers.emplace_back(std::string_view(payload.headers[i]), resource);
+        index[payload.ids[i]] = static_cast<uint32_t>(i);
+        for (size_t t = 0; t < 8; t++) {
+            offsets.push_back(static_cast<uint32_t>(i * 8 + t));
+        }
+    }
+    size_t checksum = 0;
+    for (size_t i = 0; i < payload.ids.size(); i++) {
+        checksum += index.at(payload.ids[i]) + headers[i].size() + offsets[i];
+    }
+    return checksum;
+}
+
+} // namespace
+
+static void BM_RequestHeap(benchmark::State& state) {
+    auto payload = makePayload(state.range(0));
+    HeapMap prototype;
+    size_t allocations = 0;
+    for (auto _: state) {
+        size_t before = gHeapAllocations;
+        benchmark::DoNotOptimize(handleRequest(payload, nullptr, prototype));
+        allocations += gHeapAllocations - before;
+    }
+    state.counters["heap_allocs_per_request"] = static_cast<double>(allocations) / state.iterations();
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_RequestArena(benchmark::State& state) {
+    auto payload = makePayload(state.range(0));
+    MonotonicArena arena;
+    ArenaMap prototype{ArenaAllocator<std::pair<const uint32_t, uint32_t>>(&arena)};
+    size_t allocations = 0;
+    for (auto _: state) {
+        size_t before = gHeapAllocations;
+        benchmark::DoNotOptimize(handleRequest(payload, &arena, prototype));
+        arena.reset();
+        allocations += gHeapAllocations - before;
+    }
+    state.counters["heap_allocs_per_request"] = static_cast<double>(allocations) / state.iterations();
+    state.counters["arena_bytes"] = static_cast<double>(arena.stats().bytesReserved);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_RequestHeap)->Arg(16)->Arg(64)->Arg(256);
+BENCHMARK(BM_RequestArena)->Arg(16)->Arg(64)->Arg(256);
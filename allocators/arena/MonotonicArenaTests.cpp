@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MonotonicArena.hpp"
+#include "../../data-structures/hashmap/Hashmap.hpp"
+#include "../../data-structures/vector/Vector.hpp"
+#include "../../string/String.hpp"
+
+// build with ../../string/String.cpp
+
+namespace {
+
+// true if p lies inside the chunks / buffer the test knows about
+bool inside(const void* p, const void* begin, size_t size) {
+    auto addr = reinterpret_cast<uintptr_t>(p);
+    auto start = reinterpret_cast<uintptr_t>(begin);
+    return addr >= start && addr < start + size;
+}
+
+} // namespace
+
+TEST(MonotonicArenaTest, BumpsAlignsAndChainsChunks) {
+    MonotonicArena arena(256);
+    char* a = static_cast<char*>(arena.allocate(10, 1));
+    char* b = static_cast<char*>(arena.allocate(10, 1));
+    EXPECT_EQ(b, a + 10);
+    void* aligned = arena.allocate(8, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0);
+    EXPECT_EQ(arena.stats().chunksAllocated, 1);
+
+    // doesnt fit in the 256 byte chunk, the next one doubles
+    EXPECT_NE(arena.allocate(300, 8), nullptr);
+    EXPECT_EQ(arena.stats().chunksAllocated, 2);
+    EXPECT_EQ(arena.stats().bytesReserved, 256 + 512);
+    EXPECT_EQ(arena.stats().allocations, 4);
+}
+
+TEST(MonotonicArenaTest, ResetMergesTheChunks) {
+    MonotonicArena arena(256);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_NE(arena.allocate(64, 8), nullptr);
+    }
+    size_t chunks = arena.stats().chunksAllocated;
+    size_t reserved = arena.stats().bytesReserved;
+    EXPECT_GT(chunks, 1);
+
+    // one chunk as big as all of them, so the same round again needs no new chunk
+    arena.reset();
+    EXPECT_EQ(arena.stats().allocations, 0);
+    EXPECT_GE(arena.stats().bytesReserved, reserved);
+    EXPECT_EQ(arena.stats().chunksAllocated, chunks + 1);
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_NE(arena.allocate(64, 8), nullptr);
+        }
+        arena.reset();
+    }
+    EXPECT_EQ(arena.stats().chunksAllocated, chunks + 1);
+
+    arena.release();
+    EXPECT_EQ(arena.stats().bytesReserved, 0);
+}
+
+TEST(MonotonicArenaTest, InitialBufferComesFirst) {
+    alignas(std::max_align_t) char buffer[512];
+    MonotonicArena arena(buffer, sizeof(buffer));
+    void* p = arena.allocate(100, 8);
+    EXPECT_TRUE(inside(p, buffer, sizeof(buffer)));
+    EXPECT_EQ(arena.stats().chunksAllocated, 0);
+
+    void* q = arena.allocate(1000, 8);
+    EXPECT_FALSE(inside(q, buffer, sizeof(buffer)));
+    EXPECT_EQ(arena.stats().chunksAllocated, 1);
+
+    arena.reset();
+    EXPECT_EQ(arena.allocate(100, 8), p);
+}
+
+TEST(MonotonicArenaTest, VectorGrowsInTheArena) {
+    alignas(std::max_align_t) char buffer[1 << 16];
+    MonotonicArena arena(buffer, sizeof(buffer));
+    Vector<int> vec(&arena);
+    for (int i = 0; i < 1000; ++i) {
+        vec.push_back(i);
+    }
+    EXPECT_TRUE(inside(vec.data(), buffer, sizeof(buffer)));
+    EXPECT_EQ(vec[999], 999);
+    EXPECT_EQ(arena.stats().chunksAllocated, 0);
+
+    // moves take the resource along
+    Vector<int> moved(std::move(vec));
+    EXPECT_EQ(moved.resource(), &arena);
+    EXPECT_TRUE(inside(moved.data(), buffer, sizeof(buffer)));
+
+    // a heap vector assigned from an arena one keeps its own resource, so the elements get copied out
+    Vector<int> heap{1, 2, 3};
+    heap = std::move(moved);
+    EXPECT_EQ(heap.resource(), nullptr);
+    EXPECT_FALSE(inside(heap.data(), buffer, sizeof(buffer)));
+    EXPECT_EQ(heap.size(), 1000);
+    EXPECT_EQ(heap[500], 500);
+
+    // copies go to whatever resource they are given
+    Vector<int> copy(heap, &arena);
+    EXPECT_TRUE(inside(copy.data(), buffer, sizeof(buffer)));
+    heap.swap(copy);
+    EXPECT_EQ(heap.resource(), nullptr);
+    EXPECT_FALSE(inside(heap.data(), buffer, sizeof(buffer)));
+    EXPECT_EQ(copy[999], 999);
+}
+
+TEST(MonotonicArenaTest, StringHeapBuffersComeFromTheArena) {
+    alignas(std::max_align_t) char buffer[4096];
+    MonotonicArena arena(buffer, sizeof(buffer));
+    std::string longText(300, 'x');
+
+    String small("short", &arena);
+    EXPECT_EQ(arena.stats().allocations, 0); // fits in the small buffer
+
+    String big(longText, &arena);
+    EXPECT_TRUE(inside(big.c_str(), buffer, sizeof(buffer)));
+    big.append("yz");
+    EXPECT_TRUE(inside(big.c_str(), buffer, sizeof(buffer)));
+    EXPECT_EQ(big.size(), 302);
+
+    String moved(std::move(big));
+    EXPECT_EQ(moved.get_resource(), &arena);
+    EXPECT_TRUE(inside(moved.c_str(), buffer, sizeof(buffer)));
+
+    String heap;
+    heap = moved;
+    EXPECT_EQ(heap.get_resource(), nullptr);
+    EXPECT_FALSE(inside(heap.c_str(), buffer, sizeof(buffer)));
+    heap = std::move(moved);
+    EXPECT_FALSE(inside(heap.c_str(), buffer, sizeof(buffer)));
+    EXPECT_EQ(heap.size(), 302);
+    EXPECT_EQ(moved.size(), 0);
+}
+
+TEST(MonotonicArenaTest, HashmapNodesAndBucketsComeFromTheArena) {
+    using Alloc = ArenaAllocator<std::pair<const int, int>>;
+    MonotonicArena arena;
+    {
+        Hashmap<int, int, std::hash<int>, std::equal_to<int>, Alloc> map{Alloc(&arena)};
+        for (int i = 0; i < 1000; ++i) {
+            map[i] = i * 2;
+        }
+        map.erase(10);
+        EXPECT_EQ(map.at(999), 1998);
+        EXPECT_FALSE(map.contains(10));
+    }
+    // every node and every bucket array went through the arena
+    EXPECT_GT(arena.stats().allocations, 1000);
+    arena.reset();
+}
+
+TEST(MonotonicArenaTest, WorksWithStdPmrContainers) {
+    MonotonicArena arena;
+    std::pmr::vector<std::pmr::string> names(&arena);
+    for (int i = 0; i < 100; ++i) {
+        names.emplace_back(std::string(50, static_cast<char>('a' + i % 26)));
+    }
+    EXPECT_EQ(names[27][0], 'b');
+    EXPECT_GT(arena.stats().allocations, 100);
+}
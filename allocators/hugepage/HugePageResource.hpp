@@ -0,0 +1,219 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Memory resource for very big buffers, eg a Vector of a few hundred MB:
+//   Vector<uint64_t> big(&hugePages);
+//
+// Two problems with getting those from ::operator new / malloc:
+//   TLB misses  the buffer comes in 4K pages, so random access over 1GB touches 262144 different pages and
+//               the TLB (a couple of thousand entries) misses on almost every access, each miss costing a walk
+//               of the page tables. With 2MB pages the same 1GB is 512 pages.
+//   NUMA        on a multi socket machine a page lives on the node of whichever thread touched it first, so
+//               a buffer filled by one thread and read by all of them is remote memory for half of them.
+//
+// Anything at least threshold bytes is mmapped directly instead:
+//   HugePages::Transparent  plain anonymous mapping, 2MB aligned, with madvise(MADV_HUGEPAGE) so the kernel
+//                           backs it with transparent huge pages (needs THP set to madvise or always)
+//   HugePages::Reserved     MAP_HUGETLB, from the pool the admin reserved in /proc/sys/vm/nr_hugepages.
+//                           If the pool is empty it falls back to Transparent
+//   HugePages::None         plain mapping with normal pages (the NUMA policy still applies)
+// and then, if a NumaPolicy is set, mbind puts its pages on the given nodes:
+//   NumaPolicy::Interleave  round robin over the nodes, page by page, good for data every thread reads
+//   NumaPolicy::Bind        only the given nodes, good for data one socket works on
+// Everything below threshold goes to upstream (the normal heap by default).
+// Where something isnt supported (not Linux, no NUMA, THP off) that step is just skipped.
+//
+// Thread safe as long as upstream is (the stats are the only shared state and they are atomic).
+
+enum class HugePages {
+    None,
+    Transparent,
+    Reserved,
+};
+
+enum class NumaPolicy {
+    Default,
+    Interleave,
+    Bind,
+};
+
+class HugePageResource : public std::pmr::memory_resource {
+public:
+    static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+    struct Options {
+        size_t threshold = 64 * 1024 * 1024;
+        HugePages hugePages = HugePages::Transparent;
+        NumaPolicy numa = NumaPolicy::Default;
+        // node ids for Interleave / Bind, empty means every node
+        std::vector<int> nodes = {};
+    };
+
+    struct Stats {
+        size_t mappings = 0;          // allocations that were mmapped
+        size_t reservedMappings = 0;  // of those, how many got MAP_HUGETLB pages
+        size_t reservedFallbacks = 0; // MAP_HUGETLB failed, went Transparent instead
+        size_t madviseFailures = 0;   // MADV_HUGEPAGE refused (THP not available)
+        size_t mbindFailures = 0;     // no NUMA support, or a node that doesnt exist
+    };
+
+    HugePageResource(): HugePageResource(Options{}) {}
+
+    explicit HugePageResource(Options options, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : mOptions(std::move(options)), mUpstream(upstream) {}
+
+    HugePageResource(const HugePageResource&) = delete;
+    HugePageResource& operator=(const HugePageResource&) = delete;
+
+    const Options& options() const {
+        return mOptions;
+    }
+
+    Stats stats() const {
+        return {load(mStats.mappings), load(mStats.reservedMappings), load(mStats.reservedFallbacks),
+                load(mStats.madviseFailures), load(mStats.mbindFailures)};
+    }
+
+    // bytes that a mapping of bytes really takes (whole huge pages)
+    static size_t mappedSize(size_t bytes) {
+        return (bytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+#if defined(__linux__)
+        if (bytes >= mOptions.threshold && alignment <= kHugePageSize) {
+            void* p = map(mappedSize(bytes));
+            bump(mStats.mappings);
+            return p;
+        }
+#endif
+        return mUpstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+#if defined(__linux__)
+        if (bytes >= mOptions.threshold && alignment <= kHugePageSize) {
+            ::munmap(p, mappedSize(bytes));
+            return;
+        }
+#endif
+        mUpstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    // stats are plain counters bumped through atomic_ref, like Hashmap's
+    static void bump(size_t& counter) {
+        std::atomic_ref<size_t>(counter).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static size_t load(size_t& counter) {
+        return std::atomic_ref<size_t>(counter).load(std::memory_order_relaxed);
+    }
+
+#if defined(__linux__)
+    void* map(size_t size) {
+        if (mOptions.hugePages == HugePages::Reserved) {
+            void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                bump(mStats.reservedMappings);
+                applyNuma(p, size);
+                return p;
+            }
+            bump(mStats.reservedFallbacks);
+        }
+        void* p = mapAligned(size);
+        if (mOptions.hugePages != HugePages::None && ::madvise(p, size, MADV_HUGEPAGE) != 0) {
+            bump(mStats.madviseFailures);
+        }
+        applyNuma(p, size);
+        return p;
+    }
+
+    // THP can only use a huge page for a 2MB aligned 2MB range, mmap only promises 4K alignment.
+    // So map 2MB extra and unmap whatever sticks out on either side of the aligned part
+    static void* mapAligned(size_t size) {
+        size_t padded = size + kHugePageSize;
+        void* raw = ::mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        auto start = reinterpret_cast<uintptr_t>(raw);
+        uintptr_t aligned = (start + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+        if (aligned > start) {
+            ::munmap(raw, aligned - start);
+        }
+        size_t tail = start + padded - (aligned + size);
+        if (tail > 0) {
+            ::munmap(reinterpret_cast<void*>(aligned + size), tail);
+        }
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    // the pages dont exist yet (nothing touched them), mbind decides where they go once they do
+    void applyNuma(void* p, size_t size) {
+#if defined(SYS_mbind)
+        if (mOptions.numa == NumaPolicy::Default) {
+            return;
+        }
+        // from <numaif.h>, spelled out so theres no libnuma to link
+        constexpr int kMpolBind = 2;
+        constexpr int kMpolInterleave = 3;
+        constexpr size_t kMaxNodes = 1024;
+        constexpr size_t kBitsPerWord = 8 * sizeof(unsigned long);
+        unsigned long mask[kMaxNodes / kBitsPerWord] = {};
+        if (mOptions.nodes.empty()) {
+            // every node, the kernel ignores the ones that dont exist for interleave and refuses them for bind,
+            // so bind gets the nodes that are actually online
+            for (int node = 0; node < static_cast<int>(kMaxNodes); node++) {
+                if (mOptions.numa == NumaPolicy::Interleave || nodeOnline(node)) {
+                    mask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+                }
+            }
+        } else {
+            for (int node: mOptions.nodes) {
+                if (node >= 0 && static_cast<size_t>(node) < kMaxNodes) {
+                    mask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+                }
+            }
+        }
+        int mode = mOptions.numa == NumaPolicy::Bind ? kMpolBind : kMpolInterleave;
+        if (::syscall(SYS_mbind, p, size, mode, mask, kMaxNodes, 0) != 0) {
+            bump(mStats.mbindFailures);
+        }
+#else
+        (void)p;
+        (void)size;
+        if (mOptions.numa != NumaPolicy::Default) {
+            bump(mStats.mbindFailures);
+        }
+#endif
+    }
+
+    static bool nodeOnline(int node) {
+        std::string path = "/sys/devices/system/node/node" + std::to_string(node);
+        return ::access(path.c_str(), F_OK) == 0;
+    }
+#endif
+
+    Options mOptions;
+    std::pmr::memory_resource* mUpstream;
+    mutable Stats mStats;
+};
@@ -0,0 +1,92 @@
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "HugePageResource.hpp"
+#include "../../data-structures/vector/Vector.hpp"
+
+// Google Benchmark, link with -lbenchmark -lbenchmark_main -pthread
+// Random reads all over one big Vector<uint64_t>, with its buffer from the normal heap (4K pages) and from
+// HugePageResource (2MB pages). Every read is to a random cache line so both pay the cache miss, the
+// difference is the TLB miss (and page walk) that comes with it on 4K pages.
+// anon_huge_mb is how much of the process is backed by transparent huge pages, to check they really are there.
+
+namespace {
+
+constexpr size_t kMB = 1024 * 1024;
+constexpr size_t kReadsPerIteration = 1 << 20;
+
+// AnonHugePages of the whole process in MB, -1 where theres no /proc
+double anonHugeMB() {
+    std::ifstream in("/proc/self/smaps_rollup");
+    std::string key;
+    while (in >> key) {
+        if (key == "AnonHugePages:") {
+            double kb = 0;
+            in >> kb;
+            return kb / 1024;
+        }
+    }
+    return -1;
+}
+
+template <typename Vec>
+void fill(Vec& vec, size_t count) {
+    vec.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        vec.push_back(i * 0x9e3779b97f4a7c15ull);
+    }
+}
+
+// size is a power of two, the next index is a xorshift of the last one so the loads cant be prefetched
+// but also dont need an index array that would take cache space of its own
+template <typename Vec>
+void randomReads(benchmark::State& state, Vec& vec) {
+    const uint64_t* data = vec.data();
+    uint64_t mask = vec.size() - 1;
+    uint64_t x = 88172645463325252ull;
+    uint64_t sum = 0;
+    for (auto _: state) {
+        for (size_t i = 0; i < kReadsPerIteration; i++) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            sum += data[(x ^ sum) & mask];
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * kReadsPerIteration);
+    state.SetBytesProcessed(state.iterations() * kReadsPerIteration * sizeof(uint64_t));
+}
+
+} // namespace
+
+static void BM_RandomReadHeap(benchmark::State& state) {
+    Vector<uint64_t> vec;
+    fill(vec, state.range(0) * kMB / sizeof(uint64_t));
+    state.counters["anon_huge_mb"] = anonHugeMB();
+    randomReads(state, vec);
+}
+
+static void BM_RandomReadHugePages(benchmark::State& state) {
+    HugePageResource resource;
+    Vector<uint64_t> vec(&resource);
+    fill(vec, state.range(0) * kMB / sizeof(uint64_t));
+    state.counters["anon_huge_mb"] = anonHugeMB();
+    randomReads(state, vec);
+}
+
+static void BM_RandomReadHugePagesInterleaved(benchmark::State& state) {
+    HugePageResource resource({.numa = NumaPolicy::Interleave});
+    Vector<uint64_t> vec(&resource);
+    fill(vec, state.range(0) * kMB / sizeof(uint64_t));
+    state.counters["anon_huge_mb"] = anonHugeMB();
+    randomReads(state, vec);
+}
+
+// buffer size in MB. 4 is under the default threshold so both are on the heap (and both fit the TLB anyway),
+// 256 and 1024 are way past what the TLB covers with 4K pages
+BENCHMARK(BM_RandomReadHeap)->Arg(4)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RandomReadHugePages)->Arg(4)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RandomReadHugePagesInterleaved)->Arg(1024)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include "HugePageResource.hpp"
+#include "../arena/MonotonicArena.hpp"
+#include "../../data-structures/vector/Vector.hpp"
+
+namespace {
+
+constexpr size_t kMB = 1024 * 1024;
+
+bool hugePageAligned(const void* p) {
+    return reinterpret_cast<uintptr_t>(p) % HugePageResource::kHugePageSize == 0;
+}
+
+// "[madvise]" / "[always]" -> MADV_HUGEPAGE works here
+bool transparentHugePagesAvailable() {
+    std::ifstream in("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string line;
+    std::getline(in, line);
+    return line.find("[never]") == std::string::npos && !line.empty();
+}
+
+} // namespace
+
+TEST(HugePageResourceTest, SmallAllocationsGoUpstream) {
+    MonotonicArena upstream;
+    HugePageResource resource({.threshold = 4 * kMB}, &upstream);
+    void* p = resource.allocate(1024, 8);
+    EXPECT_EQ(upstream.stats().allocations, 1);
+    EXPECT_EQ(resource.stats().mappings, 0);
+    resource.deallocate(p, 1024, 8);
+}
+
+TEST(HugePageResourceTest, BigAllocationsAreAlignedMappings) {
+    HugePageResource resource({.threshold = 4 * kMB});
+    size_t bytes = 5 * kMB + 123;
+    auto* p = static_cast<unsigned char*>(resource.allocate(bytes, 64));
+    EXPECT_TRUE(hugePageAligned(p));
+    EXPECT_EQ(HugePageResource::mappedSize(bytes), 6 * kMB);
+    // every page is there and writable, including the last byte of the rounded up mapping
+    std::memset(p, 0xab, HugePageResource::mappedSize(bytes));
+    EXPECT_EQ(p[bytes - 1], 0xab);
+    resource.deallocate(p, bytes, 64);
+
+    auto stats = resource.stats();
+    EXPECT_EQ(stats.mappings, 1);
+    if (transparentHugePagesAvailable()) {
+        EXPECT_EQ(stats.madviseFailures, 0);
+    }
+}
+
+TEST(HugePageResourceTest, VectorBufferLivesInTheMapping) {
+    HugePageResource resource({.threshold = 4 * kMB});
+    Vector<uint64_t> vec(&resource);
+    // the buffers up to 256K elements (2MB) come from the heap, the 512K (4MB) and 1M ones are mapped
+    for (uint64_t i = 0; i < kMB; i++) {
+        vec.push_back(i);
+    }
+    EXPECT_TRUE(hugePageAligned(vec.data()));
+    EXPECT_EQ(resource.stats().mappings, 2);
+    EXPECT_EQ(vec[kMB - 1], kMB - 1);
+
+    // growing again maps a new buffer and unmaps the old one
+    vec.reserve(2 * kMB);
+    EXPECT_TRUE(hugePageAligned(vec.data()));
+    EXPECT_EQ(resource.stats().mappings, 3);
+    EXPECT_EQ(vec[12345], 12345);
+}
+
+TEST(HugePageResourceTest, ReservedFallsBackWhenThePoolIsEmpty) {
+    HugePageResource resource({.threshold = 2 * kMB, .hugePages = HugePages::Reserved});
+    auto* p = static_cast<char*>(resource.allocate(4 * kMB, 8));
+    std::memset(p, 1, 4 * kMB);
+    auto stats = resource.stats();
+    // which one depends on /proc/sys/vm/nr_hugepages, but its always one of them
+    EXPECT_EQ(stats.reservedMappings + stats.reservedFallbacks, 1);
+    EXPECT_TRUE(hugePageAligned(p));
+    resource.deallocate(p, 4 * kMB, 8);
+}
+
+TEST(HugePageResourceTest, NumaPoliciesNeverBreakTheAllocation) {
+    bool haveNode0 = std::ifstream("/sys/devices/system/node/node0/cpulist").good();
+    for (NumaPolicy policy: {NumaPolicy::Interleave, NumaPolicy::Bind}) {
+        HugePageResource resource({.threshold = 2 * kMB, .numa = policy});
+        auto* p = static_cast<char*>(resource.allocate(4 * kMB, 8));
+        std::memset(p, 2, 4 * kMB);
+        resource.deallocate(p, 4 * kMB, 8);
+        if (haveNode0) {
+            EXPECT_EQ(resource.stats().mbindFailures, 0);
+        }
+    }
+
+    // a node that doesnt exist: mbind refuses, the memory is still fine
+    HugePageResource bogus({.threshold = 2 * kMB, .numa = NumaPolicy::Bind, .nodes = {1000}});
+    auto* p = static_cast<char*>(bogus.allocate(4 * kMB, 8));
+    std::memset(p, 3, 4 * kMB);
+    bogus.deallocate(p, 4 * kMB, 8);
+    EXPECT_EQ(bogus.stats().mbindFailures, 1);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include "../ResourceAllocator.hpp"
+
+// Not thread safe (same as the containers you would plug it into)
+
+// NodePool hands out small fixed size blocks carved out of big contiguous chunks.
+// Node based containers (std::list inside Hashmap, linked lists, trees) do one tiny allocation per element,
+// and going to malloc for each one is slow (and under a lot of threads contends inside malloc)
+// and scatters the nodes all over the heap.
+//
+// Blocks are grouped in size classes of 16 bytes (16, 32, ... 256). Each class has a free list:
+//   allocate   -> pop the free list, or bump a pointer through the current chunk, or grab a new chunk
+//   deallocate -> push the block onto its class's free list so the next allocate of that size reuses it
+// Chunks are only given back to the system when the pool is destroyed, so the pool has to outlive
+// everything allocated from it.
+// Anything bigger than kMaxBlock (eg a Hashmap's bucket array) goes straight to ::operator new.
+
+class NodePool {
+public:
+    static constexpr size_t kGranularity = 16;
+    static constexpr size_t kMaxBlock = 256;
+    static constexpr size_t kNumClasses = kMaxBlock / kGranularity;
+
+    struct Stats {
+        size_t chunksAllocated = 0;   // calls to ::operator new for chunks
+        size_t bytesReserved = 0;     // total size of those chunks
+        size_t blocksFromChunk = 0;   // blocks carved out of fresh chunk memory
+        size_t blocksRecycled = 0;    // blocks handed out again from a free list
+        size_t blocksFreed = 0;
+        size_t largeAllocations = 0;  // bigger than kMaxBlock, passed through to ::operator new
+    };
+
+    explicit NodePool(size_t chunkSize = 64 * 1024): mChunkSize(chunkSize) {}
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    ~NodePool() {
+        while (mChunks) {
+            Chunk* next = mChunks->next;
+            ::operator delete(mChunks);
+            mChunks = next;
+        }
+    }
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        if (bytes > kMaxBlock || alignment > kGranularity) {
+            mStats.largeAllocations++;
+            return ::operator new(bytes, std::align_val_t{alignment});
+        }
+        size_t cls = sizeClass(bytes);
+        if (FreeBlock* block = mFreeLists[cls]) {
+            mFreeLists[cls] = block->next;
+            mStats.blocksRecycled++;
+            return block;
+        }
+        size_t blockSize = (cls + 1) * kGranularity;
+        if (mCursor + blockSize > mEnd) {
+            newChunk();
+        }
+        void* result = mCursor;
+        mCursor += blockSize;
+        mStats.blocksFromChunk++;
+        return result;
+    }
+
+    void deallocate(void* p, size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        if (bytes > kMaxBlock || alignment > kGranularity) {
+            ::operator delete(p, std::align_val_t{alignment});
+            return;
+        }
+        // the freed block itself stores the free list link, so recycling costs no extra memory
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        size_t cls = sizeClass(bytes);
+        block->next = mFreeLists[cls];
+        mFreeLists[cls] = block;
+        mStats.blocksFreed++;
+    }
+
+    const Stats& stats() const {
+        return mStats;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    // chunks are kept in a singly linked list so the destructor can free them, the header sits at the front
+    struct alignas(kGranularity) Chunk {
+        Chunk* next;
+    };
+
+    static size_t sizeClass(size_t bytes) {
+        return bytes == 0 ? 0 : (bytes - 1) / kGranularity;
+    }
+
+    void newChunk() {
+        // the tail of the old chunk (smaller than one block) just gets wasted
+        Chunk* chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + mChunkSize));
+        chunk->next = mChunks;
+        mChunks = chunk;
+        mCursor = reinterpret_cast<char*>(chunk + 1);
+        mEnd = mCursor + mChunkSize;
+        mStats.chunksAllocated++;
+        mStats.bytesReserved += mChunkSize;
+    }
+
+    size_t mChunkSize;
+    Chunk* mChunks = nullptr;
+    char* mCursor = nullptr;
+    char* mEnd = nullptr;
+    FreeBlock* mFreeLists[kNumClasses] = {};
+    Stats mStats;
+};
+
+// NodePool as the Allocator of std containers and Hashmap (see ResourceAllocator.hpp)
+//
+//   NodePool pool;
+//   using Alloc = PoolAllocator<std::pair<const int, int>>;
+//   Hashmap<int, int, std::hash<int>, std::equal_to<int>, Alloc> map{Alloc{&pool}};
+template <typename T>
+using PoolAllocator = ResourceAllocator<T, NodePool>;
@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+#include "PoolAllocator.hpp"
+#include "../../data-structures/hashmap/Hashmap.hpp"
+
+// Google Benchmark, link with -lbenchmark -lbenchmark_main -pthread
+// Counts every call to the global operator new, so the numbers show how many trips to malloc each version makes.
+
+namespace {
+size_t gHeapAllocations = 0;
+}
+
+// our replacement operator new is malloc underneath, gcc cant see that and warns about free() below
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(size_t size) {
+    gHeapAllocations++;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    gHeapAllocations++;
+    size_t alignment = static_cast<size_t>(align);
+    if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+
+using Value = std::pair<const uint64_t, uint64_t>;
+using DefaultMap = Hashmap<uint64_t, uint64_t>;
+using PooledMap = Hashmap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, PoolAllocator<Value>>;
+
+std::vector<uint64_t> randomKeys(size_t n) {
+    std::mt19937_64 rng(1);
+    std::vector<uint64_t> keys(n);
+    for (auto& k: keys) {
+        k = rng();
+    }
+    return keys;
+}
+
+// insert n keys, then keep erasing one and inserting another (the allocation heavy steady state)
+template <typename Map>
+void churn(Map& map, const std::vector<uint64_t>& keys, size_t ops) {
+    for (uint64_t k: keys) {
+        map[k] = k;
+    }
+    for (size_t i = 0; i < ops; i++) {
+        uint64_t k = keys[i % keys.size()];
+        map.erase(k);
+        map[k ^ 1] = i;
+        map.erase(k ^ 1);
+        map[k] = i;
+    }
+}
+
+} // namespace
+
+static void BM_ChurnDefaultAllocator(benchmark::State& state) {
+    auto keys = randomKeys(state.range(0));
+    size_t allocations = 0;
+    for (auto _: state) {
+        size_t before = gHeapAllocations;
+        DefaultMap map;
+        churn(map, keys, keys.size());
+        allocations += gHeapAllocations - before;
+    }
+    state.counters["heap_allocs_per_iter"] = static_cast<double>(allocations) / state.iterations();
+    state.SetItemsProcessed(state.iterations() * keys.size() * 5);
+}
+
+static void BM_ChurnPoolAllocator(benchmark::State& state) {
+    auto keys = randomKeys(state.range(0));
+    size_t allocations = 0;
+    for (auto _: state) {
+        size_t before = gHeapAllocations;
+        NodePool pool;
+        PooledMap map{PoolAllocator<Value>(&pool)};
+        churn(map, keys, keys.size());
+        allocations += gHeapAllocations - before;
+    }
+    state.counters["heap_allocs_per_iter"] = static_cast<double>(allocations) / state.iterations();
+    state.SetItemsProcessed(state.iterations() * keys.size() * 5);
+}
+
+BENCHMARK(BM_ChurnDefaultAllocator)->Arg(1 << 12)->Arg(1 << 18)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ChurnPoolAllocator)->Arg(1 << 12)->Arg(1 << 18)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <list>
+#include <string>
+#include "PoolAllocator.hpp"
+#include "../../data-structures/hashmap/Hashmap.hpp"
+
+TEST(NodePoolTest, RecyclesFreedBlocks) {
+    NodePool pool(1024);
+    void* a = pool.allocate(24);
+    void* b = pool.allocate(24);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(pool.stats().chunksAllocated, 1);
+
+    pool.deallocate(a, 24);
+    // same size class comes straight back off the free list
+    void* c = pool.allocate(32);
+    EXPECT_EQ(c, a);
+    EXPECT_EQ(pool.stats().blocksRecycled, 1);
+    pool.deallocate(b, 24);
+    pool.deallocate(c, 32);
+}
+
+TEST(NodePoolTest, GrowsByChunksAndPassesLargeThrough) {
+    NodePool pool(1024);
+    for (int i = 0; i < 100; ++i) {
+        pool.allocate(64);
+    }
+    EXPECT_EQ(pool.stats().blocksFromChunk, 100);
+    EXPECT_EQ(pool.stats().chunksAllocated, 7); // 16 blocks of 64 per 1KB chunk
+
+    void* big = pool.allocate(4096);
+    EXPECT_EQ(pool.stats().largeAllocations, 1);
+    pool.deallocate(big, 4096);
+}
+
+TEST(PoolAllocatorTest, WorksWithStdList) {
+    NodePool pool;
+    std::list<int, PoolAllocator<int>> list{PoolAllocator<int>(&pool)};
+    for (int i = 0; i < 1000; ++i) {
+        list.push_back(i);
+    }
+    EXPECT_EQ(pool.stats().blocksFromChunk, 1000);
+    EXPECT_EQ(pool.stats().largeAllocations, 0);
+    list.clear();
+    EXPECT_EQ(pool.stats().blocksFreed, 1000);
+}
+
+TEST(PoolAllocatorTest, DefaultConstructedUsesGlobalHeap) {
+    PoolAllocator<int> alloc;
+    int* p = alloc.allocate(4);
+    p[3] = 7;
+    alloc.deallocate(p, 4);
+    EXPECT_EQ(alloc, PoolAllocator<long>());
+}
+
+TEST(PoolAllocatorTest, HashmapNodesComeFromThePool) {
+    using Alloc = PoolAllocator<std::pair<const int, std::string>>;
+    NodePool pool;
+    {
+        Hashmap<int, std::string, std::hash<int>, std::equal_to<int>, Alloc> map{Alloc(&pool)};
+        for (int i = 0; i < 1000; ++i) {
+            map[i] = std::to_string(i);
+        }
+        // one block per node (plus the first few bucket arrays, which are small enough for the pool too)
+        EXPECT_GE(pool.stats().blocksFromChunk, 1000);
+        EXPECT_EQ(map.get_allocator().resource(), &pool);
+
+        // erased nodes get reused by the next inserts instead of carving new ones
+        size_t carved = pool.stats().blocksFromChunk;
+        for (int i = 0; i < 500; ++i) {
+            map.erase(i);
+        }
+        for (int i = 1000; i < 1500; ++i) {
+            map[i] = "again";
+        }
+        EXPECT_EQ(pool.stats().blocksFromChunk, carved);
+        EXPECT_GE(pool.stats().blocksRecycled, 500);
+
+        Hashmap<int, std::string, std::hash<int>, std::equal_to<int>, Alloc> copy(map);
+        EXPECT_EQ(copy.size(), 1000);
+        EXPECT_EQ(copy.at(1499), "again");
+    }
+    // everything that was handed out came back
+    EXPECT_EQ(pool.stats().blocksFreed, pool.stats().blocksFromChunk + pool.stats().blocksRecycled);
+}
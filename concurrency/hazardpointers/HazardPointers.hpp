@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Hazard pointers: safe memory reclamation for lock-free data structures (Maged Michael's scheme, the same
+// shape as C++26's std::hazard_pointer).
+//
+// The problem: a lock-free structure unlinks a node with a CAS, but another thread may have loaded a pointer
+// to that node just before and still be about to read it. Deleting it straight away is a use after free, and
+// reusing the memory gives the ABA problem (a CAS succeeds because a new node landed on the old address).
+//
+// The fix: before a thread dereferences a shared node it publishes the pointer in a hazard pointer slot that
+// every thread can see. A node that has been unlinked isnt deleted, its retired: put on a list. Every so often
+// a thread scans all published hazard pointers and deletes the retired nodes nobody has published, the rest
+// stay on the list for the next scan.
+//
+//   struct Node : HazardPointerObjBase<Node> { ... };
+//
+//   HazardPointer hp;                      // takes a slot, gives it back in the destructor
+//   Node* n = hp.protect(mHead);           // n cant be freed until hp is reset or destroyed
+//   ... unlink n with a CAS ...
+//   n->retire();                           // deleted once no hazard pointer holds it anymore
+//
+// The slots live in a HazardPointerDomain. Theres a process wide one (global()) that everything uses by
+// default; a structure can use its own domain so its scans only look at its own slots.
+// Slots are never freed while the domain lives, a released one is just marked free and reused, so a scan can
+// walk the list without any lock. The retired list is one lock-free stack per domain, a scan takes the whole
+// stack with one exchange, so any thread can retire and any thread can end up doing the deleting.
+// Retiring is cheap (one CAS), the deletes happen in batches of at least kMinRetireBatch, so the cost of a
+// scan (reading every slot) is spread over many nodes.
+
+class HazardPointerDomain;
+
+// what the retired list links together. Derive through HazardPointerObjBase, not from this
+class HazardPointerRetired {
+private:
+    friend class HazardPointerDomain;
+    template <typename T>
+    friend class HazardPointerObjBase;
+
+    HazardPointerRetired* mNextRetired = nullptr;
+    void (*mReclaim)(HazardPointerRetired*) = nullptr;
+};
+
+class HazardPointerDomain {
+public:
+    static constexpr size_t kMinRetireBatch = 128;
+
+    HazardPointerDomain() = default;
+    HazardPointerDomain(const HazardPointerDomain&) = delete;
+    HazardPointerDomain& operator=(const HazardPointerDomain&) = delete;
+
+    // nobody can be using the domain anymore by now, everything retired goes
+    ~HazardPointerDomain() {
+        HazardPointerRetired* node = mRetired.exchange(nullptr, std::memory_order_acquire);
+        while (node) {
+            HazardPointerRetired* next = node->mNextRetired;
+            node->mReclaim(node);
+            node = next;
+        }
+        Record* record = mRecords.load(std::memory_order_acquire);
+        while (record) {
+            Record* next = record->next;
+            delete record;
+            record = next;
+        }
+    }
+
+    static HazardPointerDomain& global() {
+        static HazardPointerDomain domain;
+        return domain;
+    }
+
+    // deletes every retired node that no hazard pointer holds right now
+    void reclaim() {
+        HazardPointerRetired* node = mRetired.exchange(nullptr, std::memory_order_acquire);
+        if (!node) {
+            return;
+        }
+        // the nodes were unlinked before they were retired. The fence makes sure a reader that published one
+        // of them before it was unlinked shows up in the scan below (the reader does store, then reload)
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        std::vector<const void*> hazards;
+        for (Record* record = mRecords.load(std::memory_order_acquire); record; record = record->next) {
+            if (const void* p = record->pointer.load(std::memory_order_seq_cst)) {
+                hazards.push_back(p);
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+
+        HazardPointerRetired* keep = nullptr;
+        HazardPointerRetired* keepTail = nullptr;
+        size_t freed = 0;
+        while (node) {
+            HazardPointerRetired* next = node->mNextRetired;
+            if (std::binary_search(hazards.begin(), hazards.end(), static_cast<const void*>(node))) {
+                node->mNextRetired = keep;
+                keep = node;
+                keepTail = keepTail ? keepTail : node;
+            } else {
+                node->mReclaim(node);
+                freed++;
+            }
+            node = next;
+        }
+        mRetiredCount.fetch_sub(freed, std::memory_order_relaxed);
+        if (keep) {
+            pushRetired(keep, keepTail);
+        }
+    }
+
+    // retired nodes that havent been deleted yet (a snapshot)
+    size_t retired_count() const {
+        return mRetiredCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend class HazardPointer;
+    template <typename T>
+    friend class HazardPointerObjBase;
+
+    struct Record {
+        std::atomic<const void*> pointer{nullptr};
+        std::atomic<bool> active{true};
+        Record* next = nullptr;
+    };
+
+    // each thread keeps a few released slots of the global domain to itself, taking one from the shared list
+    // costs an exchange per slot it walks past. Only the global domain, it outlives every thread's cache;
+    // a thread's cache of a shorter lived domain could outlive the domain
+    struct ThreadCache {
+        static constexpr size_t kSize = 4;
+
+        ~ThreadCache() {
+            for (size_t i = 0; i < count; i++) {
+                records[i]->active.store(false, std::memory_order_release);
+            }
+        }
+
+        Record* records[kSize];
+        size_t count = 0;
+    };
+
+    static ThreadCache& threadCache() {
+        thread_local ThreadCache cache;
+        return cache;
+    }
+
+    bool isGlobal() const {
+        return this == &global();
+    }
+
+    Record* acquireRecord() {
+        if (isGlobal()) {
+            ThreadCache& cache = threadCache();
+            if (cache.count > 0) {
+                return cache.records[--cache.count];
+            }
+        }
+        for (Record* record = mRecords.load(std::memory_order_acquire); record; record = record->next) {
+            if (!record->active.load(std::memory_order_relaxed) &&
+                !record->active.exchange(true, std::memory_order_acquire)) {
+                return record;
+            }
+        }
+        // all taken, add one at the front. Records are only ever added, so next pointers never change after
+        Record* record = new Record;
+        Record* head = mRecords.load(std::memory_order_relaxed);
+        do {
+            record->next = head;
+        } while (!mRecords.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+        mRecordCount.fetch_add(1, std::memory_order_relaxed);
+        return record;
+    }
+
+    void releaseRecord(Record* record) {
+        record->pointer.store(nullptr, std::memory_order_release);
+        if (isGlobal()) {
+            ThreadCache& cache = threadCache();
+            if (cache.count < ThreadCache::kSize) {
+                // stays active, so no other thread takes it
+                cache.records[cache.count++] = record;
+                return;
+            }
+        }
+        record->active.store(false, std::memory_order_release);
+    }
+
+    void retire(HazardPointerRetired* node) {
+        pushRetired(node, node);
+        size_t count = mRetiredCount.fetch_add(1, std::memory_order_relaxed) + 1;
+        // more than twice the slots means at least half of a scan's nodes get freed
+        size_t batch = std::max(kMinRetireBatch, 2 * mRecordCount.load(std::memory_order_relaxed));
+        if (count >= batch) {
+            reclaim();
+        }
+    }
+
+    void pushRetired(HazardPointerRetired* first, HazardPointerRetired* last) {
+        HazardPointerRetired* head = mRetired.load(std::memory_order_relaxed);
+        do {
+            last->mNextRetired = head;
+        } while (!mRetired.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    std::atomic<Record*> mRecords{nullptr};
+    std::atomic<size_t> mRecordCount{0};
+    std::atomic<HazardPointerRetired*> mRetired{nullptr};
+    std::atomic<size_t> mRetiredCount{0};
+};
+
+// T derives from HazardPointerObjBase<T> to be retirable, retire() deletes it (delete, so T has to come from
+// new) once no hazard pointer holds it
+template <typename T>
+class HazardPointerObjBase : public HazardPointerRetired {
+public:
+    void retire(HazardPointerDomain& domain = HazardPointerDomain::global()) {
+        mReclaim = [](HazardPointerRetired* node) {
+            delete static_cast<T*>(node);
+        };
+        domain.retire(this);
+    }
+
+protected:
+    HazardPointerObjBase() = default;
+    ~HazardPointerObjBase() = default;
+};
+
+// one hazard pointer slot, held for as long as this object lives. Cheap to keep around for a whole operation,
+// not meant to be shared between threads
+class HazardPointer {
+public:
+    explicit HazardPointer(HazardPointerDomain& domain = HazardPointerDomain::global())
+        : mDomain(domain), mRecord(domain.acquireRecord()) {}
+
+    HazardPointer(const HazardPointer&) = delete;
+    HazardPointer& operator=(const HazardPointer&) = delete;
+
+    ~HazardPointer() {
+        mDomain.releaseRecord(mRecord);
+    }
+
+    // loads src and publishes it, returns a pointer that stays valid until the next protect / reset
+    template <typename T>
+    T* protect(const std::atomic<T*>& src) {
+        T* p = src.load(std::memory_order_relaxed);
+        while (!try_protect(p, src)) {
+        }
+        return p;
+    }
+
+    // publishes p (which was loaded from src) and checks src still points there. If it doesnt, p may already
+    // be retired: p is set to the new value and its false
+    template <typename T>
+    bool try_protect(T*& p, const std::atomic<T*>& src) {
+        T* published = p;
+        mRecord->pointer.store(published, std::memory_order_seq_cst);
+        // still reachable from src after the store is visible means it hadnt been unlinked (and so retired)
+        // before a reclaim could see the store
+        p = src.load(std::memory_order_seq_cst);
+        if (p != published) {
+            mRecord->pointer.store(nullptr, std::memory_order_release);
+            return false;
+        }
+        return true;
+    }
+
+    void reset_protection() {
+        mRecord->pointer.store(nullptr, std::memory_order_release);
+    }
+
+private:
+    HazardPointerDomain& mDomain;
+    HazardPointerDomain::Record* mRecord;
+};
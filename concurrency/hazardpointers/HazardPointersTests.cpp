@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "HazardPointers.hpp"
+
+namespace {
+
+struct Counted : HazardPointerObjBase<Counted> {
+    explicit Counted(uint64_t v, std::atomic<int>* alive): value(v), alive(alive) {
+        alive->fetch_add(1, std::memory_order_relaxed);
+    }
+    ~Counted() {
+        // a scan that deletes twice would catch this
+        EXPECT_NE(value, kFreed);
+        value = kFreed;
+        alive->fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    static constexpr uint64_t kFreed = ~uint64_t(0);
+    uint64_t value;
+    std::atomic<int>* alive;
+};
+
+} // namespace
+
+TEST(HazardPointersTest, ProtectedNodesSurviveReclaim) {
+    std::atomic<int> alive = 0;
+    HazardPointerDomain domain;
+    std::atomic<Counted*> shared = new Counted(1, &alive);
+
+    HazardPointer hp(domain);
+    Counted* protectedNode = hp.protect(shared);
+    EXPECT_EQ(protectedNode->value, 1);
+
+    // unlinked and retired while hp still holds it
+    shared.store(new Counted(2, &alive));
+    protectedNode->retire(domain);
+    domain.reclaim();
+    EXPECT_EQ(alive, 2);
+    EXPECT_EQ(domain.retired_count(), 1);
+    EXPECT_EQ(protectedNode->value, 1);
+
+    hp.reset_protection();
+    domain.reclaim();
+    EXPECT_EQ(alive, 1);
+    EXPECT_EQ(domain.retired_count(), 0);
+    delete shared.load();
+}
+
+TEST(HazardPointersTest, SlotsAreReusedAndBatchesFreeThemselves) {
+    std::atomic<int> alive = 0;
+    HazardPointerDomain domain;
+    {
+        HazardPointer a(domain);
+        HazardPointer b(domain);
+    }
+    // the two slots from before are free again, nothing new gets added
+    for (int i = 0; i < 100; ++i) {
+        HazardPointer a(domain);
+        HazardPointer b(domain);
+    }
+
+    // nobody protecting anything: retiring a full batch deletes it without an explicit reclaim
+    for (size_t i = 0; i < HazardPointerDomain::kMinRetireBatch; ++i) {
+        (new Counted(i, &alive))->retire(domain);
+    }
+    EXPECT_EQ(alive, 0);
+
+    // whatever is left when the domain goes is deleted too
+    {
+        HazardPointerDomain shortLived;
+        (new Counted(0, &alive))->retire(shortLived);
+        EXPECT_EQ(alive, 1);
+    }
+    EXPECT_EQ(alive, 0);
+}
+
+TEST(HazardPointersTest, TryProtectNoticesTheSourceMoved) {
+    std::atomic<int> alive = 0;
+    HazardPointerDomain domain;
+    Counted* first = new Counted(1, &alive);
+    Counted* second = new Counted(2, &alive);
+    std::atomic<Counted*> shared = second;
+
+    HazardPointer hp(domain);
+    Counted* p = first;
+    EXPECT_FALSE(hp.try_protect(p, shared));
+    EXPECT_EQ(p, second);
+    EXPECT_TRUE(hp.try_protect(p, shared));
+    delete first;
+    delete second;
+}
+
+TEST(HazardPointersTest, ReadersAndWriterHammerOnePointer) {
+    // the writer keeps swapping the object out and retiring the old one, readers keep reading it. Under
+    // ASan a node freed while a reader still had it shows up as a use after free
+    std::atomic<int> alive = 0;
+    HazardPointerDomain domain;
+    std::atomic<Counted*> shared = new Counted(0, &alive);
+    std::atomic<bool> stop = false;
+    constexpr uint64_t kSwaps = 200000;
+
+    std::vector<std::thread> readers;
+    std::atomic<bool> sawTorn = false;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            HazardPointer hp(domain);
+            uint64_t last = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                Counted* node = hp.protect(shared);
+                uint64_t value = node->value;
+                // values only go up, a freed node would read kFreed
+                if (value == Counted::kFreed || value < last) {
+                    sawTorn = true;
+                }
+                last = value;
+                hp.reset_protection();
+            }
+        });
+    }
+    for (uint64_t i = 1; i <= kSwaps; ++i) {
+        Counted* old = shared.exchange(new Counted(i, &alive));
+        old->retire(domain);
+    }
+    stop = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+    EXPECT_FALSE(sawTorn);
+    domain.reclaim();
+    EXPECT_EQ(alive, 1);
+    delete shared.load();
+}
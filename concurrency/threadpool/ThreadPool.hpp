@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../../data-structures/threadsafequeue/ThreadSafeQueue.hpp"
+
+// Fixed set of worker threads that run tasks off one ThreadSafeQueue.
+// Starting a thread costs tens of microseconds, so code that splits work up many times (the parallel Vector
+// algorithms) keeps the threads around and just hands them tasks.
+//
+//   submit(f)             runs f on some worker, the future gets the result (or the exception)
+//   parallel_for(n, f)    calls f(0) .. f(n - 1) spread over the workers AND the calling thread, returns once
+//                         all of them are done. The indices are handed out one at a time from an atomic
+//                         counter, so a thread that finishes early just takes the next one (no thread sits
+//                         idle while another still has a queue of work). The caller working too means it is
+//                         safe to call from inside a pool task: if every worker is busy the caller just
+//                         does all the work itself instead of waiting on a worker that never comes.
+//
+// The destructor finishes the tasks already queued and then joins the workers.
+
+class ThreadPool {
+public:
+    // the calling thread joins in on parallel_for, so by default one worker fewer than there are cores
+    explicit ThreadPool(size_t numThreads = defaultThreads()) {
+        mWorkers.reserve(numThreads);
+        for (size_t i = 0; i < numThreads; i++) {
+            mWorkers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        // an empty function is the signal to stop, one per worker. The queue is FIFO so everything pushed
+        // before still runs first
+        for (size_t i = 0; i < mWorkers.size(); i++) {
+            mTasks.push(Task{});
+        }
+        for (auto& worker: mWorkers) {
+            worker.join();
+        }
+    }
+
+    // number of worker threads (not counting whoever calls parallel_for)
+    size_t size() const {
+        return mWorkers.size();
+    }
+
+    template <typename F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>&>> {
+        using R = std::invoke_result_t<std::decay_t<F>&>;
+        // std::function has to be copyable and packaged_task isnt, so it lives behind a shared_ptr
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> result = task->get_future();
+        mTasks.push([task] { (*task)(); });
+        return result;
+    }
+
+    // f(i) for every i in [0, count). If any call throws, the first exception is rethrown here once every
+    // index has been dealt with (the indices nobody had started yet are skipped)
+    template <typename F>
+    void parallel_for(size_t count, F&& f) {
+        if (count == 0) {
+            return;
+        }
+        if (count == 1 || mWorkers.empty()) {
+            for (size_t i = 0; i < count; i++) {
+                f(i);
+            }
+            return;
+        }
+        // shared, a helper task can still get popped after the caller has already returned
+        // (if the caller and the other workers finished everything first), it then finds no work and leaves
+        auto group = std::make_shared<Group>(count);
+        auto run = [group, &f] {
+            group->drain(f);
+        };
+        // f is only referenced by the helpers that actually get an index, and those all finish before we return
+        size_t helpers = std::min(mWorkers.size(), count - 1);
+        for (size_t i = 0; i < helpers; i++) {
+            mTasks.push(run);
+        }
+        group->drain(f);
+        group->wait();
+        if (group->error) {
+            std::rethrow_exception(group->error);
+        }
+    }
+
+    // one pool for the whole process, made the first time its asked for
+    static ThreadPool& global() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    static size_t defaultThreads() {
+        unsigned cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 0;
+    }
+
+private:
+    using Task = std::function<void()>;
+
+    // the shared state of one parallel_for
+    struct Group {
+        explicit Group(size_t count): count(count) {}
+
+        template <typename F>
+        void drain(F& f) {
+            for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count;
+                 i = next.fetch_add(1, std::memory_order_relaxed)) {
+                if (!failed.load(std::memory_order_relaxed)) {
+                    try {
+                        f(i);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(errorMtx);
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                        failed.store(true, std::memory_order_relaxed);
+                    }
+                }
+                // release: everything f(i) wrote is visible to whoever sees the count
+                if (done.fetch_add(1, std::memory_order_release) + 1 == count) {
+                    done.notify_all();
+                }
+            }
+        }
+
+        void wait() {
+            size_t seen = done.load(std::memory_order_acquire);
+            while (seen != count) {
+                done.wait(seen, std::memory_order_acquire);
+                seen = done.load(std::memory_order_acquire);
+            }
+        }
+
+        const size_t count;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::atomic<bool> failed{false};
+        std::mutex errorMtx;
+        std::exception_ptr error;
+    };
+
+    void workerLoop() {
+        while (true) {
+            Task task;
+            mTasks.wait_pop(task);
+            if (!task) {
+                return;
+            }
+            task();
+        }
+    }
+
+    ThreadSafeQueue<Task> mTasks;
+    std::vector<std::thread> mWorkers;
+};
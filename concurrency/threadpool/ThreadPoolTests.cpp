@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "ThreadPool.hpp"
+
+TEST(ThreadPoolTest, SubmitReturnsResultsAndExceptions) {
+    ThreadPool pool(2);
+    auto answer = pool.submit([] { return 42; });
+    auto boom = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+    EXPECT_EQ(answer.get(), 42);
+    EXPECT_THROW(boom.get(), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, ParallelForRunsEveryIndexOnce) {
+    ThreadPool pool(3);
+    std::vector<std::atomic<int>> hits(10000);
+    pool.parallel_for(hits.size(), [&](size_t i) { hits[i]++; });
+    for (auto& h: hits) {
+        EXPECT_EQ(h.load(), 1);
+    }
+}
+
+TEST(ThreadPoolTest, ParallelForUsesWorkersAndCaller) {
+    ThreadPool pool(3);
+    std::mutex mtx;
+    std::vector<std::thread::id> ids;
+    pool.parallel_for(64, [&](size_t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::lock_guard<std::mutex> lock(mtx);
+        if (std::find(ids.begin(), ids.end(), std::this_thread::get_id()) == ids.end()) {
+            ids.push_back(std::this_thread::get_id());
+        }
+    });
+    EXPECT_GT(ids.size(), 1);
+    EXPECT_LE(ids.size(), 4);
+}
+
+TEST(ThreadPoolTest, ParallelForRethrowsAfterEverythingStops) {
+    ThreadPool pool(3);
+    std::atomic<int> ran{0};
+    EXPECT_THROW(pool.parallel_for(1000, [&](size_t i) {
+        ran++;
+        if (i == 10) {
+            throw std::invalid_argument("bad index");
+        }
+    }), std::invalid_argument);
+    // the pool still works afterwards
+    std::atomic<int> after{0};
+    pool.parallel_for(100, [&](size_t) { after++; });
+    EXPECT_EQ(after.load(), 100);
+    EXPECT_LE(ran.load(), 1000);
+}
+
+TEST(ThreadPoolTest, NestedParallelForDoesntDeadlock) {
+    ThreadPool pool(2);
+    std::atomic<int> total{0};
+    pool.parallel_for(8, [&](size_t) {
+        pool.parallel_for(8, [&](size_t) { total++; });
+    });
+    EXPECT_EQ(total.load(), 64);
+}
+
+TEST(ThreadPoolTest, NoWorkersRunsOnTheCaller) {
+    ThreadPool pool(0);
+    std::thread::id caller = std::this_thread::get_id();
+    bool allOnCaller = true;
+    pool.parallel_for(10, [&](size_t) { allOnCaller &= std::this_thread::get_id() == caller; });
+    EXPECT_TRUE(allOnCaller);
+}
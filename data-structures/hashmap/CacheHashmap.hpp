@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include "Hashmap.hpp"
+
+// Not thread safe
+
+// Fixed capacity cache on top of Hashmap. Once it holds capacity entries, every put of a new key evicts one.
+//
+// The usual way is a Hashmap<K, list iterator> plus a separate std::list for the recency order, which is a
+// second allocation per entry and a second pointer chase on every hit. Here the recency links live inside
+// the Hashmap's own elements instead: each value is stored next to prev / next pointers to other elements,
+// so the order is an intrusive doubly linked list threaded through the hashmap's nodes.
+// That works because Hashmap nodes never move: growing splices the std::list nodes, it doesnt copy them.
+// The capacity is also reserved up front, so the table never even grows.
+//
+// CachePolicy::Lru   get moves the entry to the front, put evicts from the back. Exact LRU, but every hit
+//                    writes 4 pointers.
+// CachePolicy::Clock get only sets a referenced bit. To evict, a hand sweeps the entries in insertion order,
+//                    clearing referenced bits, and evicts the first entry that doesnt have one (second chance).
+//                    Hits are a single store and hit ratios are close to LRU.
+
+enum class CachePolicy {
+    Lru,
+    Clock,
+};
+
+template <typename K, typename V, CachePolicy Policy = CachePolicy::Lru, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class CacheHashmap {
+private:
+    struct Entry;
+    using Map = Hashmap<K, Entry, Hash, KeyEqual>;
+    using Node = std::pair<const K, Entry>;
+
+    struct Entry {
+        V value;
+        Node* prev = nullptr;
+        Node* next = nullptr;
+        bool referenced = false;
+    };
+
+public:
+    explicit CacheHashmap(size_t capacity): mCapacity(capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("CacheHashmap: capacity must be at least 1");
+        }
+        mMap.reserve(capacity);
+    }
+
+    // the links are raw pointers into mMap's nodes, a copy would point into the original
+    CacheHashmap(const CacheHashmap&) = delete;
+    CacheHashmap& operator=(const CacheHashmap&) = delete;
+
+    // moving the Hashmap moves the bucket array but not the nodes, so the links stay valid
+    CacheHashmap(CacheHashmap&& other) noexcept
+        : mMap(std::move(other.mMap)), mCapacity(other.mCapacity), mHead(std::exchange(other.mHead, nullptr)),
+          mTail(std::exchange(other.mTail, nullptr)), mHand(std::exchange(other.mHand, nullptr)),
+          mEvictions(other.mEvictions) {}
+
+    // pointer to the cached value (valid until that entry gets evicted or erased), or nullptr on a miss
+    // counts as a use of the entry
+    V* get(const K& key) {
+        auto it = mMap.find(key);
+        if (it == mMap.end()) {
+            return nullptr;
+        }
+        Node* node = &*it;
+        touch(node);
+        return &node->second.value;
+    }
+
+    // like get, but doesnt count as a use
+    const V* peek(const K& key) const {
+        auto it = mMap.find(key);
+        return it == mMap.end() ? nullptr : &it->second.value;
+    }
+
+    bool contains(const K& key) const {
+        return mMap.contains(key);
+    }
+
+    // inserts or overwrites (an overwrite counts as a use). true if the key was new
+    bool put(const K& key, V value) {
+        size_t hash = mMap.hash_function()(key);
+        auto it = mMap.find(key, hash);
+        if (it != mMap.end()) {
+            it->second.value = std::move(value);
+            touch(&*it);
+            return false;
+        }
+        if (mMap.size() == mCapacity) {
+            evict();
+        }
+        Node* node = &*mMap.insert({key, Entry{std::move(value)}}).first;
+        link(node);
+        return true;
+    }
+
+    bool erase(const K& key) {
+        auto it = mMap.find(key);
+        if (it == mMap.end()) {
+            return false;
+        }
+        unlink(&*it);
+        return mMap.erase(key);
+    }
+
+    size_t size() const {
+        return mMap.size();
+    }
+
+    size_t capacity() const {
+        return mCapacity;
+    }
+
+    // how many entries put has pushed out so far
+    size_t evictions() const {
+        return mEvictions;
+    }
+
+    // f(const K&, const V&) in recency order, most recently used first (Lru) or in hand order (Clock)
+    template <typename F>
+    void for_each(F&& f) const {
+        for (const Node* node = mHead; node; node = node->second.next) {
+            f(node->first, node->second.value);
+        }
+    }
+
+private:
+    // put a new node in the order: at the front for Lru, just behind the hand for Clock
+    // (so it is the last thing the hand reaches, a full sweep from now)
+    void link(Node* node) {
+        if constexpr (Policy == CachePolicy::Lru) {
+            insertBefore(node, mHead);
+        } else {
+            insertBefore(node, mHand);
+            if (!mHand) {
+                mHand = node;
+            }
+        }
+    }
+
+    void touch(Node* node) {
+        if constexpr (Policy == CachePolicy::Lru) {
+            if (node != mHead) {
+                unlink(node);
+                insertBefore(node, mHead);
+            }
+        } else {
+            node->second.referenced = true;
+        }
+    }
+
+    void evict() {
+        Node* victim;
+        if constexpr (Policy == CachePolicy::Lru) {
+            victim = mTail;
+        } else {
+            // terminates within one full sweep, by then every referenced bit has been cleared
+            while (mHand->second.referenced) {
+                mHand->second.referenced = false;
+                mHand = nextInRing(mHand);
+            }
+            victim = mHand;
+        }
+        unlink(victim);
+        mMap.erase(victim->first);
+        mEvictions++;
+    }
+
+    Node* nextInRing(Node* node) const {
+        return node->second.next ? node->second.next : mHead;
+    }
+
+    // before == nullptr appends at the back
+    void insertBefore(Node* node, Node* before) {
+        Entry& entry = node->second;
+        entry.next = before;
+        entry.prev = before ? before->second.prev : mTail;
+        if (entry.prev) {
+            entry.prev->second.next = node;
+        } else {
+            mHead = node;
+        }
+        if (before) {
+            before->second.prev = node;
+        } else {
+            mTail = node;
+        }
+    }
+
+    void unlink(Node* node) {
+        Entry& entry = node->second;
+        if (mHand == node) {
+            mHand = entry.next == nullptr && mHead == node ? nullptr : nextInRing(node);
+        }
+        if (entry.prev) {
+            entry.prev->second.next = entry.next;
+        } else {
+            mHead = entry.next;
+        }
+        if (entry.next) {
+            entry.next->second.prev = entry.prev;
+        } else {
+            mTail = entry.prev;
+        }
+        entry.prev = nullptr;
+        entry.next = nullptr;
+    }
+
+    Map mMap;
+    size_t mCapacity;
+    Node* mHead = nullptr;
+    Node* mTail = nullptr;
+    // Clock only, the next entry the hand looks at
+    Node* mHand = nullptr;
+    size_t mEvictions = 0;
+};
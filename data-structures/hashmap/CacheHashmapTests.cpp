@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <list>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "CacheHashmap.hpp"
+
+TEST(CacheHashmapTest, LruEvictsLeastRecentlyUsed) {
+    CacheHashmap<int, std::string> cache(3);
+    EXPECT_TRUE(cache.put(1, "one"));
+    EXPECT_TRUE(cache.put(2, "two"));
+    EXPECT_TRUE(cache.put(3, "three"));
+
+    // 1 becomes the most recently used, so 2 is the oldest now
+    ASSERT_NE(cache.get(1), nullptr);
+    EXPECT_TRUE(cache.put(4, "four"));
+    EXPECT_EQ(cache.size(), 3);
+    EXPECT_FALSE(cache.contains(2));
+    EXPECT_EQ(*cache.get(1), "one");
+    EXPECT_EQ(cache.evictions(), 1);
+
+    // overwriting counts as a use too
+    EXPECT_FALSE(cache.put(3, "THREE"));
+    cache.put(5, "five");
+    EXPECT_FALSE(cache.contains(4));
+    EXPECT_EQ(*cache.peek(3), "THREE");
+
+    std::vector<int> order;
+    cache.for_each([&](const int& key, const std::string&) { order.push_back(key); });
+    EXPECT_EQ(order, (std::vector<int>{5, 3, 1}));
+}
+
+TEST(CacheHashmapTest, ClockGivesReferencedEntriesASecondChance) {
+    CacheHashmap<int, int, CachePolicy::Clock> cache(3);
+    cache.put(1, 1);
+    cache.put(2, 2);
+    cache.put(3, 3);
+    cache.get(1);
+    cache.get(2);
+    // hand starts at 1: clears 1 and 2, evicts 3
+    cache.put(4, 4);
+    EXPECT_TRUE(cache.contains(1));
+    EXPECT_TRUE(cache.contains(2));
+    EXPECT_FALSE(cache.contains(3));
+    // nothing referenced anymore, hand is back around at 1
+    cache.put(5, 5);
+    EXPECT_FALSE(cache.contains(1));
+    EXPECT_EQ(cache.size(), 3);
+    EXPECT_EQ(cache.evictions(), 2);
+}
+
+TEST(CacheHashmapTest, EraseAndCapacityOne) {
+    CacheHashmap<int, int, CachePolicy::Clock> clock(1);
+    clock.put(1, 1);
+    EXPECT_TRUE(clock.erase(1));
+    EXPECT_FALSE(clock.erase(1));
+    clock.put(2, 2);
+    clock.put(3, 3);
+    EXPECT_EQ(clock.size(), 1);
+    EXPECT_EQ(*clock.get(3), 3);
+
+    CacheHashmap<int, int> lru(1);
+    lru.put(1, 1);
+    lru.put(2, 2);
+    EXPECT_FALSE(lru.contains(1));
+    EXPECT_EQ(*lru.get(2), 2);
+    EXPECT_THROW((CacheHashmap<int, int>(0)), std::invalid_argument);
+}
+
+// random gets / puts / erases against a plain hashmap + std::list LRU
+TEST(CacheHashmapTest, LruMatchesReferenceModel) {
+    CacheHashmap<int, int> cache(64);
+    std::list<int> order;
+    std::unordered_map<int, std::pair<int, std::list<int>::iterator>> reference;
+    std::mt19937 rng(7);
+
+    for (int i = 0; i < 100000; ++i) {
+        int key = static_cast<int>(rng() % 200);
+        switch (rng() % 4) {
+        case 0:
+        case 1: {
+            int* value = cache.get(key);
+            auto it = reference.find(key);
+            ASSERT_EQ(value != nullptr, it != reference.end());
+            if (value) {
+                EXPECT_EQ(*value, it->second.first);
+                order.splice(order.begin(), order, it->second.second);
+            }
+            break;
+        }
+        case 2: {
+            cache.put(key, i);
+            auto it = reference.find(key);
+            if (it != reference.end()) {
+                it->second.first = i;
+                order.splice(order.begin(), order, it->second.second);
+            } else {
+                if (reference.size() == 64) {
+                    reference.erase(order.back());
+                    order.pop_back();
+                }
+                order.push_front(key);
+                reference[key] = {i, order.begin()};
+            }
+            break;
+        }
+        default: {
+            auto it = reference.find(key);
+            EXPECT_EQ(cache.erase(key), it != reference.end());
+            if (it != reference.end()) {
+                order.erase(it->second.second);
+                reference.erase(it);
+            }
+            break;
+        }
+        }
+    }
+    EXPECT_EQ(cache.size(), reference.size());
+    std::vector<int> cacheOrder;
+    cache.for_each([&](const int& key, const int&) { cacheOrder.push_back(key); });
+    EXPECT_EQ(cacheOrder, std::vector<int>(order.begin(), order.end()));
+}
+
+TEST(CacheHashmapTest, MoveKeepsLinks) {
+    CacheHashmap<int, int> cache(10);
+    for (int i = 0; i < 20; ++i) {
+        cache.put(i, i);
+    }
+    CacheHashmap<int, int> moved(std::move(cache));
+    EXPECT_EQ(moved.size(), 10);
+    moved.put(100, 100);
+    EXPECT_FALSE(moved.contains(10));
+    EXPECT_EQ(*moved.get(19), 19);
+}
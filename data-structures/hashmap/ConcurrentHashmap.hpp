@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include "Hashmap.hpp"
+
+// Thread safe hashmap built out of N ordinary Hashmaps ("shards" / lock striping)
+//
+// Wrapping one Hashmap in one mutex means every thread queues up on that mutex, even if they touch
+// completely different keys. Here the key's hash picks a shard and only that shard gets locked,
+// so threads working on different shards never wait for each other.
+//
+// Each shard has a std::shared_mutex (reader / writer lock):
+//   find / contains / find_and_apply -> shared lock, any number of readers at once
+//   insert / upsert / erase          -> exclusive lock on that one shard
+// A seqlock (optimistic reads, retry if a writer got in) would avoid even the shared lock's
+// cache line traffic, but the buckets are std::list nodes that a writer can free while a reader is
+// walking them, so an optimistic reader could read freed memory. Reader / writer it is.
+//
+// Resizing is per shard: each shard is its own Hashmap and grows on its own when its load factor is hit,
+// under its own lock, so there is never a stop the world across the whole map.
+// Pass rehashStep > 0 to also make each shard's growth incremental (see Hashmap::set_incremental_rehash).
+//
+// There are no iterators, an iterator would have to keep a shard locked for as long as it lives.
+// Instead you pass a callback that runs while the lock is held (find_and_apply, upsert, for_each).
+// Dont call back into the same map from inside the callback, the shard lock is not recursive.
+
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class ConcurrentHashmap {
+public:
+    // shardCount gets rounded up to a power of two so the shard index is just the top bits of the hash
+    explicit ConcurrentHashmap(size_t shardCount = defaultShardCount(), size_t rehashStep = 0) {
+        mShardBits = 0;
+        while ((size_t{1} << mShardBits) < shardCount) {
+            mShardBits++;
+        }
+        mShardCount = size_t{1} << mShardBits;
+        mShards = std::make_unique<Shard[]>(mShardCount);
+        for (size_t i = 0; i < mShardCount; i++) {
+            mShards[i].map.set_incremental_rehash(rehashStep);
+        }
+    }
+
+    // the shards own mutexes, copying / moving the whole thing while other threads use it makes no sense
+    ConcurrentHashmap(const ConcurrentHashmap&) = delete;
+    ConcurrentHashmap& operator=(const ConcurrentHashmap&) = delete;
+
+    // inserts or overwrites, same as Hashmap::insert. true if the key was new
+    bool insert(const K& key, const V& value) {
+        Shard& shard = shardFor(mHash(key));
+        std::unique_lock lock(shard.mtx);
+        return shard.map.insert({key, value}).second;
+    }
+
+    // if the key exists, update(V&) runs on the stored value under the shard's exclusive lock,
+    // otherwise value gets inserted. true if it was inserted
+    // eg counting: map.upsert(word, [](int& c) { c++; }, 1);
+    template <typename F>
+    bool upsert(const K& key, F&& update, const V& value) {
+        size_t hash = mHash(key);
+        Shard& shard = shardFor(hash);
+        std::unique_lock lock(shard.mtx);
+        auto it = shard.map.find(key, hash);
+        if (it != shard.map.end()) {
+            std::forward<F>(update)(it->second);
+            return false;
+        }
+        shard.map.insert({key, value});
+        return true;
+    }
+
+    // runs f(const V&) on the value under the shard's shared lock, false if the key isnt there
+    template <typename F>
+    bool find_and_apply(const K& key, F&& f) const {
+        size_t hash = mHash(key);
+        const Shard& shard = shardFor(hash);
+        std::shared_lock lock(shard.mtx);
+        auto it = shard.map.find(key, hash);
+        if (it == shard.map.end()) {
+            return false;
+        }
+        std::forward<F>(f)(it->second);
+        return true;
+    }
+
+    // copies the value out, so nothing references the map after the lock is released
+    bool find(const K& key, V& result) const {
+        return find_and_apply(key, [&result](const V& value) { result = value; });
+    }
+
+    bool contains(const K& key) const {
+        size_t hash = mHash(key);
+        const Shard& shard = shardFor(hash);
+        std::shared_lock lock(shard.mtx);
+        return shard.map.contains(key, hash);
+    }
+
+    bool erase(const K& key) {
+        size_t hash = mHash(key);
+        Shard& shard = shardFor(hash);
+        std::unique_lock lock(shard.mtx);
+        return shard.map.erase(key, hash);
+    }
+
+    // locks one shard at a time, so this is not a snapshot if other threads are writing
+    size_t size() const {
+        size_t total = 0;
+        for (size_t i = 0; i < mShardCount; i++) {
+            std::shared_lock lock(mShards[i].mtx);
+            total += mShards[i].map.size();
+        }
+        return total;
+    }
+
+    // f(const K&, const V&) for every element, one shard at a time under that shard's shared lock
+    template <typename F>
+    void for_each(F&& f) const {
+        for (size_t i = 0; i < mShardCount; i++) {
+            std::shared_lock lock(mShards[i].mtx);
+            for (const auto& [key, value]: mShards[i].map) {
+                f(key, value);
+            }
+        }
+    }
+
+    size_t shard_count() const {
+        return mShardCount;
+    }
+
+    // Hashmap::stats of one shard, under that shard's shared lock
+    typename Hashmap<K, V, Hash, KeyEqual>::Stats shard_stats(size_t shard) const {
+        std::shared_lock lock(mShards[shard].mtx);
+        return mShards[shard].map.stats();
+    }
+
+private:
+    // alignas(64) puts every shard (and so every mutex) on its own cache line, otherwise two threads
+    // locking neighbouring shards would still fight over the same line (false sharing)
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mtx;
+        Hashmap<K, V, Hash, KeyEqual> map;
+    };
+
+    static size_t defaultShardCount() {
+        size_t threads = std::thread::hardware_concurrency();
+        return threads == 0 ? 16 : threads * 4;
+    }
+
+    // The shard and the bucket inside the shard both come from the same hash, so they must not depend on the
+    // same bits or every shard would only ever use a fraction of its buckets. Hashmap's default FastRangeIndex
+    // takes the bucket from the top bits of mixHash(hash) (HashPolicy.hpp), which is a multiply by the golden
+    // ratio too, so a shard picked from the top bits of hash * golden ratio would pin the top bits of the
+    // bucket index as well (for small integer keys the high half of the product is ~0 and mixHash is just that
+    // product). So the shard comes from a different mixer, splitmix64's finalizer (xor-shifts and two other
+    // multipliers), whose top bits have nothing to do with mixHash's.
+    // The key is hashed once: the same hash picks the shard and is passed on to the shard's Hashmap lookup.
+    size_t shardIndex(size_t hash) const {
+        if (mShardBits == 0) {
+            return 0;
+        }
+        uint64_t z = static_cast<uint64_t>(hash);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        return static_cast<size_t>(z >> (64 - mShardBits));
+    }
+
+    Shard& shardFor(size_t hash) {
+        return mShards[shardIndex(hash)];
+    }
+
+    const Shard& shardFor(size_t hash) const {
+        return mShards[shardIndex(hash)];
+    }
+
+    std::unique_ptr<Shard[]> mShards;
+    size_t mShardCount = 0;
+    size_t mShardBits = 0;
+    [[no_unique_address]] Hash mHash;
+};
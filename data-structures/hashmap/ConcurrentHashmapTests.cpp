@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ConcurrentHashmap.hpp"
+
+TEST(ConcurrentHashmapTest, BasicOperations) {
+    ConcurrentHashmap<std::string, int> map(8);
+    EXPECT_EQ(map.shard_count(), 8);
+    EXPECT_TRUE(map.insert("a", 1));
+    EXPECT_FALSE(map.insert("a", 2)); // overwrites like Hashmap::insert
+    EXPECT_TRUE(map.contains("a"));
+
+    int value = 0;
+    EXPECT_TRUE(map.find("a", value));
+    EXPECT_EQ(value, 2);
+    EXPECT_FALSE(map.find("b", value));
+
+    EXPECT_TRUE(map.erase("a"));
+    EXPECT_FALSE(map.erase("a"));
+    EXPECT_EQ(map.size(), 0);
+}
+
+TEST(ConcurrentHashmapTest, ShardCountRoundsUpToPowerOfTwo) {
+    ConcurrentHashmap<int, int> map(5);
+    EXPECT_EQ(map.shard_count(), 8);
+    ConcurrentHashmap<int, int> single(1);
+    EXPECT_EQ(single.shard_count(), 1);
+    single.insert(1, 1);
+    EXPECT_TRUE(single.contains(1));
+}
+
+TEST(ConcurrentHashmapTest, ShardsUseAllTheirBuckets) {
+    // the shard and the bucket come from the same hash. If they depended on the same bits, small int keys
+    // would land in a fraction of each shard's buckets and the chains would get long
+    ConcurrentHashmap<int, int> map(16);
+    for (int i = 0; i < 200000; ++i) {
+        map.insert(i, i);
+    }
+    Hashmap<int, int> plain;
+    for (int i = 0; i < 200000; ++i) {
+        plain.insert({i, i});
+    }
+    double plainChain = plain.stats().meanChainLength;
+    for (size_t s = 0; s < map.shard_count(); ++s) {
+        auto stats = map.shard_stats(s);
+        // about 12500 keys per shard, close to what a plain Hashmap does at the same load factor
+        EXPECT_GT(stats.size, 11000);
+        EXPECT_LT(stats.size, 14000);
+        size_t empty = stats.chainLengthHistogram.empty() ? 0 : stats.chainLengthHistogram[0];
+        double occupied = static_cast<double>(stats.bucketCount - empty) / stats.bucketCount;
+        double expected = 1 - std::exp(-stats.loadFactor);
+        EXPECT_GT(occupied, 0.8 * expected) << "shard " << s;
+        EXPECT_LT(stats.meanChainLength, 1.3 * plainChain) << "shard " << s;
+    }
+}
+
+TEST(ConcurrentHashmapTest, UpsertAndFindAndApply) {
+    ConcurrentHashmap<int, int> map;
+    EXPECT_TRUE(map.upsert(7, [](int& v) { v += 10; }, 1));
+    EXPECT_FALSE(map.upsert(7, [](int& v) { v += 10; }, 1));
+
+    int seen = 0;
+    EXPECT_TRUE(map.find_and_apply(7, [&](const int& v) { seen = v; }));
+    EXPECT_EQ(seen, 11);
+    EXPECT_FALSE(map.find_and_apply(8, [&](const int&) { seen = -1; }));
+    EXPECT_EQ(seen, 11);
+}
+
+TEST(ConcurrentHashmapTest, ConcurrentUpsertCounts) {
+    ConcurrentHashmap<int, int> map(16, 2);
+    const int numThreads = 8;
+    const int perThread = 20000;
+    const int numKeys = 1000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < perThread; ++i) {
+                map.upsert(i % numKeys, [](int& c) { c++; }, 1);
+            }
+        });
+    }
+    for (auto& t: threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(map.size(), numKeys);
+    long long total = 0;
+    map.for_each([&](const int&, const int& count) { total += count; });
+    EXPECT_EQ(total, static_cast<long long>(numThreads) * perThread);
+}
+
+TEST(ConcurrentHashmapTest, ReadersAndWritersTogether) {
+    ConcurrentHashmap<int, int> map(4);
+    const int numKeys = 20000;
+    std::atomic<bool> done{false};
+    std::atomic<int> badReads{0};
+
+    // readers only ever see either nothing or the right value for a key
+    auto reader = [&]() {
+        while (!done) {
+            for (int k = 0; k < numKeys; k += 7) {
+                map.find_and_apply(k, [&](const int& v) {
+                    if (v != k * 3) {
+                        badReads++;
+                    }
+                });
+            }
+        }
+    };
+    auto writer = [&](int offset) {
+        for (int k = offset; k < numKeys; k += 2) {
+            map.insert(k, k * 3);
+        }
+        for (int k = offset; k < numKeys; k += 4) {
+            map.erase(k);
+        }
+    };
+
+    std::thread r1(reader), r2(reader);
+    std::thread w1(writer, 0), w2(writer, 1);
+    w1.join();
+    w2.join();
+    done = true;
+    r1.join();
+    r2.join();
+
+    EXPECT_EQ(badReads.load(), 0);
+    EXPECT_EQ(map.size(), static_cast<size_t>(numKeys / 2));
+}
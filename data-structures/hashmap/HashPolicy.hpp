@@ -0,0 +1,98 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+
+// Bits shared by the hashmaps (Hashmap, SwissHashmap, ConcurrentHashmap)
+
+// Both the hasher and the key comparer have to opt in with an is_transparent member type (like
+// std::equal_to<>) before find / contains / erase accept keys of a type other than K.
+// Same rule std::unordered_map uses since C++20.
+template <typename Hash, typename KeyEqual>
+concept TransparentLookup = requires {
+    typename Hash::is_transparent;
+    typename KeyEqual::is_transparent;
+};
+
+// std::hash of integers is the identity, so the bits of the hash are only as random as the keys.
+// This is the wyhash style "mum" finalizer: one 64x64 -> 128 bit multiply by 2^64 / golden ratio, then xor
+// the two halves together. Every output bit depends on every input bit, so sequential, strided and
+// clustered keys all come out looking random, for about the cost of one multiply.
+inline uint64_t mixHash(uint64_t h) {
+    __uint128_t m = static_cast<__uint128_t>(h) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<uint64_t>(m) ^ static_cast<uint64_t>(m >> 64);
+}
+
+// Bucket index policies, how Hashmap turns a hash into a bucket.
+//   bucketCountFor(n) -> how many buckets rehash(n) really allocates (n rounded to whatever the policy needs)
+//   index(hash, count) -> the bucket, for a count that came out of bucketCountFor
+template <typename P>
+concept BucketIndexPolicy = requires(size_t n) {
+    { P::bucketCountFor(n) } -> std::same_as<size_t>;
+    { P::index(n, n) } -> std::same_as<size_t>;
+};
+
+// hash % count with the raw hash, what Hashmap always used to do.
+// The modulo is an integer division (20-40 cycles) on every operation, and with an identity hash and a non
+// prime count, keys that share a factor with the count (eg strides of 8 into 1024 buckets) pile up in a
+// fraction of the buckets.
+struct ModuloIndex {
+    static size_t bucketCountFor(size_t n) {
+        return n;
+    }
+    static size_t index(size_t hash, size_t count) {
+        return hash % count;
+    }
+};
+
+// hash % a prime, the std::unordered_map way. Primes have no common factor with strides so raw hashes
+// spread fine, but its still a division every time. Counts are rounded up to the next prime in the table
+// (roughly doubling), so growing by 2x lands on the next one.
+struct PrimeModuloIndex {
+    static size_t bucketCountFor(size_t n) {
+        static constexpr size_t kPrimes[] = {
+            2ULL, 5ULL, 11ULL, 23ULL, 47ULL, 97ULL, 199ULL, 409ULL, 823ULL, 1741ULL, 3469ULL, 6949ULL,
+            14033ULL, 28411ULL, 57557ULL, 116731ULL, 236897ULL, 480881ULL, 976369ULL, 1982627ULL,
+            4026031ULL, 8175383ULL, 16601593ULL, 33712729ULL, 68460391ULL, 139022417ULL, 282312799ULL,
+            573292817ULL, 1164186217ULL, 2364114217ULL, 4294967291ULL, 8589934583ULL, 17179869143ULL,
+            34359738337ULL, 68719476731ULL, 137438953447ULL, 274877906899ULL};
+        for (size_t p: kPrimes) {
+            if (p >= n) {
+                return p;
+            }
+        }
+        return n;
+    }
+    static size_t index(size_t hash, size_t count) {
+        return hash % count;
+    }
+};
+
+// count rounded up to a power of two, bucket = mixed hash & (count - 1). The cheapest index there is
+// (an and), but it only looks at the low bits, so it needs the mixing or strided keys would collide.
+struct PowerOfTwoIndex {
+    static size_t bucketCountFor(size_t n) {
+        size_t count = 1;
+        while (count < n) {
+            count *= 2;
+        }
+        return count;
+    }
+    static size_t index(size_t hash, size_t count) {
+        return static_cast<size_t>(mixHash(hash)) & (count - 1);
+    }
+};
+
+// Lemire's fast range: (mixed hash * count) >> 64 maps a 64 bit hash onto [0, count) with a multiply
+// instead of a division, for any count, so rehash(n) still gives exactly n buckets.
+// It uses the high bits of the hash, which is why it needs the mixing (std::hash<int> of small keys has
+// all zero high bits and would land everything in bucket 0).
+struct FastRangeIndex {
+    static size_t bucketCountFor(size_t n) {
+        return n;
+    }
+    static size_t index(size_t hash, size_t count) {
+        return static_cast<size_t>((static_cast<__uint128_t>(mixHash(hash)) * count) >> 64);
+    }
+};
@@ -1,24 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <functional>
 #include <initializer_list>
 #include <iterator>
 #include <list>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
+#include "HashPolicy.hpp"
 
 // Not thread safe
 
-template <typename K, typename V>
+// Hash and KeyEqual work like std::unordered_map's.
+// If both of them have an is_transparent member type, find / contains / erase also take any type Q that
+// they accept, so eg a Hashmap<std::string, V> can be probed with a std::string_view without building a std::string:
+//   struct StringHash {
+//       using is_transparent = void;
+//       size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+//   };
+//   Hashmap<std::string, int, StringHash, std::equal_to<>> map;
+//   map.find(std::string_view{"key"});
+//
+// find / contains / erase also have overloads taking the hash (whatever hash_function() returns for the key)
+// so you can hash a key once and probe several maps with it.
+//
+// Allocator is a normal std style allocator of value_type. The bucket lists rebind it to their node type
+// and the bucket arrays are allocated through it too, so eg PoolAllocator (allocators/pool) makes every
+// insert take a node from a pool and every erase hand it back.
+//
+// IndexPolicy (HashPolicy.hpp) turns the hash into a bucket index:
+//   FastRangeIndex   mixed hash, multiply-shift onto any bucket count (default)
+//   PowerOfTwoIndex  mixed hash, bucket count rounded up to a power of two, index is a mask
+//   PrimeModuloIndex raw hash % a prime bucket count, like std::unordered_map
+//   ModuloIndex      raw hash % bucket count, what this map did originally
+// The default came out of the key pattern benchmarks in HashmapBenchmarks.cpp: the mixing costs about
+// as much as a multiply and stops sequential / strided keys from clustering, and skipping the division
+// is worth more than the mixing costs. PowerOfTwoIndex is as fast but rounds rehash(n) up.
+//
+// stats() reports how well the hash spreads the keys (chain length histogram, longest chain, memory).
+// Build with -DHASHMAP_COUNTERS=1 and it also reports how many operations ran, how many keys they compared
+// against and how often / how long the table rehashed. Off by default, then the counters compile away
+// completely. Use the same setting in every file of a program, the class layout depends on it.
+
+#ifndef HASHMAP_COUNTERS
+#define HASHMAP_COUNTERS 0
+#endif
+
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>,
+          typename Allocator = std::allocator<std::pair<const K, V>>, BucketIndexPolicy IndexPolicy = FastRangeIndex>
 class Hashmap {
 private:
     // type alias
     using value_type = std::pair<const K, V>;
     // seperate chaining , linked list
-    using Bucket = std::list<value_type>;
+    using Bucket = std::list<value_type, Allocator>;
+    using BucketAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Bucket>;
+    using BucketTraits = std::allocator_traits<BucketAllocator>;
 
 public:
     // Iterator is used to go thru each kv pair sequentially bucket by bucket like an array
-    template <bool IsConst> 
+    template <bool IsConst>
     // const when u dont want to modify
     struct Iterator {
         // its a forward iterator
@@ -31,8 +82,12 @@ public:
         // Bucket::iterator does not mean that bucket is a namespace here
         // iterator is a nested type inside C++'s std::list
 
-        Iterator(typename Bucket::iterator ptr, Bucket* bucketPtr, size_t currentBucket, size_t numOfBuckets):
-                mPtr(ptr), mBucketPtr(bucketPtr), currentBucket(currentBucket), numOfBuckets(numOfBuckets) {}
+        // nextStore / nextCount are only set in the middle of an incremental rehash, when the iterator
+        // is walking the old table and has to carry on into the new one once it runs off the end
+        Iterator(typename Bucket::iterator ptr, Bucket* bucketPtr, size_t currentBucket, size_t numOfBuckets,
+                 Bucket* nextStore = nullptr, size_t nextCount = 0):
+                mPtr(ptr), mBucketPtr(bucketPtr), currentBucket(currentBucket), numOfBuckets(numOfBuckets),
+                mNextStore(nextStore), mNextCount(nextCount) {}
         // mPtr is current bucket
         // mBucketPtr is a pointer to the beginning of the array of buckets
         reference operator*() const {
@@ -41,11 +96,16 @@ public:
 
         pointer operator->() { return &(*mPtr); }
 
-    
+
         typename Bucket::iterator getBucketIterator() {
             return mPtr;
         }
-        
+
+        // the const and non const iterators hold exactly the same thing, this just relabels one
+        Iterator<false> asMutable() const {
+            return Iterator<false>{mPtr, mBucketPtr, currentBucket, numOfBuckets, mNextStore, mNextCount};
+        }
+
         // prefix
         // return reference to avoid making a copy and allows for chaining
         Iterator& operator++() {
@@ -53,7 +113,7 @@ public:
             // this is a pointer to current object, and dereferncing gives u the obj as an lvalue (reference to it)
             return *this;
         }
-        
+
         // postfix
         Iterator operator++(int) {
             Iterator tmp{*this};
@@ -61,12 +121,12 @@ public:
             return tmp;
             // doesent return pointer so you cant use chaining
         }
-        
+
         // 2 iterators are equal if they both are at the end of their respective buckets or
         // they both point to the same element in the same bucket
 
         // friend means non member function operator== can access private members like mPtr etc
-        friend bool operator==(const Iterator&a, const Iterator& b) { 
+        friend bool operator==(const Iterator&a, const Iterator& b) {
             if (a.numOfBuckets == a.currentBucket && b.numOfBuckets == b.currentBucket) {
                 return true;
             }
@@ -78,34 +138,52 @@ public:
             return a.mPtr == b.mPtr && a.currentBucket == b.currentBucket;
         }
 
-        friend bool operator!=(const Iterator&a, const Iterator& b) { 
+        friend bool operator!=(const Iterator&a, const Iterator& b) {
             return !(a == b);
         }
 
 
     private:
+        friend class Hashmap;
+
         // goes through each k,v pair sequentially almost like an array
         void next() {
             mPtr++;
             if (mPtr != mBucketPtr[currentBucket].end()) {
                 return;
             }
-            
+
             currentBucket++;
-            while(currentBucket < numOfBuckets && mBucketPtr[currentBucket].empty()) {
-                currentBucket++;
-            }
-            
-            if (currentBucket == numOfBuckets) {
-                return;
+            skipEmptyBuckets();
+        }
+
+        // moves forward to the first non empty bucket at or after currentBucket
+        void skipEmptyBuckets() {
+            while (true) {
+                while(currentBucket < numOfBuckets && mBucketPtr[currentBucket].empty()) {
+                    currentBucket++;
+                }
+                if (currentBucket < numOfBuckets) {
+                    mPtr = mBucketPtr[currentBucket].begin();
+                    return;
+                }
+                if (!mNextStore) {
+                    return;
+                }
+                // done with the old table mid rehash, carry on in the new one
+                mBucketPtr = mNextStore;
+                numOfBuckets = mNextCount;
+                currentBucket = 0;
+                mNextStore = nullptr;
             }
-            mPtr = mBucketPtr[currentBucket].begin();
         }
 
         typename Bucket::iterator mPtr;
         Bucket* mBucketPtr;
         size_t currentBucket;
         size_t numOfBuckets;
+        Bucket* mNextStore;
+        size_t mNextCount;
 
     };
 
@@ -116,30 +194,57 @@ public:
 
     Hashmap() = default;
 
+    explicit Hashmap(const Allocator& alloc): mAlloc(alloc) {}
+
     // initialiser list constructor
 
-    Hashmap(std::initializer_list<value_type> lst) {
-        rehash(lst.size());
+    Hashmap(std::initializer_list<value_type> lst, const Allocator& alloc = Allocator()): mAlloc(alloc) {
+        reserve(lst.size());
         for (const value_type& item: lst) {
             insert(item);
         }
     }
 
+    // range constructor, if we can tell how many elements there are up front (forward iterators)
+    // the table is sized once instead of doubling its way up
+    template <std::input_iterator It, std::sentinel_for<It> Sentinel>
+    Hashmap(It first, Sentinel last, const Allocator& alloc = Allocator()): mAlloc(alloc) {
+        if constexpr (std::forward_iterator<It>) {
+            reserve(static_cast<size_t>(std::ranges::distance(first, last)));
+        }
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+    }
+
     //  copy constructor
-    Hashmap(const Hashmap& other): maxLoadFactor(other.maxLoadFactor) {
+    Hashmap(const Hashmap& other): maxLoadFactor(other.maxLoadFactor), mRehashStep(other.mRehashStep),
+        mHash(other.mHash), mEqual(other.mEqual),
+        mAlloc(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.mAlloc)) {
         // initialises this new hashmap with same bucket count as old one, using rehash
         rehash(other.mBucketCount);
         for (const auto& el: other) {
             insert(el);
         }
     }
-    
+
     // move constructor
     Hashmap(Hashmap&& other):  mBucketCount(other.mBucketCount),
-        mSize(other.mSize), maxLoadFactor(other.maxLoadFactor) {
+        mSize(other.mSize), maxLoadFactor(other.maxLoadFactor), mHash(std::move(other.mHash)), mEqual(std::move(other.mEqual)),
+        mAlloc(other.mAlloc) {
         mStore = other.mStore;
+        mConstructed = other.mConstructed;
+        mOldStore = other.mOldStore;
+        mOldBucketCount = other.mOldBucketCount;
+        mMigrated = other.mMigrated;
+        mRehashStep = other.mRehashStep;
+        mStepWork = other.mStepWork;
         other.mStore = nullptr;
         other.mBucketCount = 0;
+        other.mConstructed = 0;
+        other.mOldStore = nullptr;
+        other.mOldBucketCount = 0;
+        other.mMigrated = 0;
         other.mSize = 0;
     }
 
@@ -151,43 +256,103 @@ public:
             throw std::out_of_range("invalid key");
         }
         return it->second;
-    } 
+    }
 
     // returns a mutable iterator that will point to the element in the hashmap, and boolean to indicate
     // if we successfully managed to add
 
     std::pair<Iterator<false>, bool> insert(const value_type& value) {
-        // if no buckets, allocate at least one
-        if (mBucketCount == 0) {
-            rehash(1);
-        }
-        // compute the bucket index
-        size_t bucketIdx = hashKey(value.first, mBucketCount);
+        return insertImpl(value, mHash(value.first));
+    }
 
-        // check if key already exists and replace
-        // call std::list::begin, which returns an iterator pointing to the first element of that bucket's list
-        typename Bucket::iterator start = mStore[bucketIdx].begin();
-        for (; start != mStore[bucketIdx].end(); start++) {
-            if (start->first == value.first) {
-                start->second = value.second;
-                break;
-            }
+    // moves the value in (the key still gets copied, its const inside value_type)
+    std::pair<Iterator<false>, bool> insert(value_type&& value) {
+        size_t hash = mHash(value.first);
+        return insertImpl(std::move(value), hash);
+    }
+
+    // anything value_type can be built from, eg std::pair<K, V>&& which lets the key be moved in as well
+    template <typename P> requires std::constructible_from<value_type, P&&>
+    std::pair<Iterator<false>, bool> insert(P&& value) {
+        const K& key = value.first;
+        size_t hash = mHash(key);
+        return insertImpl(std::forward<P>(value), hash);
+    }
+
+    // inserts every element of the range, sizing the table once if the range knows its size
+    // pass the range as an rvalue (eg std::move(vec)) and the elements get moved instead of copied.
+    // Same rule as Vector::append: an rvalue view (vec | views::take(2)) or a borrowed range (span) doesnt own
+    // its elements, those get copied
+    template <std::ranges::input_range R>
+    void insert_range(R&& range) {
+        constexpr bool kOwnsElements = !std::is_lvalue_reference_v<R> && !std::ranges::view<std::remove_cvref_t<R>>
+                                    && !std::ranges::borrowed_range<R>;
+        if constexpr (std::ranges::sized_range<R>) {
+            reserve(mSize + static_cast<size_t>(std::ranges::size(range)));
         }
-        
-        // return early if key already existed and we replace
-        if (start != mStore[bucketIdx].end()) {
-            return { Iterator<false>{start, mStore, bucketIdx, mSize }, false };
+        for (auto&& item: range) {
+            if constexpr (kOwnsElements) {
+                insert(std::move(item));
+            } else {
+                // forward, so a prvalue element (views::transform) still gets moved in
+                insert(std::forward<decltype(item)>(item));
+            }
         }
+    }
 
-        if (static_cast<double>(mSize + 1) / mBucketCount >= maxLoadFactor) {
-            rehash(mBucketCount * 2);
-            bucketIdx = hashKey(value.first, mBucketCount);
+    // Parallel bulk build
+    // Sizes the table once, then numThreads threads each own a contiguous slice of the bucket array
+    // (ie a range of hash values) and insert only the elements whose bucket falls in their slice,
+    // so no two threads ever touch the same bucket and there is no locking at all.
+    // Each thread still reads the whole array of precomputed hashes, but thats a sequential scan of
+    // size_t's next to the cost of building list nodes.
+    // Later duplicates win just like repeated insert.
+    // The Allocator is called from all the threads at once, so it has to be thread safe
+    // (std::allocator is, NodePool is not).
+    template <std::ranges::random_access_range R>
+    void insert_range_parallel(const R& range, size_t numThreads = std::thread::hardware_concurrency()) {
+        size_t n = static_cast<size_t>(std::ranges::size(range));
+        if (numThreads <= 1 || n < numThreads * 1024) {
+            insert_range(range);
+            return;
         }
-        // std::list::insert is invoked, returns an iterator pointing to the newly inserrted element
-        start = mStore[bucketIdx].insert(mStore[bucketIdx].end(), value);
-        mSize++;
+        reserve(mSize + n);
+        complete_rehash();
+
+        // hashing is the other half of the work so thats split across the threads too
+        std::vector<size_t> hashes(n);
+        auto begin = std::ranges::begin(range);
+        runOnThreads(numThreads, [&](size_t t) {
+            for (size_t i = n * t / numThreads; i < n * (t + 1) / numThreads; i++) {
+                hashes[i] = mHash(begin[i].first);
+            }
+        });
 
-        return { Iterator<false>{start, mStore, bucketIdx, mSize }, true };
+        std::vector<size_t> added(numThreads, 0);
+        runOnThreads(numThreads, [&](size_t t) {
+            size_t firstBucket = mBucketCount * t / numThreads;
+            size_t lastBucket = mBucketCount * (t + 1) / numThreads;
+            for (size_t i = 0; i < n; i++) {
+                size_t bucketIdx = bucketIndex(hashes[i], mBucketCount);
+                if (bucketIdx < firstBucket || bucketIdx >= lastBucket) {
+                    continue;
+                }
+                Bucket& bucket = mStore[bucketIdx];
+                auto it = bucket.begin();
+                while (it != bucket.end() && !mEqual(it->first, begin[i].first)) {
+                    ++it;
+                }
+                if (it != bucket.end()) {
+                    it->second = begin[i].second;
+                } else {
+                    bucket.emplace_back(begin[i]);
+                    added[t]++;
+                }
+            }
+        });
+        for (size_t count: added) {
+            mSize += count;
+        }
     }
 
     V& operator[](const K& key) {
@@ -201,32 +366,161 @@ public:
     }
 
     iterator find(const K& key) {
-        size_t bucketIdx = hashKey(key, mBucketCount);
-        if (bucketIdx < mBucketCount) {
-            // use std::list::end and begin here
-            for (auto start = mStore[bucketIdx].begin(); start != mStore[bucketIdx].end(); start++) {
-                if (start->first == key) {
-                    return Iterator<false>{start, mStore, bucketIdx, mBucketCount};
-                }
-            }
-        }
-        return end();
+        return findImpl(key, mHash(key));
+    }
+
+    // const lookups never do incremental rehash work (they just look in whichever table the key is in),
+    // so they dont modify anything and are safe to run concurrently with each other
+    const_iterator find(const K& key) const {
+        return findImpl(key, mHash(key));
+    }
+
+    // hash has to be hash_function()(key)
+    iterator find(const K& key, size_t hash) {
+        return findImpl(key, hash);
+    }
+
+    const_iterator find(const K& key, size_t hash) const {
+        return findImpl(key, hash);
     }
 
-    bool contains(const K& key) {
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    iterator find(const Q& key) {
+        return findImpl(key, mHash(key));
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    const_iterator find(const Q& key) const {
+        return findImpl(key, mHash(key));
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    iterator find(const Q& key, size_t hash) {
+        return findImpl(key, hash);
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    const_iterator find(const Q& key, size_t hash) const {
+        return findImpl(key, hash);
+    }
+
+    bool contains(const K& key) const {
         return find(key) != end();
     }
 
+    bool contains(const K& key, size_t hash) const {
+        return find(key, hash) != end();
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    bool contains(const Q& key) const {
+        return find(key) != end();
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    bool contains(const Q& key, size_t hash) const {
+        return find(key, hash) != end();
+    }
+
     bool erase(const K& key) {
-        iterator it = find(key);
-        if (it == end()) {
-            return false;
+        return eraseImpl(key, mHash(key));
+    }
+
+    bool erase(const K& key, size_t hash) {
+        return eraseImpl(key, hash);
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    bool erase(const Q& key) {
+        return eraseImpl(key, mHash(key));
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    bool erase(const Q& key, size_t hash) {
+        return eraseImpl(key, hash);
+    }
+
+    // Batched lookups
+    // A single find is a chain of dependent cache misses: bucket array -> first list node -> next node ...
+    // and the cpu cant start on the next key's misses until this one is resolved, so with a big table
+    // n lookups cost about n * (a couple of DRAM round trips).
+    // find_batch does the keys in groups of kBatchGroup, in stages:
+    //   1) hash every key in the group and prefetch its bucket (the std::list header)
+    //   2) read each bucket's first node pointer and prefetch the node
+    //   3) walk the buckets and compare keys like a normal find, by now most of it is in cache
+    // all the misses within a stage are independent so they overlap (memory level parallelism)
+    // out[i] is a pointer to the value for keys[i], or nullptr if its not in the map.
+    void find_batch(std::span<const K> keys, std::span<V*> out) {
+        rehashStep();
+        std::span<const V*> constOut{const_cast<const V**>(out.data()), out.size()};
+        std::as_const(*this).find_batch(keys, constOut);
+    }
+
+    void find_batch(std::span<const K> keys, std::span<const V*> out) const {
+        if (out.size() < keys.size()) {
+            throw std::out_of_range("find_batch: out is smaller than keys");
+        }
+        Slot slots[kBatchGroup];
+        for (size_t base = 0; base < keys.size(); base += kBatchGroup) {
+            size_t n = std::min(kBatchGroup, keys.size() - base);
+            if (mBucketCount == 0) {
+                std::fill_n(out.begin() + base, n, nullptr);
+                continue;
+            }
+            for (size_t i = 0; i < n; i++) {
+                slots[i] = slotFor(mHash(keys[base + i]));
+                __builtin_prefetch(&slots[i].store[slots[i].bucketIdx]);
+            }
+            prefetchFirstNodes(slots, n);
+            for (size_t i = 0; i < n; i++) {
+                out[base + i] = nullptr;
+                size_t probes = 0;
+                for (const value_type& kv: slots[i].store[slots[i].bucketIdx]) {
+                    probes++;
+                    if (mEqual(kv.first, keys[base + i])) {
+                        out[base + i] = &kv.second;
+                        break;
+                    }
+                }
+                countOperation(&Counters::finds, &Counters::findProbes, probes);
+            }
+        }
+    }
+
+    // same staging as find_batch, then each element goes through the normal insert with its precomputed hash
+    // (if an insert in the middle of a group grows the table the prefetches are just wasted, nothing breaks)
+    void insert_batch(std::span<const value_type> values) {
+        size_t hashes[kBatchGroup];
+        Slot slots[kBatchGroup];
+        for (size_t base = 0; base < values.size(); base += kBatchGroup) {
+            size_t n = std::min(kBatchGroup, values.size() - base);
+            for (size_t i = 0; i < n; i++) {
+                hashes[i] = mHash(values[base + i].first);
+            }
+            if (mBucketCount != 0) {
+                for (size_t i = 0; i < n; i++) {
+                    slots[i] = slotFor(hashes[i]);
+                    __builtin_prefetch(&slots[i].store[slots[i].bucketIdx]);
+                }
+                prefetchFirstNodes(slots, n);
+            }
+            for (size_t i = 0; i < n; i++) {
+                insertImpl(values[base + i], hashes[i]);
+            }
         }
-        size_t bucketIdx = hashKey(key, mBucketCount);
-        // remove the node from the linked list using std::list:erase
-        mStore[bucketIdx].erase(it.getBucketIterator());
-        mSize--;
-        return true;
+    }
+
+    // a copy of the hasher, so callers can compute the hash once and pass it to the overloads above
+    Hash hash_function() const {
+        return mHash;
+    }
+
+    KeyEqual key_eq() const {
+        return mEqual;
+    }
+
+    Allocator get_allocator() const {
+        return mAlloc;
     }
 
     size_t size() const {
@@ -236,45 +530,165 @@ public:
     size_t bucket_count() const {
         return mBucketCount;
     }
-    // count is the new number of buckets
+
+    static constexpr bool kCountersEnabled = HASHMAP_COUNTERS;
+
+    struct Stats {
+        size_t size = 0;
+        size_t bucketCount = 0;
+        double loadFactor = 0;
+        // chainLengthHistogram[n] = how many buckets hold exactly n elements
+        // with a decent hash and load factor 0.7 almost everything is in [0], [1] and [2],
+        // a long tail means the hash is clustering keys
+        std::vector<size_t> chainLengthHistogram;
+        size_t maxChainLength = 0;
+        // averaged over the non empty buckets, ie how many keys a successful lookup has to look at
+        double meanChainLength = 0;
+        // bucket arrays + an estimate of the list nodes (element + prev / next pointers)
+        size_t bytesUsed = 0;
+
+        // everything below stays 0 unless kCountersEnabled
+        // probes = key comparisons
+        size_t finds = 0;
+        size_t findProbes = 0;
+        size_t inserts = 0;
+        size_t insertProbes = 0;
+        size_t erases = 0;
+        size_t eraseProbes = 0;
+        size_t rehashes = 0;
+        uint64_t rehashNanos = 0;
+    };
+
+    // walks every bucket, so its O(bucket_count), dont call it on a hot path
+    Stats stats() const {
+        Stats stats;
+        stats.size = mSize;
+        stats.bucketCount = mBucketCount;
+        stats.loadFactor = mBucketCount == 0 ? 0 : static_cast<double>(mSize) / mBucketCount;
+        size_t nonEmpty = 0;
+        auto visit = [&](const Bucket& bucket) {
+            size_t length = bucket.size();
+            if (length >= stats.chainLengthHistogram.size()) {
+                stats.chainLengthHistogram.resize(length + 1, 0);
+            }
+            stats.chainLengthHistogram[length]++;
+            stats.maxChainLength = std::max(stats.maxChainLength, length);
+            nonEmpty += length != 0;
+        };
+        // mid rehash the elements are split between the unmigrated part of the old table and the new one
+        if (mOldStore) {
+            for (size_t i = mMigrated; i < mOldBucketCount; i++) {
+                visit(mOldStore[i]);
+            }
+        }
+        for (size_t i = 0; i < mConstructed; i++) {
+            visit(mStore[i]);
+        }
+        stats.meanChainLength = nonEmpty == 0 ? 0 : static_cast<double>(mSize) / nonEmpty;
+        stats.bytesUsed = (mBucketCount + mOldBucketCount) * sizeof(Bucket)
+                        + mSize * (sizeof(value_type) + 2 * sizeof(void*));
+
+        if constexpr (kCountersEnabled) {
+            stats.finds = mCounters.finds;
+            stats.findProbes = mCounters.findProbes;
+            stats.inserts = mCounters.inserts;
+            stats.insertProbes = mCounters.insertProbes;
+            stats.erases = mCounters.erases;
+            stats.eraseProbes = mCounters.eraseProbes;
+            stats.rehashes = mCounters.rehashes;
+            stats.rehashNanos = mCounters.rehashNanos;
+        }
+        return stats;
+    }
+
+    void reset_counters() {
+        if constexpr (kCountersEnabled) {
+            mCounters = Counters{};
+        }
+    }
+
+    // makes sure count elements fit without going over the max load factor, so inserting them
+    // cant trigger a rehash. never shrinks
+    void reserve(size_t count) {
+        size_t needed = static_cast<size_t>(static_cast<double>(count) / maxLoadFactor) + 1;
+        if (needed > mBucketCount) {
+            rehash(needed);
+        }
+    }
+
+    // count is the new number of buckets (rounded up if the IndexPolicy needs, eg to a power of two)
+    // this is the stop the world version, every node gets moved before we return
     void rehash(size_t count) {
-        // new dynamic array of buckets 
-        Bucket* newStore = new Bucket[count];
+        complete_rehash();
+        count = IndexPolicy::bucketCountFor(count);
+        auto started = startTimer();
+        // new dynamic array of buckets
+        Bucket* newStore = allocateBuckets(count);
+        constructBuckets(newStore, 0, count);
 
         for (size_t i = 0; i < mBucketCount; i++) {
-            for (const value_type& val: mStore[i]) {
-                size_t bucketIdx = hashKey(val.first, count);
-                // move over
-                newStore[bucketIdx].insert(newStore[bucketIdx].end(), std::move(val));
-            }
+            moveBucket(mStore[i], newStore, count);
         }
-        delete[] mStore;
+        destroyBuckets(mStore, 0, mBucketCount);
+        freeBuckets(mStore, mBucketCount);
         mStore = newStore;
         mBucketCount = count;
+        mConstructed = count;
+        countRehash(started, 1);
     }
 
-    const_iterator cbegin() const {
-        for (size_t i = 0; i < mBucketCount; i++) {
-            if (!mStore[i].empty()) {
-                return Iterator<true>{mStore[i].begin(), mStore, i, mBucketCount};
-            }
+    // Incremental rehash mode
+    // By default growing the table rehashes everything in one go, which at tens of millions of entries
+    // is a long stall for whoever did the unlucky insert. With bucketsPerStep > 0, growing instead
+    // allocates the new table and then every insert / find / erase does a bounded amount of the work:
+    //   1) construct up to 4 * bucketsPerStep buckets of the new table (while this is happening everything
+    //      still lives in the old table)
+    //   2) move the nodes of up to bucketsPerStep old buckets over to the new table
+    // Old buckets are moved in order, so a key is in the old table iff its old bucket index >= mMigrated,
+    // which means a lookup still only has to search one bucket.
+    // Nodes are spliced, never copied, so pointers / references to values stay valid,
+    // but iterators are invalidated by any non const operation while a rehash is in progress.
+    // bucketsPerStep is a minimum. A doubling is 2 * old / 4 steps of constructing plus old / step of moving,
+    // but the next doubling comes after only ~0.7 * old inserts, so with a small step an insert only workload
+    // would reach it unfinished and grow() would have to finish it synchronously (the stall is back).
+    // So each rehash works out how many inserts are left before the next one and does at least
+    // (total work / those inserts) per step, any bucketsPerStep >= 1 is done in time.
+    // 0 turns it off again (and finishes any rehash that is in progress).
+    void set_incremental_rehash(size_t bucketsPerStep) {
+        mRehashStep = bucketsPerStep;
+        if (bucketsPerStep == 0) {
+            complete_rehash();
         }
-        return cend();
     }
-    
+
+    bool is_rehashing() const {
+        return mOldStore != nullptr;
+    }
+
+    // finishes an in progress incremental rehash right now
+    void complete_rehash() {
+        if (!mOldStore) {
+            return;
+        }
+        auto started = startTimer();
+        constructBuckets(mStore, mConstructed, mBucketCount);
+        mConstructed = mBucketCount;
+        migrateBuckets(mOldBucketCount);
+        countRehash(started, 0);
+    }
+
+    const_iterator cbegin() const {
+        return firstElement<true>();
+    }
+
     const_iterator cend() const {
         return Iterator<true>{{}, mStore, mBucketCount, mBucketCount};
     }
 
     iterator begin() {
-        for (size_t i = 0; i < mBucketCount; i++) {
-            if (!mStore[i].empty()) {
-                return Iterator<false>{mStore[i].begin(), mStore, i, mBucketCount};
-            }
-        }
-        return end();
+        return firstElement<false>();
     }
-    
+
     const_iterator begin() const {
         return cbegin();
     }
@@ -288,21 +702,332 @@ public:
     }
 
     ~Hashmap() {
+        if (mOldStore) {
+            // buckets below mMigrated were already destroyed when their nodes moved over
+            destroyBuckets(mOldStore, mMigrated, mOldBucketCount);
+            freeBuckets(mOldStore, mOldBucketCount);
+        }
         if (mStore) {
-            delete[] mStore;
+            destroyBuckets(mStore, 0, mConstructed);
+            freeBuckets(mStore, mBucketCount);
         }
     }
 
 private:
-    size_t hashKey(const K& key, size_t bucketCount) {
-        // uses a hashing algorithm
-        size_t hashIdx = std::hash<K>()(key);
-        return hashIdx % bucketCount;
+    // where a key lives (or would be inserted): which table, how big it is, and the bucket in it
+    struct Slot {
+        Bucket* store;
+        size_t count;
+        size_t bucketIdx;
+    };
+
+    template <typename F>
+    static void runOnThreads(size_t numThreads, F&& work) {
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < numThreads; t++) {
+            threads.emplace_back(work, t);
+        }
+        // the calling thread does the first share itself
+        work(0);
+        for (auto& thread: threads) {
+            thread.join();
+        }
+    }
+
+    // plain counters, bumped through std::atomic_ref because const lookups can run on several threads at once
+    // (eg ConcurrentHashmap readers under a shared lock)
+    struct Counters {
+        size_t finds = 0;
+        size_t findProbes = 0;
+        size_t inserts = 0;
+        size_t insertProbes = 0;
+        size_t erases = 0;
+        size_t eraseProbes = 0;
+        size_t rehashes = 0;
+        uint64_t rehashNanos = 0;
+    };
+    struct NoCounters {};
+
+    void countOperation(size_t Counters::* ops, size_t Counters::* probes, size_t probeCount) const {
+        if constexpr (kCountersEnabled) {
+            std::atomic_ref<size_t>(mCounters.*ops).fetch_add(1, std::memory_order_relaxed);
+            std::atomic_ref<size_t>(mCounters.*probes).fetch_add(probeCount, std::memory_order_relaxed);
+        }
+    }
+
+    // with the counters off this is never called for real, so no clock reads in production builds
+    static std::chrono::steady_clock::time_point startTimer() {
+        if constexpr (kCountersEnabled) {
+            return std::chrono::steady_clock::now();
+        } else {
+            return {};
+        }
+    }
+
+    void countRehash(std::chrono::steady_clock::time_point started, size_t rehashes) {
+        if constexpr (kCountersEnabled) {
+            auto elapsed = std::chrono::steady_clock::now() - started;
+            mCounters.rehashNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+            mCounters.rehashes += rehashes;
+        }
+    }
+
+    // how many keys the batch functions keep in flight, enough to cover DRAM latency without the
+    // prefetched lines getting pushed out of L1 again before we use them
+    static constexpr size_t kBatchGroup = 16;
+
+    void prefetchFirstNodes(const Slot* slots, size_t n) const {
+        for (size_t i = 0; i < n; i++) {
+            const Bucket& bucket = slots[i].store[slots[i].bucketIdx];
+            if (!bucket.empty()) {
+                __builtin_prefetch(&bucket.front());
+            }
+        }
     }
-    
+
+    // the hash itself is computed once per operation by the caller using mHash
+    static size_t bucketIndex(size_t hash, size_t bucketCount) {
+        return IndexPolicy::index(hash, bucketCount);
+    }
+
+    Slot slotFor(size_t hash) const {
+        if (mOldStore) {
+            size_t oldIdx = bucketIndex(hash, mOldBucketCount);
+            // still building the new table, or this bucket has not been moved yet
+            if (mConstructed < mBucketCount || oldIdx >= mMigrated) {
+                return { mOldStore, mOldBucketCount, oldIdx };
+            }
+        }
+        return { mStore, mBucketCount, bucketIndex(hash, mBucketCount) };
+    }
+
+    // P is whatever value_type can be built from, its only moved from if we actually insert / overwrite
+    template <typename P>
+    std::pair<Iterator<false>, bool> insertImpl(P&& value, size_t hash) {
+        rehashStep();
+        // if no buckets, allocate at least one
+        if (mBucketCount == 0) {
+            rehash(1);
+        }
+        // compute the bucket index (and which table it lives in, if we are mid rehash)
+        Slot slot = slotFor(hash);
+
+        // check if key already exists and replace
+        // call std::list::begin, which returns an iterator pointing to the first element of that bucket's list
+        typename Bucket::iterator start = slot.store[slot.bucketIdx].begin();
+        size_t probes = 0;
+        for (; start != slot.store[slot.bucketIdx].end(); start++) {
+            probes++;
+            if (mEqual(start->first, value.first)) {
+                start->second = std::forward<P>(value).second;
+                break;
+            }
+        }
+        countOperation(&Counters::inserts, &Counters::insertProbes, probes);
+
+        // return early if key already existed and we replace
+        if (start != slot.store[slot.bucketIdx].end()) {
+            return { iteratorAt(slot, start), false };
+        }
+
+        if (static_cast<double>(mSize + 1) / mBucketCount >= maxLoadFactor) {
+            grow();
+            slot = slotFor(hash);
+        }
+        // std::list::insert is invoked, returns an iterator pointing to the newly inserrted element
+        start = slot.store[slot.bucketIdx].emplace(slot.store[slot.bucketIdx].end(), std::forward<P>(value));
+        mSize++;
+
+        return { iteratorAt(slot, start), true };
+    }
+
+    // non const lookups do a bit of incremental rehash work first
+    template <typename Q>
+    iterator findImpl(const Q& key, size_t hash) {
+        rehashStep();
+        return std::as_const(*this).findImpl(key, hash).asMutable();
+    }
+
+    template <typename Q>
+    const_iterator findImpl(const Q& key, size_t hash) const {
+        // nothing allocated yet, and bucketIndex would divide by zero
+        if (mBucketCount == 0) {
+            return end();
+        }
+        Slot slot = slotFor(hash);
+        size_t probes = 0;
+        // use std::list::end and begin here
+        for (auto start = slot.store[slot.bucketIdx].begin(); start != slot.store[slot.bucketIdx].end(); start++) {
+            probes++;
+            if (mEqual(start->first, key)) {
+                countOperation(&Counters::finds, &Counters::findProbes, probes);
+                return iteratorAt<true>(slot, start);
+            }
+        }
+        countOperation(&Counters::finds, &Counters::findProbes, probes);
+        return end();
+    }
+
+    // hashes once and unlinks the node straight from the bucket, no second lookup
+    template <typename Q>
+    bool eraseImpl(const Q& key, size_t hash) {
+        rehashStep();
+        if (mBucketCount == 0) {
+            return false;
+        }
+        Slot slot = slotFor(hash);
+        Bucket& bucket = slot.store[slot.bucketIdx];
+        size_t probes = 0;
+        for (auto start = bucket.begin(); start != bucket.end(); start++) {
+            probes++;
+            if (mEqual(start->first, key)) {
+                // remove the node from the linked list using std::list:erase
+                bucket.erase(start);
+                mSize--;
+                countOperation(&Counters::erases, &Counters::eraseProbes, probes);
+                return true;
+            }
+        }
+        countOperation(&Counters::erases, &Counters::eraseProbes, probes);
+        return false;
+    }
+
+    template <bool IsConst = false>
+    Iterator<IsConst> iteratorAt(const Slot& slot, typename Bucket::iterator it) const {
+        // an iterator into the old table has to continue into the new one when it reaches the end
+        if (slot.store == mOldStore && mConstructed == mBucketCount) {
+            return Iterator<IsConst>{it, slot.store, slot.bucketIdx, slot.count, mStore, mBucketCount};
+        }
+        return Iterator<IsConst>{it, slot.store, slot.bucketIdx, slot.count};
+    }
+
+    template <bool IsConst>
+    Iterator<IsConst> firstElement() const {
+        Iterator<IsConst> it{{}, mStore, 0, mBucketCount};
+        if (mOldStore) {
+            if (mConstructed < mBucketCount) {
+                // the new table is still being built and is empty, only walk the old one
+                it = Iterator<IsConst>{{}, mOldStore, mMigrated, mOldBucketCount};
+            } else {
+                // everything below mMigrated in the old table is already empty
+                it = Iterator<IsConst>{{}, mOldStore, mMigrated, mOldBucketCount, mStore, mBucketCount};
+            }
+        }
+        it.skipEmptyBuckets();
+        return it;
+    }
+
+    void grow() {
+        if (mRehashStep == 0) {
+            rehash(mBucketCount * 2);
+            return;
+        }
+        // if the previous rehash still hasnt finished, we have no choice but to finish it now
+        complete_rehash();
+        mOldStore = mStore;
+        mOldBucketCount = mBucketCount;
+        mMigrated = 0;
+        mBucketCount = IndexPolicy::bucketCountFor(mBucketCount * 2);
+        // raw memory only, the buckets get constructed a few at a time in rehashStep
+        mStore = allocateBuckets(mBucketCount);
+        mConstructed = 0;
+        // with nothing but inserts, every one of them up to the one that triggers the next grow does a step.
+        // 2 less for the float rounding of the load factor check, and 2 more because the constructing
+        // and moving phases each end with a partial step
+        size_t nextGrow = static_cast<size_t>(maxLoadFactor * static_cast<double>(mBucketCount));
+        size_t steps = nextGrow > mSize + 4 ? nextGrow - mSize - 4 : 1;
+        size_t work = (mBucketCount + 3) / 4 + mOldBucketCount;
+        mStepWork = (work + steps - 1) / steps;
+        // the time spent on it is added up in rehashStep / complete_rehash as the work happens
+        countRehash(startTimer(), 1);
+    }
+
+    // the bounded amount of rehash work every operation does while a rehash is in progress
+    void rehashStep() {
+        if (!mOldStore) {
+            return;
+        }
+        auto started = startTimer();
+        size_t step = std::max(mRehashStep, mStepWork);
+        if (mConstructed < mBucketCount) {
+            size_t upTo = std::min(mBucketCount, mConstructed + 4 * step);
+            constructBuckets(mStore, mConstructed, upTo);
+            mConstructed = upTo;
+        } else {
+            migrateBuckets(mMigrated + step);
+        }
+        countRehash(started, 0);
+    }
+
+    // moves old buckets [mMigrated, upTo) into the new table, frees the old table once its empty
+    void migrateBuckets(size_t upTo) {
+        upTo = std::min(upTo, mOldBucketCount);
+        for (; mMigrated < upTo; mMigrated++) {
+            moveBucket(mOldStore[mMigrated], mStore, mBucketCount);
+            mOldStore[mMigrated].~Bucket();
+        }
+        if (mMigrated == mOldBucketCount) {
+            freeBuckets(mOldStore, mOldBucketCount);
+            mOldStore = nullptr;
+            mOldBucketCount = 0;
+            mMigrated = 0;
+        }
+    }
+
+    // splice relinks the existing list nodes into the new bucket, no allocation and no copying of K or V
+    void moveBucket(Bucket& from, Bucket* to, size_t count) {
+        while (!from.empty()) {
+            size_t bucketIdx = bucketIndex(mHash(from.front().first), count);
+            to[bucketIdx].splice(to[bucketIdx].end(), from, from.begin());
+        }
+    }
+
+    // bucket arrays are raw memory + placement new so that the incremental rehash can construct
+    // and destroy them a slice at a time
+    // every bucket gets a copy of mAlloc, splice between buckets needs their allocators to compare equal
+    Bucket* allocateBuckets(size_t count) {
+        BucketAllocator alloc(mAlloc);
+        return BucketTraits::allocate(alloc, count);
+    }
+
+    void freeBuckets(Bucket* store, size_t count) {
+        if (!store) {
+            return;
+        }
+        BucketAllocator alloc(mAlloc);
+        BucketTraits::deallocate(alloc, store, count);
+    }
+
+    void constructBuckets(Bucket* store, size_t from, size_t to) {
+        for (size_t i = from; i < to; i++) {
+            new (&store[i]) Bucket(mAlloc);
+        }
+    }
+
+    static void destroyBuckets(Bucket* store, size_t from, size_t to) {
+        for (size_t i = from; i < to; i++) {
+            store[i].~Bucket();
+        }
+    }
+
     // points to a dynamically allocated array of buckets
     Bucket* mStore = nullptr;
     size_t mBucketCount = 0;
     size_t mSize = 0;
     double maxLoadFactor = 0.7;
+
+    // incremental rehash state, mOldStore is only non null while a rehash is in progress
+    // mConstructed is how many buckets of mStore have been constructed so far
+    size_t mConstructed = 0;
+    Bucket* mOldStore = nullptr;
+    size_t mOldBucketCount = 0;
+    size_t mMigrated = 0;
+    size_t mRehashStep = 0;
+    // old buckets worth of work a step of the current rehash does at least, set by grow()
+    size_t mStepWork = 0;
+
+    [[no_unique_address]] Hash mHash;
+    [[no_unique_address]] KeyEqual mEqual;
+    [[no_unique_address]] Allocator mAlloc;
+    [[no_unique_address]] mutable std::conditional_t<kCountersEnabled, Counters, NoCounters> mCounters;
 };
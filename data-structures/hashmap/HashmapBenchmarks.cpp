@@ -0,0 +1,507 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <cstdint>
+#include <list>
+#include <random>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include "CacheHashmap.hpp"
+#include "ConcurrentHashmap.hpp"
+#include "Hashmap.hpp"
+#include "MappedHashmap.hpp"
+#include "SwissHashmap.hpp"
+
+// Google Benchmark, link with -lbenchmark -lbenchmark_main -pthread
+// build with -O2 (and -mavx2 if you want the 32 wide SwissHashmap groups)
+
+namespace {
+
+std::vector<uint64_t> randomKeys(size_t n, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<uint64_t> keys(n);
+    for (auto& k: keys) {
+        k = rng();
+    }
+    return keys;
+}
+
+} // namespace
+
+// ---- chained Hashmap vs SwissHashmap vs std::unordered_map ----
+
+template <typename Map>
+static void BM_Insert(benchmark::State& state) {
+    auto keys = randomKeys(state.range(0), 1);
+    for (auto _: state) {
+        Map map;
+        for (uint64_t k: keys) {
+            map[k] = k;
+        }
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <typename Map>
+static void BM_FindHit(benchmark::State& state) {
+    auto keys = randomKeys(state.range(0), 1);
+    Map map;
+    for (uint64_t k: keys) {
+        map[k] = k;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(2));
+    for (auto _: state) {
+        uint64_t sum = 0;
+        for (uint64_t k: keys) {
+            sum += map.find(k)->second;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <typename Map>
+static void BM_FindMiss(benchmark::State& state) {
+    auto keys = randomKeys(state.range(0), 1);
+    auto misses = randomKeys(state.range(0), 3);
+    Map map;
+    for (uint64_t k: keys) {
+        map[k] = k;
+    }
+    for (auto _: state) {
+        size_t found = 0;
+        for (uint64_t k: misses) {
+            found += map.find(k) != map.end();
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * misses.size());
+}
+
+template <typename Map>
+static void BM_EraseInsertChurn(benchmark::State& state) {
+    auto keys = randomKeys(state.range(0), 1);
+    Map map;
+    for (uint64_t k: keys) {
+        map[k] = k;
+    }
+    size_t i = 0;
+    for (auto _: state) {
+        uint64_t k = keys[i++ % keys.size()];
+        map.erase(k);
+        map[k] = k;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+using Chained = Hashmap<uint64_t, uint64_t>;
+using Swiss = SwissHashmap<uint64_t, uint64_t>;
+using StdMap = std::unordered_map<uint64_t, uint64_t>;
+
+#define HASHMAP_BENCH(fn) \
+    BENCHMARK_TEMPLATE(fn, Chained)->RangeMultiplier(32)->Range(1 << 10, 1 << 20); \
+    BENCHMARK_TEMPLATE(fn, Swiss)->RangeMultiplier(32)->Range(1 << 10, 1 << 20); \
+    BENCHMARK_TEMPLATE(fn, StdMap)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)
+
+HASHMAP_BENCH(BM_Insert);
+HASHMAP_BENCH(BM_FindHit);
+HASHMAP_BENCH(BM_FindMiss);
+HASHMAP_BENCH(BM_EraseInsertChurn);
+
+// ---- insert tail latency: stop the world rehash vs incremental rehash ----
+// times every single insert and reports the percentiles, the mean barely moves but p999 / max
+// show the rehash stall (step 0 = stop the world, otherwise the minimum buckets moved per operation).
+// 1 to 3 is where a fixed step used to be too small to finish before the next doubling (it needs ~2.2),
+// so those are the ones to watch: with the step sized from the inserts left their max should match 4 and 16
+
+static void BM_InsertLatency(benchmark::State& state) {
+    const size_t n = 1 << 21;
+    auto keys = randomKeys(n, 1);
+    std::vector<uint64_t> latencies(n);
+    for (auto _: state) {
+        Hashmap<uint64_t, uint64_t> map;
+        map.set_incremental_rehash(state.range(0));
+        for (size_t i = 0; i < n; i++) {
+            auto start = std::chrono::steady_clock::now();
+            map[keys[i]] = i;
+            auto stop = std::chrono::steady_clock::now();
+            latencies[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+        }
+        benchmark::DoNotOptimize(map.size());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    state.counters["p50_ns"] = latencies[n / 2];
+    state.counters["p99_ns"] = latencies[n * 99 / 100];
+    state.counters["p999_ns"] = latencies[n * 999 / 1000];
+    state.counters["max_ns"] = latencies[n - 1];
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_InsertLatency)->ArgName("step")->Arg(0)->Arg(1)->Arg(2)->Arg(3)->Arg(4)->Arg(16)
+    ->Iterations(1)->Unit(benchmark::kMillisecond);
+
+// ---- multi threaded throughput: one big mutex around Hashmap vs ConcurrentHashmap ----
+// 90% lookups / 10% upserts on a pre filled map, every thread uses its own random key stream
+
+namespace {
+
+constexpr size_t kSharedKeys = 1 << 20;
+
+// what everyone does today, the whole map behind a single mutex
+struct GlobalLockHashmap {
+    std::mutex mtx;
+    Hashmap<uint64_t, uint64_t> map;
+
+    bool find(uint64_t key, uint64_t& out) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = map.find(key);
+        if (it == map.end()) {
+            return false;
+        }
+        out = it->second;
+        return true;
+    }
+
+    void upsert(uint64_t key) {
+        std::lock_guard<std::mutex> lock(mtx);
+        map[key]++;
+    }
+};
+
+struct ShardedHashmap {
+    ConcurrentHashmap<uint64_t, uint64_t> map{256};
+
+    bool find(uint64_t key, uint64_t& out) {
+        return map.find(key, out);
+    }
+
+    void upsert(uint64_t key) {
+        map.upsert(key, [](uint64_t& v) { v++; }, 1);
+    }
+};
+
+template <typename Map>
+Map& sharedMap() {
+    static Map* map = [] {
+        auto* m = new Map();
+        for (uint64_t k = 0; k < kSharedKeys; k++) {
+            m->upsert(k);
+        }
+        return m;
+    }();
+    return *map;
+}
+
+} // namespace
+
+template <typename Map>
+static void BM_MixedThroughput(benchmark::State& state) {
+    Map& map = sharedMap<Map>();
+    std::mt19937_64 rng(state.thread_index());
+    uint64_t sink = 0;
+    for (auto _: state) {
+        uint64_t key = rng() % kSharedKeys;
+        if (key % 10 == 0) {
+            map.upsert(key);
+        } else {
+            map.find(key, sink);
+        }
+    }
+    benchmark::DoNotOptimize(sink);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_MixedThroughput, GlobalLockHashmap)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MixedThroughput, ShardedHashmap)->ThreadRange(1, 64)->UseRealTime();
+
+// ---- N sequential finds vs one find_batch on a table much bigger than the LLC ----
+
+namespace {
+
+Hashmap<uint64_t, uint64_t>& bigMap(size_t n) {
+    static size_t builtFor = 0;
+    static Hashmap<uint64_t, uint64_t>* map = nullptr;
+    if (builtFor != n) {
+        delete map;
+        map = new Hashmap<uint64_t, uint64_t>();
+        map->rehash(n * 2);
+        for (uint64_t k: randomKeys(n, 1)) {
+            (*map)[k] = k;
+        }
+        builtFor = n;
+    }
+    return *map;
+}
+
+} // namespace
+
+static void BM_SequentialFind(benchmark::State& state) {
+    auto& map = bigMap(state.range(0));
+    auto keys = randomKeys(state.range(0), 1);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(2));
+    const size_t batch = state.range(1);
+    size_t offset = 0;
+    for (auto _: state) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < batch; i++) {
+            sum += map.find(keys[offset + i])->second;
+        }
+        // new keys every iteration, otherwise after the first pass theyre all cached
+        offset = (offset + batch) % (keys.size() - batch);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+
+static void BM_FindBatch(benchmark::State& state) {
+    auto& map = bigMap(state.range(0));
+    auto keys = randomKeys(state.range(0), 1);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(2));
+    const size_t batch = state.range(1);
+    std::vector<uint64_t*> out(batch);
+    size_t offset = 0;
+    for (auto _: state) {
+        map.find_batch(std::span<const uint64_t>(keys.data() + offset, batch), out);
+        uint64_t sum = 0;
+        for (uint64_t* v: out) {
+            sum += *v;
+        }
+        offset = (offset + batch) % (keys.size() - batch);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+
+// 8M entries is ~700MB of nodes and buckets, 512 keys per request
+BENCHMARK(BM_SequentialFind)->Args({1 << 23, 512})->Args({1 << 16, 512});
+BENCHMARK(BM_FindBatch)->Args({1 << 23, 512})->Args({1 << 16, 512});
+
+// ---- bulk build: insert loop vs range constructor (sized once) vs parallel build ----
+
+namespace {
+
+std::vector<std::pair<uint64_t, uint64_t>> randomPairs(size_t n) {
+    std::vector<std::pair<uint64_t, uint64_t>> values;
+    values.reserve(n);
+    for (uint64_t k: randomKeys(n, 3)) {
+        values.emplace_back(k, k);
+    }
+    return values;
+}
+
+} // namespace
+
+static void BM_BuildInsertLoop(benchmark::State& state) {
+    auto values = randomPairs(state.range(0));
+    for (auto _: state) {
+        Hashmap<uint64_t, uint64_t> map;
+        for (const auto& value: values) {
+            map.insert(value);
+        }
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+static void BM_BuildRangeConstructor(benchmark::State& state) {
+    auto values = randomPairs(state.range(0));
+    for (auto _: state) {
+        Hashmap<uint64_t, uint64_t> map(values.begin(), values.end());
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+// range(1) is the thread count, only shows a speedup on a machine with that many cores
+static void BM_BuildParallel(benchmark::State& state) {
+    auto values = randomPairs(state.range(0));
+    for (auto _: state) {
+        Hashmap<uint64_t, uint64_t> map;
+        map.insert_range_parallel(values, state.range(1));
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+BENCHMARK(BM_BuildInsertLoop)->Arg(1 << 22)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_BuildRangeConstructor)->Arg(1 << 22)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_BuildParallel)->Args({1 << 22, 1})->Args({1 << 22, 4})->Args({1 << 22, 16})
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// ---- cold start: rebuild the table vs map a snapshot of it, then serve 1000 lookups ----
+
+static void BM_ColdStartRebuild(benchmark::State& state) {
+    auto values = randomPairs(state.range(0));
+    for (auto _: state) {
+        Hashmap<uint64_t, uint64_t> map(values.begin(), values.end());
+        uint64_t sum = 0;
+        for (size_t i = 0; i < 1000; i++) {
+            sum += map.find(values[i].first)->second;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+static void BM_ColdStartMapped(benchmark::State& state) {
+    auto values = randomPairs(state.range(0));
+    const std::string path = "/tmp/hashmap_bench.snap";
+    serialize(Hashmap<uint64_t, uint64_t>(values.begin(), values.end()), path);
+    for (auto _: state) {
+        MappedHashmap<uint64_t, uint64_t> map(path);
+        uint64_t sum = 0;
+        for (size_t i = 0; i < 1000; i++) {
+            sum += *map.find(values[i].first);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    std::remove(path.c_str());
+}
+
+BENCHMARK(BM_ColdStartRebuild)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ColdStartMapped)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+
+// ---- bucket index policies against adversarial key patterns ----
+// range(0): 0 = sequential ids, 1 = stride of 1024, 2 = clusters of 64 consecutive ids spaced 65536 apart,
+// 3 = random (the baseline, every policy spreads these evenly so only the cost of the index shows)
+// all with std::hash<uint64_t>, ie the identity. max_chain shows how badly the pattern clusters.
+
+namespace {
+
+std::vector<uint64_t> patternKeys(int pattern, size_t n) {
+    if (pattern == 3) {
+        return randomKeys(n, 1);
+    }
+    std::vector<uint64_t> keys(n);
+    for (size_t i = 0; i < n; i++) {
+        switch (pattern) {
+        case 0: keys[i] = i; break;
+        case 1: keys[i] = i * 1024; break;
+        default: keys[i] = (i / 64) * 65536 + i % 64; break;
+        }
+    }
+    return keys;
+}
+
+} // namespace
+
+template <typename IndexPolicy>
+static void BM_KeyPatternFind(benchmark::State& state) {
+    auto keys = patternKeys(state.range(0), state.range(1));
+    Hashmap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+            std::allocator<std::pair<const uint64_t, uint64_t>>, IndexPolicy> map;
+    for (uint64_t k: keys) {
+        map[k] = k;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(2));
+    for (auto _: state) {
+        uint64_t sum = 0;
+        for (uint64_t k: keys) {
+            sum += map.find(k)->second;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.counters["max_chain"] = map.stats().maxChainLength;
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+#define KEY_PATTERN_BENCH(policy) \
+    BENCHMARK_TEMPLATE(BM_KeyPatternFind, policy)->ArgsProduct({{0, 1, 2, 3}, {1 << 12, 1 << 20}})
+
+// the unmixed modulo degrades to chains of hundreds on strided / clustered keys, at 1M keys one pass takes
+// most of a minute so its only run small
+BENCHMARK_TEMPLATE(BM_KeyPatternFind, ModuloIndex)->ArgsProduct({{0, 1, 2, 3}, {1 << 12}});
+KEY_PATTERN_BENCH(PrimeModuloIndex);
+KEY_PATTERN_BENCH(PowerOfTwoIndex);
+KEY_PATTERN_BENCH(FastRangeIndex);
+
+// ---- bounded caches on a Zipfian trace ----
+// 1M requests over 1M distinct keys, skew 0.99 (a typical web / key value cache shape).
+// range(0) = cache capacity. hit_ratio is the fraction of gets that hit, misses do a put.
+
+namespace {
+
+// inverse CDF sampling, rank 0 is the most popular key. ranks get scrambled into keys so the popular
+// ones arent all small numbers
+const std::vector<uint64_t>& zipfTrace() {
+    static const std::vector<uint64_t> trace = [] {
+        const size_t universe = 1 << 20;
+        const size_t requests = 1 << 20;
+        std::vector<double> cdf(universe);
+        double sum = 0;
+        for (size_t i = 0; i < universe; i++) {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), 0.99);
+            cdf[i] = sum;
+        }
+        std::mt19937_64 rng(5);
+        std::uniform_real_distribution<double> uniform(0, sum);
+        std::vector<uint64_t> result(requests);
+        for (auto& key: result) {
+            uint64_t rank = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+            key = rank * 0x9E3779B97F4A7C15ULL;
+        }
+        return result;
+    }();
+    return trace;
+}
+
+// the "bolted on" LRU this replaces: a Hashmap of list iterators next to a separate std::list
+class ExternalLru {
+public:
+    explicit ExternalLru(size_t capacity): mCapacity(capacity) {}
+
+    uint64_t* get(uint64_t key) {
+        auto it = mMap.find(key);
+        if (it == mMap.end()) {
+            return nullptr;
+        }
+        mOrder.splice(mOrder.begin(), mOrder, it->second);
+        return &it->second->second;
+    }
+
+    void put(uint64_t key, uint64_t value) {
+        if (mMap.size() == mCapacity) {
+            mMap.erase(mOrder.back().first);
+            mOrder.pop_back();
+        }
+        mOrder.emplace_front(key, value);
+        mMap.insert({key, mOrder.begin()});
+    }
+
+private:
+    size_t mCapacity;
+    std::list<std::pair<uint64_t, uint64_t>> mOrder;
+    Hashmap<uint64_t, std::list<std::pair<uint64_t, uint64_t>>::iterator> mMap;
+};
+
+using LruCache = CacheHashmap<uint64_t, uint64_t, CachePolicy::Lru>;
+using ClockCache = CacheHashmap<uint64_t, uint64_t, CachePolicy::Clock>;
+
+} // namespace
+
+template <typename Cache>
+static void BM_ZipfCache(benchmark::State& state) {
+    const auto& trace = zipfTrace();
+    size_t hits = 0;
+    size_t requests = 0;
+    for (auto _: state) {
+        Cache cache(state.range(0));
+        for (uint64_t key: trace) {
+            if (uint64_t* value = cache.get(key)) {
+                benchmark::DoNotOptimize(*value);
+                hits++;
+            } else {
+                cache.put(key, key);
+            }
+        }
+        requests += trace.size();
+    }
+    state.counters["hit_ratio"] = static_cast<double>(hits) / requests;
+    state.SetItemsProcessed(requests);
+}
+
+BENCHMARK_TEMPLATE(BM_ZipfCache, ExternalLru)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 17)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ZipfCache, LruCache)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 17)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_ZipfCache, ClockCache)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 17)->Unit(benchmark::kMillisecond);
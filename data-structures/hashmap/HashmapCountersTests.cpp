@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+// this test binary turns the counters on, everything else is built with them off
+#define HASHMAP_COUNTERS 1
+#include "Hashmap.hpp"
+
+TEST(HashmapCountersTest, CountsOperationsAndProbes) {
+    Hashmap<int, int> map;
+    for (int i = 0; i < 100; ++i) {
+        map[i] = i;
+    }
+    map.reset_counters();
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_NE(map.find(i), map.end());
+    }
+    EXPECT_EQ(map.find(1000), map.end());
+    map.insert({5, 50});
+    EXPECT_TRUE(map.erase(5));
+
+    auto stats = map.stats();
+    EXPECT_EQ(stats.finds, 101);
+    // every hit compares against at least its own key
+    EXPECT_GE(stats.findProbes, 100);
+    EXPECT_EQ(stats.inserts, 1);
+    EXPECT_GE(stats.insertProbes, 1);
+    EXPECT_EQ(stats.erases, 1);
+    EXPECT_GE(stats.eraseProbes, 1);
+    EXPECT_EQ(stats.rehashes, 0);
+}
+
+TEST(HashmapCountersTest, CountsRehashes) {
+    Hashmap<int, int> map;
+    for (int i = 0; i < 1000; ++i) {
+        map[i] = i;
+    }
+    auto stats = map.stats();
+    // 1, 2, 4, ... doublings to get past 1000 / 0.7
+    EXPECT_GE(stats.rehashes, 10);
+    EXPECT_GT(stats.rehashNanos, 0);
+
+    Hashmap<int, int> incremental;
+    incremental.set_incremental_rehash(4);
+    for (int i = 0; i < 1000; ++i) {
+        incremental[i] = i;
+    }
+    EXPECT_GE(incremental.stats().rehashes, 10);
+    EXPECT_GT(incremental.stats().rehashNanos, 0);
+}
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
+#include <ranges>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "Hashmap.hpp"
 
 // DeepSeek Generated Tests
@@ -177,4 +181,382 @@ TEST(HashmapTest, ComplexValueType) {
     EXPECT_EQ(map[2].size(), 3);
     EXPECT_EQ(map[1][0], 1);
     EXPECT_EQ(map[2][2], 6);
-}
\ No newline at end of file
+}
+TEST(HashmapTest, IncrementalRehashKeepsEverythingReachable) {
+    Hashmap<int, int> map;
+    map.set_incremental_rehash(1);
+
+    bool sawRehash = false;
+    for (int i = 0; i < 5000; ++i) {
+        map[i] = i;
+        sawRehash = sawRehash || map.is_rehashing();
+        // every key inserted so far has to be found no matter which table its in
+        if (map.is_rehashing() && i % 97 == 0) {
+            for (int j = 0; j <= i; ++j) {
+                ASSERT_TRUE(map.contains(j)) << j;
+            }
+        }
+    }
+    EXPECT_TRUE(sawRehash);
+    EXPECT_EQ(map.size(), 5000);
+    map.complete_rehash();
+    EXPECT_FALSE(map.is_rehashing());
+    for (int i = 0; i < 5000; ++i) {
+        EXPECT_EQ(map.at(i), i);
+    }
+}
+
+TEST(HashmapTest, IncrementalRehashFinishesBeforeTheNextGrow) {
+    // insert only is the worst case, no finds in between to do extra steps
+    for (size_t step : {1, 2, 3}) {
+        Hashmap<int, int> map;
+        map.set_incremental_rehash(step);
+        int grows = 0;
+        for (int i = 0; i < 200000; ++i) {
+            size_t buckets = map.bucket_count();
+            bool wasRehashing = map.is_rehashing();
+            map[i] = i;
+            // the first few doublings of a tiny table come one or two inserts apart, finishing those in
+            // the grow costs nothing
+            if (map.bucket_count() != buckets && buckets >= 64) {
+                grows++;
+                // still rehashing here would mean grow() had to complete_rehash() synchronously
+                ASSERT_FALSE(wasRehashing) << "step " << step << " at " << i;
+            }
+        }
+        EXPECT_GT(grows, 10);
+    }
+}
+
+TEST(HashmapTest, IncrementalRehashIterationAndErase) {
+    Hashmap<int, std::string> map;
+    map.set_incremental_rehash(2);
+    int i = 0;
+    // stop as soon as we are in the middle of moving buckets over
+    while (!map.is_rehashing() || map.find(0) == map.end() || i < 100) {
+        map[i] = std::to_string(i);
+        ++i;
+        if (map.is_rehashing() && i > 100) {
+            break;
+        }
+    }
+    ASSERT_TRUE(map.is_rehashing());
+    map.find(0); // one more step so both tables have elements
+
+    int count = 0;
+    for (const auto& [key, value] : map) {
+        EXPECT_EQ(value, std::to_string(key));
+        ++count;
+    }
+    EXPECT_EQ(count, i);
+
+    for (int k = 0; k < i; k += 2) {
+        EXPECT_TRUE(map.erase(k));
+    }
+    EXPECT_EQ(map.size(), static_cast<size_t>(i / 2));
+    for (int k = 0; k < i; ++k) {
+        EXPECT_EQ(map.contains(k), k % 2 == 1);
+    }
+}
+
+TEST(HashmapTest, RehashKeepsValueAddresses) {
+    Hashmap<int, std::string> map;
+    map[1] = "one";
+    std::string* addr = &map[1];
+    for (int i = 2; i < 1000; ++i) {
+        map[i] = "x";
+    }
+    EXPECT_EQ(&map[1], addr);
+
+    Hashmap<int, std::string> incremental;
+    incremental.set_incremental_rehash(1);
+    incremental[1] = "one";
+    addr = &incremental[1];
+    for (int i = 2; i < 1000; ++i) {
+        incremental[i] = "x";
+    }
+    EXPECT_EQ(&incremental[1], addr);
+}
+
+TEST(HashmapTest, MoveConstructorMidRehash) {
+    Hashmap<int, int> map;
+    map.set_incremental_rehash(1);
+    for (int i = 0; i < 200 && !(map.is_rehashing() && i > 50); ++i) {
+        map[i] = i;
+    }
+    size_t size = map.size();
+    Hashmap<int, int> moved(std::move(map));
+    EXPECT_EQ(moved.size(), size);
+    for (size_t i = 0; i < size; ++i) {
+        EXPECT_EQ(moved.at(static_cast<int>(i)), static_cast<int>(i));
+    }
+    Hashmap<int, int> copy(moved);
+    EXPECT_EQ(copy.size(), size);
+}
+
+namespace {
+
+struct TransparentStringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+// counts how often it gets called, to check a key is only hashed once
+struct CountingHash {
+    static inline int calls = 0;
+    size_t operator()(int key) const {
+        calls++;
+        return std::hash<int>{}(key);
+    }
+};
+
+} // namespace
+
+TEST(HashmapTest, TransparentLookup) {
+    Hashmap<std::string, int, TransparentStringHash, std::equal_to<>> map;
+    map["alpha"] = 1;
+    map["beta"] = 2;
+
+    std::string_view view = "alpha";
+    auto it = map.find(view);
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ(it->second, 1);
+    EXPECT_TRUE(map.contains(std::string_view{"beta"}));
+    EXPECT_FALSE(map.contains(std::string_view{"gamma"}));
+    EXPECT_TRUE(map.erase(std::string_view{"beta"}));
+    EXPECT_EQ(map.size(), 1);
+}
+
+TEST(HashmapTest, PrecomputedHash) {
+    Hashmap<int, int, CountingHash> a;
+    Hashmap<int, int, CountingHash> b;
+    for (int i = 0; i < 100; ++i) {
+        a[i] = i;
+        b[i] = -i;
+    }
+
+    size_t hash = a.hash_function()(42);
+    CountingHash::calls = 0;
+    EXPECT_EQ(a.find(42, hash)->second, 42);
+    EXPECT_EQ(b.find(42, hash)->second, -42);
+    EXPECT_TRUE(std::as_const(a).contains(42, hash));
+    EXPECT_TRUE(b.erase(42, hash));
+    EXPECT_FALSE(b.contains(42, hash));
+    EXPECT_EQ(CountingHash::calls, 0);
+
+    // the plain overloads hash exactly once, erase included
+    a.erase(7);
+    EXPECT_EQ(CountingHash::calls, 1);
+}
+
+TEST(HashmapTest, FindBatch) {
+    Hashmap<int, int> map;
+    for (int i = 0; i < 1000; i += 2) {
+        map[i] = i * 10;
+    }
+
+    std::vector<int> keys;
+    for (int i = 0; i < 100; ++i) {
+        keys.push_back(i * 7);
+    }
+    std::vector<int*> out(keys.size());
+    map.find_batch(keys, out);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] % 2 == 0 && keys[i] < 1000) {
+            ASSERT_NE(out[i], nullptr);
+            EXPECT_EQ(*out[i], keys[i] * 10);
+            EXPECT_EQ(out[i], &map[keys[i]]);
+        } else {
+            EXPECT_EQ(out[i], nullptr);
+        }
+    }
+
+    const Hashmap<int, int> empty;
+    std::vector<const int*> constOut(keys.size(), &keys[0]);
+    empty.find_batch(keys, constOut);
+    for (const int* p : constOut) {
+        EXPECT_EQ(p, nullptr);
+    }
+}
+
+TEST(HashmapTest, InsertBatch) {
+    Hashmap<int, std::string> map;
+    std::vector<std::pair<const int, std::string>> values;
+    for (int i = 0; i < 500; ++i) {
+        values.emplace_back(i % 300, std::to_string(i));
+    }
+    map.insert_batch(values);
+    // duplicates overwrite, same as insert
+    EXPECT_EQ(map.size(), 300);
+    EXPECT_EQ(map.at(0), "300");
+    EXPECT_EQ(map.at(299), "299");
+}
+
+TEST(HashmapTest, RangeConstructorSizesOnce) {
+    std::vector<std::pair<int, int>> values;
+    for (int i = 0; i < 1000; ++i) {
+        values.emplace_back(i, i * 2);
+    }
+    Hashmap<int, int> map(values.begin(), values.end());
+    EXPECT_EQ(map.size(), 1000);
+    EXPECT_EQ(map.at(999), 1998);
+
+    // reserve makes sure inserting that many more never rehashes
+    Hashmap<int, int> reserved;
+    reserved.reserve(1000);
+    size_t buckets = reserved.bucket_count();
+    for (int i = 0; i < 1000; ++i) {
+        reserved[i] = i;
+    }
+    EXPECT_EQ(reserved.bucket_count(), buckets);
+}
+
+TEST(HashmapTest, InsertRangeMovesFromRvalues) {
+    Hashmap<std::string, std::string> map = {{"a", "old"}};
+    std::vector<std::pair<std::string, std::string>> values = {{"a", "new"}, {"b", std::string(100, 'x')}};
+    map.insert_range(std::move(values));
+    EXPECT_EQ(map.size(), 2);
+    EXPECT_EQ(map.at("a"), "new");
+    EXPECT_EQ(map.at("b"), std::string(100, 'x'));
+    EXPECT_TRUE(values[1].first.empty());
+    EXPECT_TRUE(values[1].second.empty());
+
+    // lvalue ranges get copied
+    std::vector<std::pair<const std::string, std::string>> more = {{"c", "c"}};
+    map.insert_range(more);
+    EXPECT_EQ(more[0].second, "c");
+    EXPECT_EQ(map.at("c"), "c");
+}
+
+TEST(HashmapTest, InsertRangeCopiesFromViews) {
+    std::vector<std::pair<std::string, std::string>> src = {
+        {"a", std::string(100, 'a')}, {"b", std::string(100, 'b')}, {"c", std::string(100, 'c')}};
+    Hashmap<std::string, std::string> map;
+    // rvalue span and rvalue views, but the elements belong to src
+    map.insert_range(std::span(src).first(1));
+    map.insert_range(std::views::take(src, 2));
+    map.insert_range(src | std::views::drop(2) | std::views::filter([](const auto&) { return true; }));
+    EXPECT_EQ(map.size(), 3);
+    for (const auto& [key, value] : src) {
+        EXPECT_EQ(value, std::string(100, key[0]));
+        EXPECT_EQ(map.at(key), value);
+    }
+
+    // elements made on the fly are fine to move
+    std::vector<int> numbers = {1, 2};
+    map.insert_range(numbers | std::views::transform([](int i) {
+        return std::pair<std::string, std::string>(std::to_string(i), std::string(50, 'n'));
+    }));
+    EXPECT_EQ(map.at("2"), std::string(50, 'n'));
+}
+
+TEST(HashmapTest, ParallelBuildMatchesSequential) {
+    std::vector<std::pair<int, int>> values;
+    for (int i = 0; i < 50000; ++i) {
+        values.emplace_back((i * 7919) % 30000, i);
+    }
+    Hashmap<int, int> sequential;
+    sequential.insert_range(values);
+
+    Hashmap<int, int> parallel = {{-1, -1}};
+    parallel.insert_range_parallel(values, 4);
+    EXPECT_EQ(parallel.size(), sequential.size() + 1);
+    for (const auto& [key, value] : sequential) {
+        // later duplicates win in both
+        EXPECT_EQ(parallel.at(key), value);
+    }
+    EXPECT_EQ(parallel.at(-1), -1);
+}
+
+namespace {
+
+// puts every key in one of 4 buckets
+struct ClusteringHash {
+    size_t operator()(int key) const { return static_cast<size_t>(key % 4); }
+};
+
+} // namespace
+
+TEST(HashmapTest, StatsShowChainLengths) {
+    Hashmap<int, int> good;
+    Hashmap<int, int, ClusteringHash> bad;
+    for (int i = 0; i < 1000; ++i) {
+        good[i] = i;
+        bad[i] = i;
+    }
+
+    auto goodStats = good.stats();
+    EXPECT_EQ(goodStats.size, 1000);
+    EXPECT_EQ(goodStats.bucketCount, good.bucket_count());
+    EXPECT_LT(goodStats.loadFactor, 0.7);
+    EXPECT_LE(goodStats.maxChainLength, 2);
+    size_t buckets = 0;
+    size_t elements = 0;
+    for (size_t length = 0; length < goodStats.chainLengthHistogram.size(); ++length) {
+        buckets += goodStats.chainLengthHistogram[length];
+        elements += length * goodStats.chainLengthHistogram[length];
+    }
+    EXPECT_EQ(buckets, good.bucket_count());
+    EXPECT_EQ(elements, 1000);
+    EXPECT_GT(goodStats.bytesUsed, 1000 * sizeof(std::pair<const int, int>));
+
+    auto badStats = bad.stats();
+    EXPECT_EQ(badStats.maxChainLength, 250);
+    EXPECT_DOUBLE_EQ(badStats.meanChainLength, 250.0);
+    // counters are compiled out by default
+    EXPECT_EQ(badStats.finds, 0);
+    EXPECT_EQ(badStats.rehashes, 0);
+}
+
+template <typename IndexPolicy>
+using PolicyMap = Hashmap<int, int, std::hash<int>, std::equal_to<int>, std::allocator<std::pair<const int, int>>,
+                          IndexPolicy>;
+
+template <typename IndexPolicy>
+class HashmapIndexPolicyTest : public testing::Test {};
+
+using IndexPolicies = testing::Types<ModuloIndex, PrimeModuloIndex, PowerOfTwoIndex, FastRangeIndex>;
+TYPED_TEST_SUITE(HashmapIndexPolicyTest, IndexPolicies);
+
+TYPED_TEST(HashmapIndexPolicyTest, InsertFindEraseWithIncrementalRehash) {
+    PolicyMap<TypeParam> map;
+    map.set_incremental_rehash(4);
+    for (int i = 0; i < 5000; ++i) {
+        map[i * 8] = i;
+    }
+    for (int i = 0; i < 5000; i += 2) {
+        EXPECT_TRUE(map.erase(i * 8));
+    }
+    EXPECT_EQ(map.size(), 2500);
+    for (int i = 0; i < 5000; ++i) {
+        EXPECT_EQ(map.contains(i * 8), i % 2 == 1);
+    }
+    EXPECT_EQ(map.bucket_count(), TypeParam::bucketCountFor(map.bucket_count()));
+}
+
+TEST(HashmapTest, IndexPolicyBucketCounts) {
+    PolicyMap<PowerOfTwoIndex> pow2;
+    pow2.rehash(10);
+    EXPECT_EQ(pow2.bucket_count(), 16);
+    PolicyMap<PrimeModuloIndex> prime;
+    prime.rehash(10);
+    EXPECT_EQ(prime.bucket_count(), 11);
+    PolicyMap<FastRangeIndex> fastRange;
+    fastRange.rehash(10);
+    EXPECT_EQ(fastRange.bucket_count(), 10);
+}
+
+TEST(HashmapTest, MixingPoliciesSpreadStridedKeys) {
+    // with the identity hash and 1024 buckets, a stride of 1024 puts every key in bucket 0 under plain modulo
+    PolicyMap<ModuloIndex> modulo;
+    PolicyMap<PowerOfTwoIndex> pow2;
+    PolicyMap<FastRangeIndex> fastRange;
+    for (int i = 0; i < 500; ++i) {
+        modulo[i * 1024] = i;
+        pow2[i * 1024] = i;
+        fastRange[i * 1024] = i;
+    }
+    EXPECT_GT(modulo.stats().maxChainLength, 50);
+    EXPECT_LE(pow2.stats().maxChainLength, 8);
+    EXPECT_LE(fastRange.stats().maxChainLength, 8);
+}
@@ -0,0 +1,331 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+#include "Hashmap.hpp"
+
+// Snapshots of a Hashmap on disk, for K and V that are trivially copyable (ints, PODs, fixed size char arrays..)
+//
+// Rebuilding a big Hashmap on startup means allocating a list node per element and hashing every key again.
+// serialize() writes the table out as one flat image instead, and MappedHashmap mmaps that image and
+// answers find / contains straight out of the mapping: no parsing, no allocation, the pages get pulled in
+// lazily by the first lookups that touch them. Every process that maps the same file shares the same
+// physical pages through the page cache.
+//
+// The image is position independent (offsets, never pointers) and laid out like a chained table
+// whose chains are stored back to back (CSR layout):
+//
+//   [ SnapshotHeader, padded to 64 bytes ]
+//   [ uint64_t offsets[bucketCount + 1] ]     bucket b holds entries[offsets[b] .. offsets[b + 1])
+//   [ padding to 64 bytes ]
+//   [ Entry entries[size] ]                   grouped by bucket
+//
+// So a lookup is one read in offsets and then a short linear scan over contiguous entries.
+// The bucket is FastRangeIndex (HashPolicy.hpp) of the Hash you pass in, whatever the Hashmap itself used,
+// so the Hash has to give the same value in the process that reads the file as in the one that wrote it
+// (std::hash of integers does, anything seeded per process doesnt). The file is also native endian and
+// native layout, its not a portable exchange format.
+
+namespace snapshot_detail {
+
+constexpr char kMagic[8] = {'H', 'M', 'A', 'P', 'S', 'N', 'P', '1'};
+// 2: buckets picked with FastRangeIndex instead of hash % bucketCount
+constexpr uint32_t kVersion = 2;
+// reads back as a different number on a machine with the other byte order
+constexpr uint64_t kEndianCheck = 0x0102030405060708ULL;
+constexpr size_t kAlign = 64;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entrySize;
+    uint64_t endianCheck;
+    uint64_t keySize;
+    uint64_t valueSize;
+    uint64_t bucketCount;
+    uint64_t size;
+};
+
+constexpr size_t alignUp(size_t n) {
+    return (n + kAlign - 1) / kAlign * kAlign;
+}
+
+constexpr size_t offsetsStart() {
+    return alignUp(sizeof(SnapshotHeader));
+}
+
+constexpr size_t entriesStart(size_t bucketCount) {
+    return alignUp(offsetsStart() + (bucketCount + 1) * sizeof(uint64_t));
+}
+
+} // namespace snapshot_detail
+
+// One element of the image. Not a std::pair, pair isnt trivially copyable (it has its own operator=),
+// but the member names match so structured bindings and ->second read the same as with Hashmap.
+template <typename K, typename V>
+struct SnapshotEntry {
+    K first;
+    V second;
+};
+
+template <typename K, typename V>
+concept Snapshottable = std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>;
+
+// writes map to out in the format above, out should be opened in binary mode
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator, typename IndexPolicy>
+    requires Snapshottable<K, V>
+void serialize(const Hashmap<K, V, Hash, KeyEqual, Allocator, IndexPolicy>& map, std::ostream& out) {
+    using namespace snapshot_detail;
+    using Entry = SnapshotEntry<K, V>;
+
+    // about one entry per bucket, the image never grows so theres no reason to leave headroom
+    const size_t size = map.size();
+    const size_t bucketCount = size == 0 ? 1 : size;
+    const Hash& hash = map.hash_function();
+
+    // counting sort by bucket: count, prefix sum, then drop each entry into its slot
+    std::vector<uint64_t> offsets(bucketCount + 1, 0);
+    for (const auto& [key, value]: map) {
+        offsets[FastRangeIndex::index(hash(key), bucketCount) + 1]++;
+    }
+    for (size_t b = 0; b < bucketCount; b++) {
+        offsets[b + 1] += offsets[b];
+    }
+    // the padding bytes inside Entry would otherwise be whatever was on the heap, zero them so
+    // the same map always gives the same file
+    std::vector<Entry> entries(size);
+    if (size > 0) {
+        // data() is nullptr for an empty vector, and memset of nullptr is UB even for 0 bytes
+        std::memset(static_cast<void*>(entries.data()), 0, size * sizeof(Entry));
+    }
+    std::vector<uint64_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (const auto& [key, value]: map) {
+        Entry& entry = entries[cursor[FastRangeIndex::index(hash(key), bucketCount)]++];
+        std::memcpy(static_cast<void*>(&entry.first), &key, sizeof(K));
+        std::memcpy(static_cast<void*>(&entry.second), &value, sizeof(V));
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.entrySize = sizeof(Entry);
+    header.endianCheck = kEndianCheck;
+    header.keySize = sizeof(K);
+    header.valueSize = sizeof(V);
+    header.bucketCount = bucketCount;
+    header.size = size;
+
+    const char zeros[kAlign] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(zeros, offsetsStart() - sizeof(header));
+    out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    out.write(zeros, entriesStart(bucketCount) - offsetsStart() - offsets.size() * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(entries.data()), size * sizeof(Entry));
+    if (!out) {
+        throw std::runtime_error("serialize: write failed");
+    }
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Allocator, typename IndexPolicy>
+    requires Snapshottable<K, V>
+void serialize(const Hashmap<K, V, Hash, KeyEqual, Allocator, IndexPolicy>& map, const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("serialize: cant open " + path);
+    }
+    serialize(map, out);
+}
+
+// Read only Hashmap served straight out of an mmapped snapshot file.
+// Hash and KeyEqual have to be the ones the snapshot was written with.
+// Movable, not copyable (it owns the mapping). Lookups are const and never write, so any number of
+// threads can use one MappedHashmap at the same time.
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+    requires Snapshottable<K, V>
+class MappedHashmap {
+public:
+    using Entry = SnapshotEntry<K, V>;
+    using const_iterator = const Entry*;
+
+    // throws std::runtime_error if the file cant be mapped or isnt a snapshot of this K / V
+    explicit MappedHashmap(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("MappedHashmap: cant open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(snapshot_detail::SnapshotHeader))) {
+            ::close(fd);
+            throw std::runtime_error("MappedHashmap: " + path + " is not a snapshot");
+        }
+        mLength = static_cast<size_t>(st.st_size);
+        void* base = ::mmap(nullptr, mLength, PROT_READ, MAP_SHARED, fd, 0);
+        // the mapping keeps its own reference to the file
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("MappedHashmap: mmap failed for " + path);
+        }
+        mBase = static_cast<const char*>(base);
+        if (!validate()) {
+            unmap();
+            throw std::runtime_error("MappedHashmap: " + path + " is not a snapshot of this key / value type");
+        }
+    }
+
+    MappedHashmap(const MappedHashmap&) = delete;
+    MappedHashmap& operator=(const MappedHashmap&) = delete;
+
+    MappedHashmap(MappedHashmap&& other) noexcept {
+        swap(other);
+    }
+
+    MappedHashmap& operator=(MappedHashmap&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            swap(other);
+        }
+        return *this;
+    }
+
+    ~MappedHashmap() {
+        unmap();
+    }
+
+    // nullptr if the key isnt there
+    const V* find(const K& key) const {
+        size_t b = FastRangeIndex::index(mHash(key), mBucketCount);
+        for (const Entry* it = mEntries + mOffsets[b]; it != mEntries + mOffsets[b + 1]; ++it) {
+            if (mEqual(it->first, key)) {
+                return &it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    bool contains(const K& key) const {
+        return find(key) != nullptr;
+    }
+
+    const V& at(const K& key) const {
+        const V* value = find(key);
+        if (!value) {
+            throw std::out_of_range("Key not found");
+        }
+        return *value;
+    }
+
+    size_t size() const {
+        return mSize;
+    }
+
+    size_t bucket_count() const {
+        return mBucketCount;
+    }
+
+    // iterates the entries in bucket order
+    const_iterator begin() const {
+        return mEntries;
+    }
+
+    const_iterator end() const {
+        return mEntries + mSize;
+    }
+
+    std::span<const Entry> entries() const {
+        return {mEntries, mSize};
+    }
+
+    void swap(MappedHashmap& other) noexcept {
+        std::swap(mBase, other.mBase);
+        std::swap(mLength, other.mLength);
+        std::swap(mOffsets, other.mOffsets);
+        std::swap(mEntries, other.mEntries);
+        std::swap(mBucketCount, other.mBucketCount);
+        std::swap(mSize, other.mSize);
+    }
+
+private:
+    bool validate() {
+        using namespace snapshot_detail;
+        SnapshotHeader header;
+        std::memcpy(&header, mBase, sizeof(header));
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+            || header.endianCheck != kEndianCheck || header.keySize != sizeof(K) || header.valueSize != sizeof(V)
+            || header.entrySize != sizeof(Entry) || header.bucketCount == 0) {
+            return false;
+        }
+        // a truncated file would otherwise SIGBUS on the first lookup that touches the missing part. The sizes
+        // come from the file, so a corrupt header could make the products wrap around and look small
+        size_t entriesBytes;
+        size_t end;
+        if (header.bucketCount > mLength / sizeof(uint64_t)
+            || __builtin_mul_overflow(header.size, sizeof(Entry), &entriesBytes)
+            || __builtin_add_overflow(entriesStart(header.bucketCount), entriesBytes, &end) || end > mLength) {
+            return false;
+        }
+        mBucketCount = header.bucketCount;
+        mSize = header.size;
+        mOffsets = reinterpret_cast<const uint64_t*>(mBase + offsetsStart());
+        mEntries = reinterpret_cast<const Entry*>(mBase + entriesStart(mBucketCount));
+        // find() trusts offsets[b] .. offsets[b + 1] to be inside entries, so check them all once here.
+        // Reads the whole offsets array (8 bytes per bucket), the entries stay untouched until a lookup
+        if (mOffsets[0] != 0 || mOffsets[mBucketCount] != mSize) {
+            return false;
+        }
+        for (size_t b = 0; b < mBucketCount; b++) {
+            if (mOffsets[b] > mOffsets[b + 1]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void unmap() {
+        if (mBase) {
+            ::munmap(const_cast<char*>(mBase), mLength);
+        }
+        mBase = nullptr;
+        mLength = 0;
+        mOffsets = nullptr;
+        mEntries = nullptr;
+        mBucketCount = 0;
+        mSize = 0;
+    }
+
+    const char* mBase = nullptr;
+    size_t mLength = 0;
+    const uint64_t* mOffsets = nullptr;
+    const Entry* mEntries = nullptr;
+    size_t mBucketCount = 0;
+    size_t mSize = 0;
+    [[no_unique_address]] Hash mHash;
+    [[no_unique_address]] KeyEqual mEqual;
+};
+
+// Loads a snapshot back into an ordinary (mutable) Hashmap, sized once up front.
+//   auto map = deserialize<int, Point>("cache.snap");
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>,
+          typename Allocator = std::allocator<std::pair<const K, V>>>
+    requires Snapshottable<K, V>
+Hashmap<K, V, Hash, KeyEqual, Allocator> deserialize(const std::string& path, const Allocator& alloc = Allocator()) {
+    MappedHashmap<K, V, Hash, KeyEqual> mapped(path);
+    Hashmap<K, V, Hash, KeyEqual, Allocator> map(alloc);
+    map.reserve(mapped.size());
+    for (const auto& [key, value]: mapped) {
+        map.insert({key, value});
+    }
+    return map;
+}
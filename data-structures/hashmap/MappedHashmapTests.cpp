@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <utility>
+#include "MappedHashmap.hpp"
+
+namespace {
+
+struct Point {
+    int x;
+    double y;
+};
+
+std::string snapshotPath(const char* name) {
+    return testing::TempDir() + name;
+}
+
+} // namespace
+
+TEST(MappedHashmapTest, RoundTrip) {
+    Hashmap<int, Point> map;
+    for (int i = 0; i < 5000; ++i) {
+        map[i * 3] = Point{i, i * 0.5};
+    }
+    std::string path = snapshotPath("roundtrip.snap");
+    serialize(map, path);
+
+    MappedHashmap<int, Point> mapped(path);
+    EXPECT_EQ(mapped.size(), 5000);
+    for (int i = 0; i < 5000; ++i) {
+        const Point* p = mapped.find(i * 3);
+        ASSERT_NE(p, nullptr);
+        EXPECT_EQ(p->x, i);
+        EXPECT_EQ(p->y, i * 0.5);
+        EXPECT_FALSE(mapped.contains(i * 3 + 1));
+    }
+    EXPECT_THROW(mapped.at(-1), std::out_of_range);
+
+    size_t count = 0;
+    for (const auto& [key, value] : mapped) {
+        EXPECT_EQ(key, value.x * 3);
+        ++count;
+    }
+    EXPECT_EQ(count, 5000);
+
+    auto loaded = deserialize<int, Point>(path);
+    EXPECT_EQ(loaded.size(), 5000);
+    EXPECT_EQ(loaded.at(300).x, 100);
+    std::remove(path.c_str());
+}
+
+TEST(MappedHashmapTest, EmptyMapAndMove) {
+    Hashmap<long, long> map;
+    std::string path = snapshotPath("empty.snap");
+    serialize(map, path);
+
+    MappedHashmap<long, long> mapped(path);
+    EXPECT_EQ(mapped.size(), 0);
+    EXPECT_FALSE(mapped.contains(1));
+    EXPECT_EQ(mapped.begin(), mapped.end());
+
+    map[1] = 2;
+    serialize(map, path);
+    MappedHashmap<long, long> other(path);
+    mapped = std::move(other);
+    EXPECT_EQ(mapped.at(1), 2);
+    EXPECT_EQ(other.size(), 0);
+    std::remove(path.c_str());
+}
+
+TEST(MappedHashmapTest, RejectsWrongTypesAndBadFiles) {
+    Hashmap<int, int> map = {{1, 1}, {2, 2}};
+    std::string path = snapshotPath("wrongtype.snap");
+    serialize(map, path);
+    EXPECT_THROW((MappedHashmap<int, double>(path)), std::runtime_error);
+    EXPECT_THROW((MappedHashmap<int, int>(snapshotPath("does_not_exist.snap"))), std::runtime_error);
+
+    // cut off in the middle of the entries
+    std::string truncated = snapshotPath("truncated.snap");
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream out(truncated, std::ios::binary);
+        out.write(bytes.data(), bytes.size() - 4);
+    }
+    EXPECT_THROW((MappedHashmap<int, int>(truncated)), std::runtime_error);
+    std::remove(path.c_str());
+    std::remove(truncated.c_str());
+}
+
+namespace {
+
+// rewrites part of a snapshot file in place
+void patch(const std::string& path, size_t offset, const void* bytes, size_t n) {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(n));
+}
+
+} // namespace
+
+TEST(MappedHashmapTest, RejectsCorruptHeadersAndOffsets) {
+    using namespace snapshot_detail;
+    Hashmap<int, int> map;
+    for (int i = 0; i < 100; ++i) {
+        map[i] = i;
+    }
+    std::string path = snapshotPath("corrupt.snap");
+    auto fresh = [&] {
+        serialize(map, path);
+        MappedHashmap<int, int> ok(path);
+        return ok.bucket_count();
+    };
+
+    // size so big that size * sizeof(Entry) wraps around to something that fits in the file
+    fresh();
+    uint64_t hugeSize = (uint64_t{1} << 63) + 1;
+    patch(path, offsetof(SnapshotHeader, size), &hugeSize, sizeof(hugeSize));
+    EXPECT_THROW((MappedHashmap<int, int>(path)), std::runtime_error);
+
+    // offsets that go backwards would make find() scan outside the entries
+    size_t buckets = fresh();
+    uint64_t backwards = 1000;
+    patch(path, offsetsStart() + (buckets / 2) * sizeof(uint64_t), &backwards, sizeof(backwards));
+    EXPECT_THROW((MappedHashmap<int, int>(path)), std::runtime_error);
+
+    // first offset has to be 0
+    fresh();
+    uint64_t one = 1;
+    patch(path, offsetsStart(), &one, sizeof(one));
+    EXPECT_THROW((MappedHashmap<int, int>(path)), std::runtime_error);
+    std::remove(path.c_str());
+}
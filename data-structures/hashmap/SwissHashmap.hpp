@@ -0,0 +1,615 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "HashPolicy.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Not thread safe
+
+// Open addressing hashmap in the style of abseil's flat_hash_map ("swiss table").
+// Same API as Hashmap (the chained one), so you pick the backend per instantiation:
+//   Hashmap<K, V>       -> seperate chaining, stable node addresses, one heap alloc per insert
+//   SwissHashmap<K, V>  -> everything lives in two flat arrays, no per insert allocation
+//
+// Layout:
+//   mCtrl  -> one control byte per slot, tells you if the slot is empty / deleted / full
+//   mSlots -> the actual key value pairs, same index as the control byte
+//
+// The hash is split in two:
+//   H1 = top 57 bits -> which group to start probing from
+//   H2 = low 7 bits  -> stored in the control byte of a full slot
+// A lookup loads a whole group of control bytes at once (16 with SSE2, 32 with AVX2) and compares
+// all of them against H2 in one instruction. Only slots whose control byte matches get their key compared,
+// so most of the time we touch one cache line of metadata and one slot.
+//
+// Transparent Hash / KeyEqual and the precomputed hash overloads work exactly like in Hashmap.
+
+namespace swiss_detail {
+
+// control byte values, full slots hold H2 which is 0..127 so the sign bit tells full vs not full
+enum Ctrl : int8_t {
+    kEmpty = -128,   // 0b10000000
+    kDeleted = -2,   // 0b11111110 (tombstone)
+};
+
+// iterates over the set bits of a mask, Shift is log2 of how many bits each slot takes up in the mask
+// (1 bit per slot for movemask, 8 bits per slot for the portable version)
+template <typename T, int Shift>
+class BitMask {
+public:
+    explicit BitMask(T mask): mMask(mask) {}
+
+    explicit operator bool() const { return mMask != 0; }
+
+    // index of the lowest slot that is set
+    uint32_t lowest() const {
+        return static_cast<uint32_t>(__builtin_ctzll(static_cast<unsigned long long>(mMask))) >> Shift;
+    }
+
+    // so u can range for over the matching slots
+    BitMask& operator++() {
+        mMask &= (mMask - 1);
+        return *this;
+    }
+    uint32_t operator*() const { return lowest(); }
+    BitMask begin() const { return *this; }
+    BitMask end() const { return BitMask(0); }
+    friend bool operator!=(const BitMask& a, const BitMask& b) { return a.mMask != b.mMask; }
+
+private:
+    T mMask;
+};
+
+#if defined(__AVX2__)
+
+struct Group {
+    static constexpr size_t kWidth = 32;
+    using Mask = BitMask<uint32_t, 0>;
+
+    explicit Group(const int8_t* ctrl) {
+        // ctrl is always kWidth aligned, see SwissHashmap::allocate
+        mCtrl = _mm256_load_si256(reinterpret_cast<const __m256i*>(ctrl));
+    }
+
+    Mask match(uint8_t h2) const {
+        __m256i target = _mm256_set1_epi8(static_cast<char>(h2));
+        return Mask(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(target, mCtrl))));
+    }
+
+    Mask matchEmpty() const {
+        __m256i empty = _mm256_set1_epi8(kEmpty);
+        return Mask(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(empty, mCtrl))));
+    }
+
+    // empty and deleted both have the sign bit set, full slots dont
+    Mask matchEmptyOrDeleted() const {
+        return Mask(static_cast<uint32_t>(_mm256_movemask_epi8(mCtrl)));
+    }
+
+    __m256i mCtrl;
+};
+
+#elif defined(__SSE2__)
+
+struct Group {
+    static constexpr size_t kWidth = 16;
+    using Mask = BitMask<uint32_t, 0>;
+
+    explicit Group(const int8_t* ctrl) {
+        mCtrl = _mm_load_si128(reinterpret_cast<const __m128i*>(ctrl));
+    }
+
+    Mask match(uint8_t h2) const {
+        __m128i target = _mm_set1_epi8(static_cast<char>(h2));
+        return Mask(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(target, mCtrl))));
+    }
+
+    Mask matchEmpty() const {
+        __m128i empty = _mm_set1_epi8(kEmpty);
+        return Mask(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(empty, mCtrl))));
+    }
+
+    Mask matchEmptyOrDeleted() const {
+        return Mask(static_cast<uint32_t>(_mm_movemask_epi8(mCtrl)));
+    }
+
+    __m128i mCtrl;
+};
+
+#else
+
+// portable fallback: treat 8 control bytes as one uint64_t and do the compares with bit tricks (SWAR)
+struct Group {
+    static constexpr size_t kWidth = 8;
+    using Mask = BitMask<uint64_t, 3>;
+    static constexpr uint64_t kLsbs = 0x0101010101010101ULL;
+    static constexpr uint64_t kMsbs = 0x8080808080808080ULL;
+
+    explicit Group(const int8_t* ctrl) {
+        std::memcpy(&mCtrl, ctrl, sizeof(mCtrl));
+    }
+
+    // can give false positives, thats fine because we compare the keys anyway
+    Mask match(uint8_t h2) const {
+        uint64_t x = mCtrl ^ (kLsbs * h2);
+        return Mask((x - kLsbs) & ~x & kMsbs);
+    }
+
+    // empty is 0b10000000 and deleted is 0b11111110, bit 1 tells them apart
+    Mask matchEmpty() const {
+        return Mask(mCtrl & ~(mCtrl << 6) & kMsbs);
+    }
+
+    Mask matchEmptyOrDeleted() const {
+        return Mask(mCtrl & kMsbs);
+    }
+
+    uint64_t mCtrl;
+};
+
+#endif
+
+} // namespace swiss_detail
+
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class SwissHashmap {
+private:
+    using value_type = std::pair<const K, V>;
+    using Group = swiss_detail::Group;
+    static constexpr size_t kGroupWidth = Group::kWidth;
+
+public:
+    // walks the control bytes and stops at every full slot
+    template <bool IsConst>
+    struct Iterator {
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using pointer = typename std::conditional<IsConst, const value_type*, value_type*>::type;
+        using reference = typename std::conditional<IsConst, const value_type&, value_type&>::type;
+
+        Iterator(const int8_t* ctrl, value_type* slots, size_t idx, size_t capacity):
+                mCtrl(ctrl), mSlots(slots), mIdx(idx), mCapacity(capacity) {}
+
+        reference operator*() const {
+            return mSlots[mIdx];
+        }
+
+        pointer operator->() const { return &mSlots[mIdx]; }
+
+        Iterator& operator++() {
+            next();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator tmp{*this};
+            next();
+            return tmp;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) {
+            return a.mIdx == b.mIdx;
+        }
+
+        friend bool operator!=(const Iterator& a, const Iterator& b) {
+            return !(a == b);
+        }
+
+    private:
+        friend class SwissHashmap;
+
+        void next() {
+            mIdx++;
+            // full slots have the sign bit clear
+            while (mIdx < mCapacity && mCtrl[mIdx] < 0) {
+                mIdx++;
+            }
+        }
+
+        const int8_t* mCtrl;
+        value_type* mSlots;
+        size_t mIdx;
+        size_t mCapacity;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    SwissHashmap() = default;
+
+    SwissHashmap(std::initializer_list<value_type> lst) {
+        rehash(lst.size());
+        for (const value_type& item: lst) {
+            insert(item);
+        }
+    }
+
+    SwissHashmap(const SwissHashmap& other): maxLoadFactor(other.maxLoadFactor),
+        mHash(other.mHash), mEqual(other.mEqual) {
+        rehash(other.mSize);
+        for (const auto& el: other) {
+            insert(el);
+        }
+    }
+
+    SwissHashmap(SwissHashmap&& other) noexcept: mCtrl(other.mCtrl), mSlots(other.mSlots),
+        mCapacity(other.mCapacity), mSize(other.mSize), mGrowthLeft(other.mGrowthLeft),
+        maxLoadFactor(other.maxLoadFactor), mHash(std::move(other.mHash)), mEqual(std::move(other.mEqual)) {
+        other.mCtrl = nullptr;
+        other.mSlots = nullptr;
+        other.mCapacity = 0;
+        other.mSize = 0;
+        other.mGrowthLeft = 0;
+    }
+
+    // copy and swap, same as Vector
+    SwissHashmap& operator=(const SwissHashmap& other) {
+        SwissHashmap tmp{other};
+        swap(tmp);
+        return *this;
+    }
+
+    SwissHashmap& operator=(SwissHashmap&& other) noexcept {
+        SwissHashmap tmp{std::move(other)};
+        swap(tmp);
+        return *this;
+    }
+
+    ~SwissHashmap() {
+        destroyAndFree(mCtrl, mSlots, mCapacity);
+    }
+
+    void swap(SwissHashmap& other) noexcept {
+        std::swap(mCtrl, other.mCtrl);
+        std::swap(mSlots, other.mSlots);
+        std::swap(mCapacity, other.mCapacity);
+        std::swap(mSize, other.mSize);
+        std::swap(mGrowthLeft, other.mGrowthLeft);
+        std::swap(maxLoadFactor, other.maxLoadFactor);
+        std::swap(mHash, other.mHash);
+        std::swap(mEqual, other.mEqual);
+    }
+
+    V& at(const K& key) {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("invalid key");
+        }
+        return it->second;
+    }
+
+    // same semantics as Hashmap::insert: if the key exists the value gets replaced and we return false
+    std::pair<iterator, bool> insert(const value_type& value) {
+        auto [idx, inserted] = findOrPrepareInsert(value.first);
+        if (!inserted) {
+            mSlots[idx].second = value.second;
+            return { iteratorAt(idx), false };
+        }
+        new (&mSlots[idx]) value_type(value);
+        return { iteratorAt(idx), true };
+    }
+
+    V& operator[](const K& key) {
+        auto [idx, inserted] = findOrPrepareInsert(key);
+        if (inserted) {
+            new (&mSlots[idx]) value_type(key, V{});
+        }
+        return mSlots[idx].second;
+    }
+
+    iterator find(const K& key) {
+        return findImpl(key, hashOf(key));
+    }
+
+    const_iterator find(const K& key) const {
+        return findImpl(key, hashOf(key));
+    }
+
+    // same precomputed hash / transparent overloads as Hashmap, hash is hash_function()(key)
+    iterator find(const K& key, size_t hash) {
+        return findImpl(key, mixHash(hash));
+    }
+
+    const_iterator find(const K& key, size_t hash) const {
+        return findImpl(key, mixHash(hash));
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    iterator find(const Q& key) {
+        return findImpl(key, hashOf(key));
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    const_iterator find(const Q& key) const {
+        return findImpl(key, hashOf(key));
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    iterator find(const Q& key, size_t hash) {
+        return findImpl(key, mixHash(hash));
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    const_iterator find(const Q& key, size_t hash) const {
+        return findImpl(key, mixHash(hash));
+    }
+
+    bool contains(const K& key) const {
+        return findIndex(key, hashOf(key)) != mCapacity;
+    }
+
+    bool contains(const K& key, size_t hash) const {
+        return findIndex(key, mixHash(hash)) != mCapacity;
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    bool contains(const Q& key) const {
+        return findIndex(key, hashOf(key)) != mCapacity;
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    bool contains(const Q& key, size_t hash) const {
+        return findIndex(key, mixHash(hash)) != mCapacity;
+    }
+
+    bool erase(const K& key) {
+        return eraseImpl(key, hashOf(key));
+    }
+
+    bool erase(const K& key, size_t hash) {
+        return eraseImpl(key, mixHash(hash));
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    bool erase(const Q& key) {
+        return eraseImpl(key, hashOf(key));
+    }
+
+    template <typename Q> requires TransparentLookup<Hash, KeyEqual>
+    bool erase(const Q& key, size_t hash) {
+        return eraseImpl(key, mixHash(hash));
+    }
+
+    Hash hash_function() const {
+        return mHash;
+    }
+
+    KeyEqual key_eq() const {
+        return mEqual;
+    }
+
+    size_t size() const {
+        return mSize;
+    }
+
+    // number of slots, kept under the same name as Hashmap so the two are interchangeable
+    size_t bucket_count() const {
+        return mCapacity;
+    }
+
+    // makes room for at least count elements without going over the max load factor
+    void rehash(size_t count) {
+        size_t needed = static_cast<size_t>(static_cast<double>(std::max(count, mSize)) / maxLoadFactor) + 1;
+        size_t newCapacity = kGroupWidth;
+        while (newCapacity < needed) {
+            newCapacity *= 2;
+        }
+        resize(newCapacity);
+    }
+
+    const_iterator cbegin() const {
+        const_iterator it{mCtrl, mSlots, 0, mCapacity};
+        if (mCapacity != 0 && mCtrl[0] < 0) {
+            it.next();
+        }
+        return it;
+    }
+
+    const_iterator cend() const {
+        return const_iterator{mCtrl, mSlots, mCapacity, mCapacity};
+    }
+
+    iterator begin() {
+        iterator it{mCtrl, mSlots, 0, mCapacity};
+        if (mCapacity != 0 && mCtrl[0] < 0) {
+            it.next();
+        }
+        return it;
+    }
+
+    const_iterator begin() const {
+        return cbegin();
+    }
+
+    const_iterator end() const {
+        return cend();
+    }
+
+    iterator end() {
+        return iterator{mCtrl, mSlots, mCapacity, mCapacity};
+    }
+
+private:
+    // every hash used internally has been through mixHash()
+    template <typename Q>
+    uint64_t hashOf(const Q& key) const {
+        return mixHash(static_cast<uint64_t>(mHash(key)));
+    }
+
+    static size_t h1(uint64_t hash) { return static_cast<size_t>(hash >> 7); }
+    static uint8_t h2(uint64_t hash) { return static_cast<uint8_t>(hash & 0x7F); }
+
+    iterator iteratorAt(size_t idx) {
+        return iterator{mCtrl, mSlots, idx, mCapacity};
+    }
+
+    template <typename Q>
+    iterator findImpl(const Q& key, uint64_t hash) {
+        size_t idx = findIndex(key, hash);
+        return idx == mCapacity ? end() : iteratorAt(idx);
+    }
+
+    template <typename Q>
+    const_iterator findImpl(const Q& key, uint64_t hash) const {
+        size_t idx = findIndex(key, hash);
+        return idx == mCapacity ? cend() : const_iterator{mCtrl, mSlots, idx, mCapacity};
+    }
+
+    template <typename Q>
+    bool eraseImpl(const Q& key, uint64_t hash) {
+        size_t idx = findIndex(key, hash);
+        if (idx == mCapacity) {
+            return false;
+        }
+        mSlots[idx].~value_type();
+        mSize--;
+
+        // if the group still has an empty slot, no probe sequence ever went past this group
+        // (once a group fills up it can only get tombstones until the next rehash),
+        // so we can hand the slot straight back as empty instead of leaving a tombstone
+        size_t groupStart = idx & ~(kGroupWidth - 1);
+        if (Group{mCtrl + groupStart}.matchEmpty()) {
+            mCtrl[idx] = swiss_detail::kEmpty;
+            mGrowthLeft++;
+        } else {
+            mCtrl[idx] = swiss_detail::kDeleted;
+        }
+        return true;
+    }
+
+    // triangular probing over whole groups: start, start+1, start+3, start+6 ...
+    // with a power of two number of groups this visits every group exactly once
+    template <typename Q>
+    size_t findIndex(const Q& key, uint64_t hash) const {
+        if (mCapacity == 0) {
+            return mCapacity;
+        }
+        size_t groupMask = mCapacity / kGroupWidth - 1;
+        size_t group = h1(hash) & groupMask;
+        for (size_t step = 1; step <= groupMask + 1; step++) {
+            const int8_t* ctrl = mCtrl + group * kGroupWidth;
+            Group g{ctrl};
+            for (uint32_t i: g.match(h2(hash))) {
+                size_t idx = group * kGroupWidth + i;
+                if (mEqual(mSlots[idx].first, key)) {
+                    return idx;
+                }
+            }
+            // an empty slot means the key would have been placed here or earlier, so its not in the table
+            if (g.matchEmpty()) {
+                return mCapacity;
+            }
+            group = (group + step) & groupMask;
+        }
+        return mCapacity;
+    }
+
+    // returns {index, true} for a fresh slot the caller has to construct into,
+    // or {index, false} if the key is already there
+    std::pair<size_t, bool> findOrPrepareInsert(const K& key) {
+        uint64_t hash = hashOf(key);
+        size_t existing = findIndex(key, hash);
+        if (existing != mCapacity) {
+            return { existing, false };
+        }
+        if (mGrowthLeft == 0) {
+            // lots of tombstones -> rehashing in place at the same size is enough to clean them out
+            if (mCapacity != 0 && mSize * 2 <= maxElements(mCapacity)) {
+                resize(mCapacity);
+            } else {
+                resize(mCapacity == 0 ? kGroupWidth : mCapacity * 2);
+            }
+        }
+        size_t idx = findFirstNonFull(hash);
+        if (mCtrl[idx] == swiss_detail::kEmpty) {
+            mGrowthLeft--;
+        }
+        mCtrl[idx] = static_cast<int8_t>(h2(hash));
+        mSize++;
+        return { idx, true };
+    }
+
+    size_t findFirstNonFull(uint64_t hash) const {
+        size_t groupMask = mCapacity / kGroupWidth - 1;
+        size_t group = h1(hash) & groupMask;
+        for (size_t step = 1;; step++) {
+            Group g{mCtrl + group * kGroupWidth};
+            if (auto mask = g.matchEmptyOrDeleted()) {
+                return group * kGroupWidth + mask.lowest();
+            }
+            group = (group + step) & groupMask;
+        }
+    }
+
+    size_t maxElements(size_t capacity) const {
+        return static_cast<size_t>(static_cast<double>(capacity) * maxLoadFactor);
+    }
+
+    // moves every element into freshly allocated arrays of newCapacity slots, tombstones get dropped
+    void resize(size_t newCapacity) {
+        int8_t* oldCtrl = mCtrl;
+        value_type* oldSlots = mSlots;
+        size_t oldCapacity = mCapacity;
+
+        allocate(newCapacity);
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (oldCtrl[i] >= 0) {
+                uint64_t hash = hashOf(oldSlots[i].first);
+                size_t idx = findFirstNonFull(hash);
+                mCtrl[idx] = static_cast<int8_t>(h2(hash));
+                // K is const inside the pair so this copies the key and moves the value
+                new (&mSlots[idx]) value_type(std::move(oldSlots[i]));
+            }
+        }
+        mGrowthLeft = maxElements(mCapacity) - mSize;
+        destroyAndFree(oldCtrl, oldSlots, oldCapacity);
+    }
+
+    void allocate(size_t capacity) {
+        // aligned so Group can use aligned loads
+        mCtrl = static_cast<int8_t*>(::operator new(capacity, std::align_val_t{kGroupWidth}));
+        std::memset(mCtrl, swiss_detail::kEmpty, capacity);
+        mSlots = static_cast<value_type*>(::operator new(sizeof(value_type) * capacity, std::align_val_t{alignof(value_type)}));
+        mCapacity = capacity;
+    }
+
+    static void destroyAndFree(int8_t* ctrl, value_type* slots, size_t capacity) {
+        if (!ctrl) {
+            return;
+        }
+        for (size_t i = 0; i < capacity; i++) {
+            if (ctrl[i] >= 0) {
+                slots[i].~value_type();
+            }
+        }
+        ::operator delete(ctrl, std::align_val_t{kGroupWidth});
+        ::operator delete(slots, std::align_val_t{alignof(value_type)});
+    }
+
+    int8_t* mCtrl = nullptr;
+    value_type* mSlots = nullptr;
+    size_t mCapacity = 0;
+    size_t mSize = 0;
+    // how many more elements can go into empty slots before we have to grow
+    size_t mGrowthLeft = 0;
+    double maxLoadFactor = 0.875;
+
+    [[no_unique_address]] Hash mHash;
+    [[no_unique_address]] KeyEqual mEqual;
+};
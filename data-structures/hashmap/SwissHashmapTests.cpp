@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <random>
+#include "SwissHashmap.hpp"
+
+TEST(SwissHashmapTest, DefaultConstructor) {
+    SwissHashmap<int, std::string> map;
+    EXPECT_EQ(map.size(), 0);
+    EXPECT_EQ(map.bucket_count(), 0);
+    EXPECT_FALSE(map.contains(1));
+    EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(SwissHashmapTest, InsertFindAndOverwrite) {
+    SwissHashmap<std::string, int> map;
+    auto [it, inserted] = map.insert({"key", 42});
+    EXPECT_TRUE(inserted);
+    EXPECT_EQ(it->second, 42);
+
+    auto [it2, inserted2] = map.insert({"key", 99});
+    EXPECT_FALSE(inserted2);
+    EXPECT_EQ(it2->second, 99);
+    EXPECT_EQ(map.size(), 1);
+    EXPECT_EQ(map.find("key")->second, 99);
+    EXPECT_EQ(map.find("missing"), map.end());
+}
+
+TEST(SwissHashmapTest, OperatorBracketAndAt) {
+    SwissHashmap<std::string, int> map;
+    map["key"] = 42;
+    EXPECT_EQ(map["key"], 42);
+    EXPECT_EQ(map["new_key"], 0);
+    EXPECT_EQ(map.size(), 2);
+    EXPECT_EQ(map.at("key"), 42);
+    EXPECT_THROW(map.at("nonexistent"), std::out_of_range);
+}
+
+TEST(SwissHashmapTest, EraseAndReinsert) {
+    SwissHashmap<int, std::string> map = {{1, "one"}, {2, "two"}};
+    EXPECT_TRUE(map.erase(1));
+    EXPECT_FALSE(map.erase(1));
+    EXPECT_FALSE(map.contains(1));
+    EXPECT_TRUE(map.contains(2));
+    map[1] = "uno";
+    EXPECT_EQ(map.at(1), "uno");
+    EXPECT_EQ(map.size(), 2);
+}
+
+TEST(SwissHashmapTest, GrowsAndIteratesEveryElement) {
+    SwissHashmap<int, int> map;
+    for (int i = 0; i < 10000; ++i) {
+        map[i] = i * 2;
+        EXPECT_LE(static_cast<double>(map.size()) / map.bucket_count(), 0.875);
+    }
+    EXPECT_EQ(map.size(), 10000);
+
+    long long sum = 0;
+    int count = 0;
+    for (const auto& [key, value] : map) {
+        EXPECT_EQ(value, key * 2);
+        sum += key;
+        ++count;
+    }
+    EXPECT_EQ(count, 10000);
+    EXPECT_EQ(sum, 10000LL * 9999 / 2);
+}
+
+// lots of erase / insert churn leaves tombstones behind, compare against std::unordered_map
+TEST(SwissHashmapTest, RandomChurnMatchesUnorderedMap) {
+    SwissHashmap<int, int> map;
+    std::unordered_map<int, int> reference;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> keys(0, 2000);
+
+    for (int i = 0; i < 200000; ++i) {
+        int key = keys(rng);
+        switch (rng() % 3) {
+        case 0:
+            map[key] = i;
+            reference[key] = i;
+            break;
+        case 1:
+            EXPECT_EQ(map.erase(key), reference.erase(key) == 1);
+            break;
+        default:
+            EXPECT_EQ(map.contains(key), reference.count(key) == 1);
+            break;
+        }
+    }
+    EXPECT_EQ(map.size(), reference.size());
+    for (const auto& [key, value] : reference) {
+        EXPECT_EQ(map.at(key), value);
+    }
+}
+
+TEST(SwissHashmapTest, CopyAndMove) {
+    SwissHashmap<int, std::string> original;
+    original[1] = "one";
+    original[2] = "two";
+
+    SwissHashmap<int, std::string> copy(original);
+    original[1] = "modified";
+    EXPECT_EQ(copy[1], "one");
+
+    SwissHashmap<int, std::string> moved(std::move(original));
+    EXPECT_EQ(moved.size(), 2);
+    EXPECT_EQ(moved[1], "modified");
+    EXPECT_EQ(original.size(), 0);
+
+    copy = moved;
+    EXPECT_EQ(copy[1], "modified");
+}
+
+TEST(SwissHashmapTest, ConstIteration) {
+    const SwissHashmap<int, std::string> map = {{1, "one"}, {2, "two"}};
+    int count = 0;
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        ++count;
+    }
+    EXPECT_EQ(count, 2);
+    EXPECT_NE(map.find(1), map.end());
+}
+
+namespace {
+
+struct TransparentStringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+} // namespace
+
+TEST(SwissHashmapTest, TransparentAndPrecomputedHash) {
+    SwissHashmap<std::string, int, TransparentStringHash, std::equal_to<>> map;
+    map["alpha"] = 1;
+    map["beta"] = 2;
+
+    std::string_view view = "alpha";
+    EXPECT_EQ(map.find(view)->second, 1);
+    size_t hash = map.hash_function()(std::string_view{"beta"});
+    EXPECT_TRUE(map.contains(std::string_view{"beta"}, hash));
+    EXPECT_TRUE(map.erase(std::string_view{"beta"}, hash));
+    EXPECT_FALSE(map.contains(std::string_view{"beta"}));
+    EXPECT_EQ(map.size(), 1);
+}
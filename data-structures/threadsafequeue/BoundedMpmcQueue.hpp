@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// Bounded multi producer / multi consumer queue without a lock (Dmitry Vyukov's design), with the same
+// push / try_pop / wait_pop as ThreadSafeQueue.
+// ThreadSafeQueue runs every push and pop under one mutex, so with lots of producers and consumers they all
+// queue up on that mutex and only one thread gets anything done at a time. Here a push or pop claims its slot
+// with one CAS on a position counter and then only touches that slot, so threads working on different slots
+// dont wait for each other at all.
+//
+// The ring has a power of two number of cells and every cell has a sequence number that says whose turn it
+// is on that cell:
+//   sequence == pos          free, the producer that claims position pos can write it
+//   sequence == pos + 1      holds the element of position pos, the consumer that claims pos can take it
+//   after the pop            sequence = pos + capacity, free again for the producer one lap later
+// A producer loads the enqueue position, checks the cell and CASes the position one further, a consumer the
+// same with the dequeue position. If the CAS fails someone else got that position first, try the next one.
+//
+// Blocking (push on a full queue, wait_pop on an empty one) parks the thread with std::atomic::wait on the
+// sequence of the cell its waiting for, which is a futex on Linux: no mutex and no condition variable, and a
+// thread sleeps in the kernel instead of burning a core. The side that changes a cell only calls notify when
+// the waiting counter says someone is parked, so when nobody is waiting nothing gets slower. Before parking a
+// thread yields a few times, parked threads make every push / pop on the other side pay for a syscall.
+//
+// Elements have to move without throwing. Emplacing with a constructor that can throw builds the value first
+// and moves it in after, so a throw never leaves a claimed cell empty (everyone after it would wait forever).
+// Not copyable or movable, threads are holding on to it.
+
+template <typename T>
+requires (std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>)
+class BoundedMpmcQueue {
+private:
+    static constexpr size_t kCacheLine = 64;
+    static constexpr int kYieldsBeforePark = 16;
+
+public:
+    // rounded up to a power of two, at least 2
+    explicit BoundedMpmcQueue(size_t capacity)
+        : mCapacity(std::bit_ceil(std::max<size_t>(capacity, 2))),
+          mMask(mCapacity - 1),
+          mCells(static_cast<Cell*>(::operator new(sizeof(Cell) * mCapacity, std::align_val_t{alignof(Cell)}))) {
+        for (size_t i = 0; i < mCapacity; i++) {
+            new (&mCells[i]) Cell(i);
+        }
+    }
+
+    BoundedMpmcQueue(const BoundedMpmcQueue&) = delete;
+    BoundedMpmcQueue& operator=(const BoundedMpmcQueue&) = delete;
+
+    ~BoundedMpmcQueue() {
+        // whatever nobody popped is still in its cell
+        size_t end = mEnqueuePos.load(std::memory_order_relaxed);
+        for (size_t pos = mDequeuePos.load(std::memory_order_relaxed); pos != end; pos++) {
+            mCells[pos & mMask].value()->~T();
+        }
+        for (size_t i = 0; i < mCapacity; i++) {
+            mCells[i].~Cell();
+        }
+        ::operator delete(mCells, std::align_val_t{alignof(Cell)});
+    }
+
+    // blocks while the queue is full
+    void push(const T& value) {
+        emplace(value);
+    }
+
+    void push(T&& value) {
+        emplace(std::move(value));
+    }
+
+    template <typename... U>
+    requires std::constructible_from<T, U...>
+    void emplace(U&&... args) {
+        if constexpr (std::is_nothrow_constructible_v<T, U...>) {
+            while (true) {
+                size_t pos;
+                size_t seen;
+                if (Cell* cell = claimPush(pos, seen)) {
+                    new (cell->storage) T(std::forward<U>(args)...);
+                    publishPush(*cell, pos);
+                    return;
+                }
+                // full, the cell is still holding an element from a lap ago. Sleep till its consumer frees it
+                park(mCells[pos & mMask].sequence, seen, mWaitingProducers);
+            }
+        } else {
+            emplace(T(std::forward<U>(args)...));
+        }
+    }
+
+    // false if the queue is full
+    bool try_push(const T& value) {
+        return try_emplace(value);
+    }
+
+    bool try_push(T&& value) {
+        return try_emplace(std::move(value));
+    }
+
+    template <typename... U>
+    requires std::constructible_from<T, U...>
+    bool try_emplace(U&&... args) {
+        if constexpr (std::is_nothrow_constructible_v<T, U...>) {
+            size_t pos;
+            size_t seen;
+            Cell* cell = claimPush(pos, seen);
+            if (!cell) {
+                return false;
+            }
+            new (cell->storage) T(std::forward<U>(args)...);
+            publishPush(*cell, pos);
+            return true;
+        } else {
+            return try_emplace(T(std::forward<U>(args)...));
+        }
+    }
+
+    // false if the queue is empty
+    bool try_pop(T& result) {
+        size_t pos;
+        size_t seen;
+        Cell* cell = claimPop(pos, seen);
+        if (!cell) {
+            return false;
+        }
+        take(*cell, pos, result);
+        return true;
+    }
+
+    // blocks until theres an element
+    void wait_pop(T& result) {
+        while (true) {
+            size_t pos;
+            size_t seen;
+            if (Cell* cell = claimPop(pos, seen)) {
+                take(*cell, pos, result);
+                return;
+            }
+            // empty, sleep till the producer of position pos fills the cell
+            park(mCells[pos & mMask].sequence, seen, mWaitingConsumers);
+        }
+    }
+
+    // only a snapshot while other threads are pushing and popping
+    bool empty() const {
+        return mDequeuePos.load(std::memory_order_acquire) >= mEnqueuePos.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return mCapacity;
+    }
+
+private:
+    struct Cell {
+        explicit Cell(size_t pos): sequence(pos) {}
+
+        T* value() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    // positions only grow, so the difference says whos ahead even once they wrap around the ring
+    static std::ptrdiff_t distance(size_t a, size_t b) {
+        return static_cast<std::ptrdiff_t>(a - b);
+    }
+
+    // a free cell with its position claimed, or nullptr if full. pos / seen are what the last check saw,
+    // thats what a blocking push waits on
+    Cell* claimPush(size_t& pos, size_t& seen) {
+        pos = mEnqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = mCells[pos & mMask];
+            seen = cell.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = distance(seen, pos);
+            if (diff == 0) {
+                // relaxed is enough, the cell's sequence is what orders the element, not the position
+                if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return &cell;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                // another producer already took pos
+                pos = mEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    Cell* claimPop(size_t& pos, size_t& seen) {
+        pos = mDequeuePos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = mCells[pos & mMask];
+            seen = cell.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = distance(seen, pos + 1);
+            if (diff == 0) {
+                if (mDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return &cell;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = mDequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void publishPush(Cell& cell, size_t pos) {
+        // seq_cst store, and the waiting count loaded after it: a consumer going to sleep does the same two
+        // the other way round (count up, then look at the sequence), so one of the two always sees the other
+        cell.sequence.store(pos + 1, std::memory_order_seq_cst);
+        if (mWaitingConsumers.load(std::memory_order_seq_cst) != 0) {
+            cell.sequence.notify_all();
+        }
+    }
+
+    void take(Cell& cell, size_t pos, T& result) {
+        T* value = cell.value();
+        result = std::move(*value);
+        value->~T();
+        cell.sequence.store(pos + mCapacity, std::memory_order_seq_cst);
+        if (mWaitingProducers.load(std::memory_order_seq_cst) != 0) {
+            cell.sequence.notify_all();
+        }
+    }
+
+    static void park(std::atomic<size_t>& sequence, size_t seen, std::atomic<uint32_t>& waiting) {
+        // give the other side a few chances first. Once a thread is parked every change on the other side
+        // pays for a wake up syscall, and usually the cell moves on within a couple of time slices anyway
+        for (int i = 0; i < kYieldsBeforePark; i++) {
+            std::this_thread::yield();
+            if (sequence.load(std::memory_order_acquire) != seen) {
+                return;
+            }
+        }
+        waiting.fetch_add(1, std::memory_order_seq_cst);
+        // wait returns straight away if the sequence already moved on (and spins a little before it sleeps)
+        sequence.wait(seen, std::memory_order_seq_cst);
+        waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    const size_t mCapacity;
+    const size_t mMask;
+    Cell* const mCells;
+
+    // each position on its own cache line, producers hammer one and consumers the other
+    alignas(kCacheLine) std::atomic<size_t> mEnqueuePos{0};
+    alignas(kCacheLine) std::atomic<size_t> mDequeuePos{0};
+    // only written when a thread parks, read on every push / pop
+    alignas(kCacheLine) std::atomic<uint32_t> mWaitingProducers{0};
+    std::atomic<uint32_t> mWaitingConsumers{0};
+};
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BoundedMpmcQueue.hpp"
+
+TEST(BoundedMpmcQueueTest, FillsUpAndEmptiesInOrder) {
+    BoundedMpmcQueue<int> q(5);
+    EXPECT_EQ(q.capacity(), 8);
+    EXPECT_TRUE(q.empty());
+
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(q.try_push(i));
+    }
+    EXPECT_FALSE(q.try_push(8));
+    EXPECT_FALSE(q.empty());
+
+    int out = -1;
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(q.try_pop(out));
+        EXPECT_EQ(out, i);
+    }
+    EXPECT_FALSE(q.try_pop(out));
+    EXPECT_TRUE(q.empty());
+
+    // round and round, so the sequence numbers go through many laps
+    for (int i = 0; i < 100; ++i) {
+        q.push(i);
+        q.wait_pop(out);
+        EXPECT_EQ(out, i);
+    }
+}
+
+struct ThrowsOnBuild {
+    explicit ThrowsOnBuild(int v): value(v) {
+        if (v < 0) {
+            throw std::invalid_argument("negative");
+        }
+    }
+    int value = 0;
+};
+
+TEST(BoundedMpmcQueueTest, OwnsNonTrivialElements) {
+    auto tracker = std::make_shared<int>(0);
+    {
+        BoundedMpmcQueue<std::shared_ptr<int>> q(4);
+        q.push(tracker);
+        q.push(tracker);
+        q.push(tracker);
+        std::shared_ptr<int> out;
+        EXPECT_TRUE(q.try_pop(out));
+        out.reset();
+        EXPECT_EQ(tracker.use_count(), 1 + 2);
+    }
+    // the destructor destroys whatever is left
+    EXPECT_EQ(tracker.use_count(), 1);
+
+    BoundedMpmcQueue<std::string> strings(2);
+    EXPECT_TRUE(strings.try_emplace(40, 'x'));
+    std::string s;
+    strings.wait_pop(s);
+    EXPECT_EQ(s, std::string(40, 'x'));
+
+    // a constructor that throws doesnt leave a claimed cell behind
+    BoundedMpmcQueue<ThrowsOnBuild> q(2);
+    EXPECT_THROW(q.emplace(-1), std::invalid_argument);
+    EXPECT_THROW(q.try_emplace(-1), std::invalid_argument);
+    EXPECT_TRUE(q.empty());
+    q.emplace(7);
+    ThrowsOnBuild got(0);
+    EXPECT_TRUE(q.try_pop(got));
+    EXPECT_EQ(got.value, 7);
+}
+
+TEST(BoundedMpmcQueueTest, BlockingPushAndPop) {
+    BoundedMpmcQueue<int> q(2);
+    int result = 0;
+    std::thread consumer([&] {
+        q.wait_pop(result);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    q.push(42);
+    consumer.join();
+    EXPECT_EQ(result, 42);
+
+    q.push(1);
+    q.push(2);
+    std::atomic<bool> pushed = false;
+    std::thread producer([&] {
+        // full, has to wait for a pop
+        q.push(3);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(pushed);
+    q.wait_pop(result);
+    EXPECT_EQ(result, 1);
+    producer.join();
+    EXPECT_TRUE(pushed);
+    q.wait_pop(result);
+    EXPECT_EQ(result, 2);
+    q.wait_pop(result);
+    EXPECT_EQ(result, 3);
+}
+
+TEST(BoundedMpmcQueueTest, ManyProducersAndConsumers) {
+    constexpr uint64_t kProducers = 4;
+    constexpr uint64_t kConsumers = 4;
+    constexpr uint64_t kPerProducer = 50000;
+    // small on purpose, so producers hit a full queue and consumers an empty one all the time
+    BoundedMpmcQueue<uint64_t> q(16);
+
+    std::vector<std::thread> threads;
+    for (uint64_t p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&q, p] {
+            for (uint64_t i = 0; i < kPerProducer; ++i) {
+                uint64_t value = p * kPerProducer + i;
+                if (i % 2 == 0) {
+                    q.push(value);
+                } else {
+                    while (!q.try_push(value)) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        });
+    }
+
+    // every value exactly once, and each producer's values in the order it pushed them
+    std::vector<std::vector<uint64_t>> seen(kConsumers);
+    for (uint64_t c = 0; c < kConsumers; ++c) {
+        threads.emplace_back([&q, &seen, c] {
+            for (uint64_t i = 0; i < kProducers * kPerProducer / kConsumers; ++i) {
+                uint64_t value;
+                if (i % 2 == 0) {
+                    q.wait_pop(value);
+                } else {
+                    while (!q.try_pop(value)) {
+                        std::this_thread::yield();
+                    }
+                }
+                seen[c].push_back(value);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    std::vector<int> count(kProducers * kPerProducer, 0);
+    bool inOrder = true;
+    for (const auto& values : seen) {
+        std::vector<uint64_t> last(kProducers, 0);
+        std::vector<bool> any(kProducers, false);
+        for (uint64_t v : values) {
+            count[v]++;
+            uint64_t p = v / kPerProducer;
+            inOrder &= !any[p] || v > last[p];
+            last[p] = v;
+            any[p] = true;
+        }
+    }
+    for (int n : count) {
+        ASSERT_EQ(n, 1);
+    }
+    EXPECT_TRUE(inOrder);
+    EXPECT_TRUE(q.empty());
+}
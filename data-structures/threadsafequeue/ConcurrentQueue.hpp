@@ -0,0 +1,428 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+// Unbounded multi producer / multi consumer queue where every producer has its own sub-queue
+// (the design of moodycamel::ConcurrentQueue, cut down).
+// ThreadSafeQueue, BoundedMpmcQueue and MichaelScottQueue all have ONE tail that every producer fights over.
+// Here each producer appends to its own sub-queue, so producers never touch each other's memory at all, and
+// consumers go round the sub-queues taking whatever is there. The price: theres no single FIFO order anymore,
+// only per producer (everything one producer enqueued comes out in the order it went in).
+//
+// A sub-queue is a list of blocks of BlockSize elements. The producer writes into its current block and
+// publishes with one release store of its tail index, so enqueue_bulk of n elements is n constructions and
+// ONE atomic store. Consumers claim a whole range [head, head + n) with one CAS on the sub-queue's head and
+// then move the elements out without any further synchronisation between them.
+// Blocks are recycled: the producer keeps its blocks in a ring (the block index), and when it comes round to
+// a block that consumers have finished with it just writes into it again. Once the ring is big enough for the
+// producer / consumer lag, enqueueing allocates nothing. If the block it comes round to still has elements
+// in it the ring doubles (the old rings stay around until the queue goes, a consumer may still be reading
+// one).
+//
+//   ProducerToken tok(q);            own sub-queue for a long lived producer, given back when tok goes
+//   q.enqueue(tok, v) / q.enqueue_bulk(tok, first, n)
+//   q.enqueue(v)                     no token: the calling thread gets its own sub-queue the first time
+//   q.try_dequeue(v) / q.try_dequeue_bulk(out, max)
+//   ConsumerToken ctok(q)            a consumer with a token stays on one sub-queue for a while (the
+//                                    elements there are next to each other in memory) instead of starting
+//                                    the search somewhere new every time
+//
+// Theres no blocking pop, consumers that find it empty decide themselves whether to spin, yield or sleep.
+// Sub-queues are never freed while the queue lives: a token's sub-queue is handed to the next token, the
+// sub-queue of a thread that enqueued without a token stays (a thread with the same id later gets it back).
+// Elements have to move without throwing.
+
+// a pointer-like iterator over T's, elements can be memcpy'd through it in one go
+template <typename It, typename T>
+concept ContiguousIteratorOf = std::contiguous_iterator<It> && std::same_as<std::iter_value_t<It>, T>;
+
+template <typename T, size_t BlockSize = 32>
+requires (std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T> && BlockSize >= 2 &&
+          std::has_single_bit(BlockSize))
+class ConcurrentQueue {
+private:
+    static constexpr size_t kCacheLine = 64;
+    static constexpr size_t kInitialIndexSize = 4;
+    // a consumer token moves on to the next sub-queue after this many elements, so one busy producer cant
+    // keep a consumer to itself
+    static constexpr size_t kConsumerQuota = 256;
+
+    struct SubQueue;
+
+public:
+    class ProducerToken {
+    public:
+        explicit ProducerToken(ConcurrentQueue& q): mProducer(q.acquireProducer()) {}
+
+        ProducerToken(const ProducerToken&) = delete;
+        ProducerToken& operator=(const ProducerToken&) = delete;
+
+        ProducerToken(ProducerToken&& other) noexcept: mProducer(std::exchange(other.mProducer, nullptr)) {}
+
+        ~ProducerToken() {
+            if (mProducer) {
+                // release, whoever takes the sub-queue over next carries on from where this one stopped
+                mProducer->active.store(false, std::memory_order_release);
+            }
+        }
+
+    private:
+        friend class ConcurrentQueue;
+        SubQueue* mProducer;
+    };
+
+    class ConsumerToken {
+    public:
+        explicit ConsumerToken(ConcurrentQueue& q)
+            : mStart(q.mNextConsumerStart.fetch_add(1, std::memory_order_relaxed)) {}
+
+    private:
+        friend class ConcurrentQueue;
+        size_t mStart;
+        SubQueue* mCurrent = nullptr;
+        size_t mTaken = 0;
+    };
+
+    ConcurrentQueue(): mId(sNextId.fetch_add(1, std::memory_order_relaxed)) {}
+
+    ConcurrentQueue(const ConcurrentQueue&) = delete;
+    ConcurrentQueue& operator=(const ConcurrentQueue&) = delete;
+
+    ~ConcurrentQueue() {
+        SubQueue* producer = mProducers.load(std::memory_order_acquire);
+        while (producer) {
+            SubQueue* next = producer->next;
+            delete producer;
+            producer = next;
+        }
+    }
+
+    void enqueue(ProducerToken& token, const T& value) {
+        token.mProducer->enqueue_bulk(&value, 1);
+    }
+
+    void enqueue(ProducerToken& token, T&& value) {
+        token.mProducer->enqueue_bulk(std::make_move_iterator(&value), 1);
+    }
+
+    void enqueue(const T& value) {
+        implicitProducer()->enqueue_bulk(&value, 1);
+    }
+
+    void enqueue(T&& value) {
+        implicitProducer()->enqueue_bulk(std::make_move_iterator(&value), 1);
+    }
+
+    // n elements from first on, visible to consumers all at once. Pass a move_iterator to move them in
+    template <std::input_iterator It>
+    void enqueue_bulk(ProducerToken& token, It first, size_t n) {
+        token.mProducer->enqueue_bulk(first, n);
+    }
+
+    template <std::input_iterator It>
+    void enqueue_bulk(It first, size_t n) {
+        implicitProducer()->enqueue_bulk(first, n);
+    }
+
+    // false if every sub-queue was empty when it looked
+    bool try_dequeue(T& result) {
+        return try_dequeue_bulk(&result, 1) == 1;
+    }
+
+    bool try_dequeue(ConsumerToken& token, T& result) {
+        return try_dequeue_bulk(token, &result, 1) == 1;
+    }
+
+    // up to max elements, all from the same sub-queue, returns how many
+    template <typename OutIt>
+    size_t try_dequeue_bulk(OutIt out, size_t max) {
+        // start somewhere else every time, so consumers spread over the sub-queues
+        size_t start = mNextConsumerStart.fetch_add(1, std::memory_order_relaxed);
+        SubQueue* from = nullptr;
+        return dequeueRound(nthProducer(start), out, max, from);
+    }
+
+    template <typename OutIt>
+    size_t try_dequeue_bulk(ConsumerToken& token, OutIt out, size_t max) {
+        if (!token.mCurrent || token.mTaken >= kConsumerQuota) {
+            token.mCurrent = token.mCurrent ? nextProducer(token.mCurrent) : nthProducer(token.mStart);
+            token.mTaken = 0;
+        }
+        SubQueue* from = nullptr;
+        size_t n = dequeueRound(token.mCurrent, out, max, from);
+        if (n > 0) {
+            if (from != token.mCurrent) {
+                token.mCurrent = from;
+                token.mTaken = 0;
+            }
+            token.mTaken += n;
+        }
+        return n;
+    }
+
+    // only a snapshot while other threads are enqueueing and dequeueing
+    size_t size_approx() const {
+        size_t total = 0;
+        for (SubQueue* p = mProducers.load(std::memory_order_acquire); p; p = p->next) {
+            uint64_t head = p->head.load(std::memory_order_relaxed);
+            uint64_t tail = p->tail.load(std::memory_order_relaxed);
+            total += tail > head ? tail - head : 0;
+        }
+        return total;
+    }
+
+    // sub-queues made so far (tokens and token-less threads), mostly for tests
+    size_t producer_count() const {
+        return mProducerCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Block {
+        T* slot(size_t i) {
+            return std::launder(reinterpret_cast<T*>(storage)) + i;
+        }
+
+        // consumers count up the elements theyre done with, at BlockSize the producer can write it again
+        alignas(kCacheLine) std::atomic<size_t> consumed{0};
+        alignas(std::max(alignof(T), kCacheLine)) unsigned char storage[sizeof(T) * BlockSize];
+    };
+
+    // ring of blocks, block number b lives in blocks[b & (capacity - 1)]. A slot gets its block once and
+    // keeps it, so a consumer can use any ring that was current when it claimed its elements
+    struct BlockIndex {
+        explicit BlockIndex(size_t capacity, BlockIndex* previous)
+            : capacity(capacity), previous(previous), blocks(std::make_unique<Block*[]>(capacity)) {}
+
+        const size_t capacity;
+        BlockIndex* const previous;
+        std::unique_ptr<Block*[]> blocks;
+    };
+
+    struct SubQueue {
+        SubQueue() {
+            index.store(new BlockIndex(kInitialIndexSize, nullptr), std::memory_order_relaxed);
+        }
+
+        ~SubQueue() {
+            BlockIndex* current = index.load(std::memory_order_relaxed);
+            uint64_t end = tail.load(std::memory_order_relaxed);
+            for (uint64_t i = head.load(std::memory_order_relaxed); i < end; i++) {
+                current->blocks[(i / BlockSize) & (current->capacity - 1)]->slot(i & (BlockSize - 1))->~T();
+            }
+            for (size_t i = 0; i < current->capacity; i++) {
+                delete current->blocks[i];
+            }
+            while (current) {
+                BlockIndex* previous = current->previous;
+                delete current;
+                current = previous;
+            }
+        }
+
+        // ---- producer side, only ever one thread at a time ----
+
+        template <typename It>
+        void enqueue_bulk(It first, size_t n) {
+            uint64_t start = tail.load(std::memory_order_relaxed);
+            uint64_t pos = start;
+            try {
+                while (pos != start + n) {
+                    size_t offset = pos & (BlockSize - 1);
+                    if (offset == 0) {
+                        tailBlock = blockFor(pos / BlockSize);
+                    }
+                    size_t count = std::min<uint64_t>(BlockSize - offset, start + n - pos);
+                    if constexpr (std::is_trivially_copyable_v<T> && ContiguousIteratorOf<It, T>) {
+                        std::memcpy(tailBlock->slot(offset), std::to_address(first), count * sizeof(T));
+                        first += count;
+                        pos += count;
+                    } else {
+                        for (size_t i = 0; i < count; i++, ++first, ++pos) {
+                            new (tailBlock->slot(offset + i)) T(*first);
+                        }
+                    }
+                }
+            } catch (...) {
+                // the ones already built go in, the rest dont
+                tail.store(pos, std::memory_order_release);
+                throw;
+            }
+            // everything written above is visible to whoever sees the new tail
+            tail.store(pos, std::memory_order_release);
+        }
+
+        Block* blockFor(uint64_t number) {
+            BlockIndex* current = index.load(std::memory_order_relaxed);
+            Block*& slot = current->blocks[number & (current->capacity - 1)];
+            if (!slot) {
+                slot = new Block;
+                return slot;
+            }
+            // holds block number - capacity. If the consumers are done with it, round again
+            if (slot->consumed.load(std::memory_order_acquire) == BlockSize) {
+                slot->consumed.store(0, std::memory_order_relaxed);
+                return slot;
+            }
+            // they arent, the ring is too small for how far behind they are. The last capacity blocks move
+            // into a ring twice the size, the slot for number is a free one there
+            BlockIndex* bigger = new BlockIndex(2 * current->capacity, current);
+            for (uint64_t b = number - current->capacity; b < number; b++) {
+                bigger->blocks[b & (bigger->capacity - 1)] = current->blocks[b & (current->capacity - 1)];
+            }
+            Block* block = new Block;
+            bigger->blocks[number & (bigger->capacity - 1)] = block;
+            index.store(bigger, std::memory_order_release);
+            return block;
+        }
+
+        // ---- consumer side, any number of threads ----
+
+        template <typename OutIt>
+        size_t dequeue_bulk(OutIt& out, size_t max) {
+            uint64_t start = head.load(std::memory_order_relaxed);
+            size_t n;
+            while (true) {
+                // acquire: the elements below tail are written
+                uint64_t end = tail.load(std::memory_order_acquire);
+                if (start >= end) {
+                    return 0;
+                }
+                n = std::min<uint64_t>(max, end - start);
+                if (head.compare_exchange_weak(start, start + n, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            // [start, start + n) is ours. Its blocks are in any ring from the one current at the tail we saw on
+            BlockIndex* current = index.load(std::memory_order_acquire);
+            uint64_t pos = start;
+            while (pos != start + n) {
+                Block* block = current->blocks[(pos / BlockSize) & (current->capacity - 1)];
+                size_t offset = pos & (BlockSize - 1);
+                size_t count = std::min<uint64_t>(BlockSize - offset, start + n - pos);
+                T* first = block->slot(offset);
+                if constexpr (std::is_trivially_copyable_v<T> && ContiguousIteratorOf<OutIt, T>) {
+                    std::memcpy(std::to_address(out), first, count * sizeof(T));
+                    out += count;
+                } else {
+                    for (size_t i = 0; i < count; i++, ++out) {
+                        *out = std::move(first[i]);
+                        first[i].~T();
+                    }
+                }
+                // release: done reading before the producer can see the block as free
+                block->consumed.fetch_add(count, std::memory_order_release);
+                pos += count;
+            }
+            return n;
+        }
+
+        // producer writes tail, consumers CAS head, each on its own cache line
+        alignas(kCacheLine) std::atomic<uint64_t> tail{0};
+        Block* tailBlock = nullptr;
+        std::atomic<BlockIndex*> index{nullptr};
+
+        alignas(kCacheLine) std::atomic<uint64_t> head{0};
+
+        SubQueue* next = nullptr;
+        // held by a token (or a token-less thread), a token that finds one inactive can take it
+        std::atomic<bool> active{true};
+    };
+
+    SubQueue* addProducer() {
+        SubQueue* producer = new SubQueue;
+        SubQueue* first = mProducers.load(std::memory_order_relaxed);
+        do {
+            producer->next = first;
+        } while (!mProducers.compare_exchange_weak(first, producer, std::memory_order_release,
+                                                   std::memory_order_relaxed));
+        mProducerCount.fetch_add(1, std::memory_order_relaxed);
+        return producer;
+    }
+
+    SubQueue* acquireProducer() {
+        for (SubQueue* p = mProducers.load(std::memory_order_acquire); p; p = p->next) {
+            if (!p->active.load(std::memory_order_relaxed) &&
+                !p->active.exchange(true, std::memory_order_acquire)) {
+                return p;
+            }
+        }
+        return addProducer();
+    }
+
+    SubQueue* implicitProducer() {
+        // one entry per thread, good enough for a thread that keeps enqueueing into the same queue. The id is
+        // never reused, so a new queue at the address of a dead one cant pick up a stale entry
+        struct Cache {
+            uint64_t queueId = 0;
+            SubQueue* producer = nullptr;
+        };
+        thread_local Cache cache;
+        if (cache.queueId == mId) {
+            return cache.producer;
+        }
+        std::lock_guard<std::mutex> lock(mImplicitMtx);
+        auto [it, inserted] = mImplicitProducers.try_emplace(std::this_thread::get_id(), nullptr);
+        if (inserted) {
+            it->second = addProducer();
+        }
+        cache = {mId, it->second};
+        return it->second;
+    }
+
+    SubQueue* nthProducer(size_t n) const {
+        SubQueue* first = mProducers.load(std::memory_order_acquire);
+        if (!first) {
+            return nullptr;
+        }
+        size_t count = std::max<size_t>(mProducerCount.load(std::memory_order_relaxed), 1);
+        SubQueue* p = first;
+        for (size_t i = n % count; i > 0 && p->next; i--) {
+            p = p->next;
+        }
+        return p;
+    }
+
+    SubQueue* nextProducer(SubQueue* p) const {
+        return p->next ? p->next : mProducers.load(std::memory_order_acquire);
+    }
+
+    // tries every sub-queue once, starting at begin
+    template <typename OutIt>
+    size_t dequeueRound(SubQueue* begin, OutIt out, size_t max, SubQueue*& from) {
+        if (!begin || max == 0) {
+            return 0;
+        }
+        SubQueue* p = begin;
+        do {
+            if (size_t n = p->dequeue_bulk(out, max)) {
+                from = p;
+                return n;
+            }
+            p = nextProducer(p);
+        } while (p != begin);
+        return 0;
+    }
+
+    static inline std::atomic<uint64_t> sNextId{1};
+
+    const uint64_t mId;
+    std::atomic<SubQueue*> mProducers{nullptr};
+    std::atomic<size_t> mProducerCount{0};
+    alignas(kCacheLine) std::atomic<size_t> mNextConsumerStart{0};
+    std::mutex mImplicitMtx;
+    std::unordered_map<std::thread::id, SubQueue*> mImplicitProducers;
+};
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ConcurrentQueue.hpp"
+
+TEST(ConcurrentQueueTest, OneProducerComesOutInOrder) {
+    ConcurrentQueue<int> q;
+    int out = -1;
+    EXPECT_FALSE(q.try_dequeue(out));
+
+    ConcurrentQueue<int>::ProducerToken token(q);
+    for (int i = 0; i < 1000; ++i) {
+        q.enqueue(token, i);
+    }
+    EXPECT_EQ(q.size_approx(), 1000);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(q.try_dequeue(out));
+        EXPECT_EQ(out, i);
+    }
+    EXPECT_FALSE(q.try_dequeue(out));
+    EXPECT_EQ(q.size_approx(), 0);
+}
+
+TEST(ConcurrentQueueTest, BulkAcrossBlocks) {
+    // blocks of 4, so every bulk call spans several of them
+    ConcurrentQueue<uint32_t, 4> q;
+    ConcurrentQueue<uint32_t, 4>::ProducerToken token(q);
+    std::vector<uint32_t> in(50);
+    for (uint32_t i = 0; i < 50; ++i) {
+        in[i] = i;
+    }
+    q.enqueue_bulk(token, in.data(), 23);
+    q.enqueue_bulk(token, in.begin() + 23, 27);
+
+    std::vector<uint32_t> out(50);
+    EXPECT_EQ(q.try_dequeue_bulk(out.data(), 10), 10);
+    EXPECT_EQ(q.try_dequeue_bulk(out.begin() + 10, 100), 40);
+    EXPECT_EQ(out, in);
+    EXPECT_EQ(q.try_dequeue_bulk(out.data(), 10), 0);
+
+    // into a different element type goes element by element
+    q.enqueue_bulk(token, in.data(), 5);
+    std::vector<uint64_t> wide;
+    EXPECT_EQ(q.try_dequeue_bulk(std::back_inserter(wide), 8), 5);
+    EXPECT_EQ(wide, std::vector<uint64_t>({0, 1, 2, 3, 4}));
+}
+
+TEST(ConcurrentQueueTest, TokensAndThreadsGetTheirOwnSubQueues) {
+    ConcurrentQueue<int> q;
+    {
+        ConcurrentQueue<int>::ProducerToken a(q);
+        ConcurrentQueue<int>::ProducerToken b(q);
+        EXPECT_EQ(q.producer_count(), 2);
+        q.enqueue(a, 1);
+        q.enqueue(b, 2);
+    }
+    // both tokens are gone, a new one takes over a sub-queue instead of making another
+    ConcurrentQueue<int>::ProducerToken c(q);
+    EXPECT_EQ(q.producer_count(), 2);
+    q.enqueue(c, 3);
+
+    // no token: this thread gets one sub-queue, and keeps it
+    q.enqueue(4);
+    q.enqueue(5);
+    EXPECT_EQ(q.producer_count(), 3);
+    std::thread other([&q] {
+        q.enqueue(6);
+    });
+    other.join();
+    EXPECT_EQ(q.producer_count(), 4);
+    EXPECT_EQ(q.size_approx(), 6);
+
+    std::vector<int> seen;
+    ConcurrentQueue<int>::ConsumerToken consumer(q);
+    int out;
+    while (q.try_dequeue(consumer, out)) {
+        seen.push_back(out);
+    }
+    std::sort(seen.begin(), seen.end());
+    EXPECT_EQ(seen, std::vector<int>({1, 2, 3, 4, 5, 6}));
+}
+
+TEST(ConcurrentQueueTest, BlocksAreRecycledAndElementsOwned) {
+    auto tracker = std::make_shared<int>(0);
+    {
+        ConcurrentQueue<std::shared_ptr<int>, 4> q;
+        ConcurrentQueue<std::shared_ptr<int>, 4>::ProducerToken token(q);
+        std::shared_ptr<int> out;
+        // way more than the first ring holds, but never more than a block behind: round and round the
+        // same blocks
+        for (int i = 0; i < 1000; ++i) {
+            q.enqueue(token, tracker);
+            q.enqueue(token, std::shared_ptr<int>(tracker));
+            ASSERT_TRUE(q.try_dequeue(out));
+            ASSERT_TRUE(q.try_dequeue(out));
+        }
+        out.reset();
+        EXPECT_EQ(tracker.use_count(), 1);
+
+        // consumers far behind: the ring grows, nothing gets overwritten
+        std::vector<std::shared_ptr<int>> batch(100, tracker);
+        q.enqueue_bulk(token, std::make_move_iterator(batch.begin()), batch.size());
+        EXPECT_EQ(tracker.use_count(), 1 + 100);
+        std::vector<std::shared_ptr<int>> popped(30);
+        EXPECT_EQ(q.try_dequeue_bulk(popped.begin(), 30), 30);
+        popped.clear();
+        EXPECT_EQ(tracker.use_count(), 1 + 70);
+    }
+    // the destructor destroys whatever is left
+    EXPECT_EQ(tracker.use_count(), 1);
+
+    ConcurrentQueue<std::string> strings;
+    strings.enqueue(std::string(40, 'x'));
+    std::string s;
+    EXPECT_TRUE(strings.try_dequeue(s));
+    EXPECT_EQ(s, std::string(40, 'x'));
+}
+
+TEST(ConcurrentQueueTest, ManyProducersAndConsumers) {
+    constexpr uint64_t kProducers = 4;
+    constexpr uint64_t kConsumers = 4;
+    constexpr uint64_t kPerProducer = 100000;
+    ConcurrentQueue<uint64_t, 16> q;
+
+    std::vector<std::thread> threads;
+    for (uint64_t p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&q, p] {
+            // half with tokens and bulk, half without a token one at a time
+            if (p % 2 == 0) {
+                ConcurrentQueue<uint64_t, 16>::ProducerToken token(q);
+                uint64_t batch[37];
+                for (uint64_t i = 0; i < kPerProducer;) {
+                    uint64_t n = std::min<uint64_t>(37, kPerProducer - i);
+                    for (uint64_t j = 0; j < n; ++j) {
+                        batch[j] = p * kPerProducer + i + j;
+                    }
+                    q.enqueue_bulk(token, batch, n);
+                    i += n;
+                }
+            } else {
+                for (uint64_t i = 0; i < kPerProducer; ++i) {
+                    q.enqueue(p * kPerProducer + i);
+                }
+            }
+        });
+    }
+
+    // every value exactly once, and each producer's values in the order it enqueued them
+    std::atomic<uint64_t> remaining = kProducers * kPerProducer;
+    std::vector<std::vector<uint64_t>> seen(kConsumers);
+    for (uint64_t c = 0; c < kConsumers; ++c) {
+        threads.emplace_back([&q, &seen, &remaining, c] {
+            ConcurrentQueue<uint64_t, 16>::ConsumerToken token(q);
+            uint64_t batch[64];
+            while (remaining.load(std::memory_order_relaxed) > 0) {
+                size_t n = c % 2 == 0 ? q.try_dequeue_bulk(token, batch, 64) : q.try_dequeue_bulk(batch, 7);
+                if (n == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                seen[c].insert(seen[c].end(), batch, batch + n);
+                remaining.fetch_sub(n, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    std::vector<int> count(kProducers * kPerProducer, 0);
+    bool inOrder = true;
+    for (const auto& values : seen) {
+        std::vector<uint64_t> last(kProducers, 0);
+        std::vector<bool> any(kProducers, false);
+        for (uint64_t v : values) {
+            count[v]++;
+            uint64_t p = v / kPerProducer;
+            inOrder &= !any[p] || v > last[p];
+            last[p] = v;
+            any[p] = true;
+        }
+    }
+    for (int n : count) {
+        ASSERT_EQ(n, 1);
+    }
+    EXPECT_TRUE(inOrder);
+    EXPECT_EQ(q.size_approx(), 0);
+}
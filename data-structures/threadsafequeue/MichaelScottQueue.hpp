@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "../../concurrency/hazardpointers/HazardPointers.hpp"
+
+// Unbounded lock-free multi producer / multi consumer queue (Michael & Scott, 1996), with the same
+// push / try_pop / wait_pop as ThreadSafeQueue.
+// A singly linked list with a dummy node at the front: mHead points at the dummy, the real elements are the
+// nodes after it, mTail points at the last node (or one behind, see below).
+//
+//   push      links a new node after the last one with a CAS on last->next, then swings mTail to it
+//   pop       CASes mHead from the dummy to the first real node, which becomes the new dummy. Its value is
+//             moved out and the old dummy is retired
+//
+// The two steps of a push arent atomic together, so mTail can be one node behind. Whoever sees that (tail
+// has a next) just swings it forward for the pusher and tries again, so a thread stopped between the two
+// steps never blocks anyone. Producers only fight over the tail and consumers over the head, unlike
+// ThreadSafeQueue where they all share one mutex.
+//
+// Nodes are freed through hazard pointers (concurrency/hazardpointers): a pop only dereferences the head and
+// its next after protecting them, and the old dummy is retired instead of deleted, so a thread that loaded it
+// a moment ago can still read its next pointer safely.
+// wait_pop yields a few times and then sleeps on an atomic (std::atomic::wait, a futex on Linux). push only
+// touches that atomic when the waiting counter says someone is asleep.
+//
+// One allocation per push, for a bounded queue without that see BoundedMpmcQueue. Elements have to move
+// without throwing (the value is moved out after the pop is already decided).
+
+template <typename T>
+requires (std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>)
+class MichaelScottQueue {
+private:
+    static constexpr int kYieldsBeforeSleep = 16;
+
+public:
+    explicit MichaelScottQueue(HazardPointerDomain& domain = HazardPointerDomain::global()): mDomain(domain) {
+        Node* dummy = new Node;
+        mHead.store(dummy, std::memory_order_relaxed);
+        mTail.store(dummy, std::memory_order_relaxed);
+    }
+
+    MichaelScottQueue(const MichaelScottQueue&) = delete;
+    MichaelScottQueue& operator=(const MichaelScottQueue&) = delete;
+
+    // nobody else can be using the queue anymore, so plain deletes (the old dummies were retired already)
+    ~MichaelScottQueue() {
+        Node* node = mHead.load(std::memory_order_relaxed);
+        Node* next = node->next.load(std::memory_order_relaxed);
+        delete node;
+        while (next) {
+            node = next;
+            next = node->next.load(std::memory_order_relaxed);
+            node->value()->~T();
+            delete node;
+        }
+    }
+
+    void push(const T& value) {
+        emplace(value);
+    }
+
+    void push(T&& value) {
+        emplace(std::move(value));
+    }
+
+    template <typename... U>
+    requires std::constructible_from<T, U...>
+    void emplace(U&&... args) {
+        // built before its linked in, a throwing constructor leaves the queue untouched
+        Node* node = new Node;
+        try {
+            new (node->storage) T(std::forward<U>(args)...);
+        } catch (...) {
+            delete node;
+            throw;
+        }
+        link(node);
+    }
+
+    // false if the queue is empty
+    bool try_pop(T& result) {
+        HazardPointer hpHead(mDomain);
+        HazardPointer hpNext(mDomain);
+        while (true) {
+            Node* head = hpHead.protect(mHead);
+            Node* tail = mTail.load(std::memory_order_acquire);
+            Node* next = hpNext.protect(head->next);
+            // head still the head means it wasnt retired, so next wasnt either
+            if (head != mHead.load(std::memory_order_acquire)) {
+                continue;
+            }
+            if (!next) {
+                return false;
+            }
+            if (head == tail) {
+                // a push linked next but hasnt swung the tail yet, do it for it
+                mTail.compare_exchange_strong(tail, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            if (mHead.compare_exchange_strong(head, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                // next is the new dummy, only the thread that won the CAS touches its value
+                T* value = next->value();
+                result = std::move(*value);
+                value->~T();
+                hpNext.reset_protection();
+                hpHead.reset_protection();
+                head->retire(mDomain);
+                return true;
+            }
+        }
+    }
+
+    // blocks until theres an element
+    void wait_pop(T& result) {
+        for (int i = 0; i < kYieldsBeforeSleep; i++) {
+            if (try_pop(result)) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+        while (true) {
+            mWaiting.fetch_add(1, std::memory_order_seq_cst);
+            // read before the last try: a push after it sees mWaiting and moves mWakeups on
+            uint32_t seen = mWakeups.load(std::memory_order_seq_cst);
+            if (try_pop(result)) {
+                mWaiting.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+            mWakeups.wait(seen, std::memory_order_seq_cst);
+            mWaiting.fetch_sub(1, std::memory_order_relaxed);
+            if (try_pop(result)) {
+                return;
+            }
+        }
+    }
+
+    // only a snapshot while other threads are pushing and popping
+    bool empty() const {
+        HazardPointer hp(mDomain);
+        Node* head = hp.protect(mHead);
+        return head->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node : HazardPointerObjBase<Node> {
+        T* value() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+
+        std::atomic<Node*> next{nullptr};
+        // constructed by push, destroyed by the pop that takes it. The dummy never holds one
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    void link(Node* node) {
+        HazardPointer hp(mDomain);
+        while (true) {
+            Node* tail = hp.protect(mTail);
+            Node* next = tail->next.load(std::memory_order_acquire);
+            if (next) {
+                // tail fell behind, help it along
+                mTail.compare_exchange_strong(tail, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+            Node* expected = nullptr;
+            // seq_cst, pairs with wait_pop counting itself in before its last look at the queue
+            if (tail->next.compare_exchange_strong(expected, node, std::memory_order_seq_cst)) {
+                mTail.compare_exchange_strong(tail, node, std::memory_order_release, std::memory_order_relaxed);
+                break;
+            }
+        }
+        if (mWaiting.load(std::memory_order_seq_cst) != 0) {
+            mWakeups.fetch_add(1, std::memory_order_seq_cst);
+            mWakeups.notify_all();
+        }
+    }
+
+    HazardPointerDomain& mDomain;
+    // consumers hammer one, producers the other
+    alignas(64) std::atomic<Node*> mHead;
+    alignas(64) std::atomic<Node*> mTail;
+    alignas(64) std::atomic<uint32_t> mWaiting{0};
+    std::atomic<uint32_t> mWakeups{0};
+};
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MichaelScottQueue.hpp"
+
+TEST(MichaelScottQueueTest, FifoOnOneThread) {
+    MichaelScottQueue<int> q;
+    EXPECT_TRUE(q.empty());
+    int out = -1;
+    EXPECT_FALSE(q.try_pop(out));
+
+    for (int i = 0; i < 1000; ++i) {
+        q.push(i);
+    }
+    EXPECT_FALSE(q.empty());
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(q.try_pop(out));
+        EXPECT_EQ(out, i);
+    }
+    EXPECT_FALSE(q.try_pop(out));
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(MichaelScottQueueTest, OwnsNonTrivialElements) {
+    auto tracker = std::make_shared<int>(0);
+    HazardPointerDomain domain;
+    {
+        MichaelScottQueue<std::shared_ptr<int>> q(domain);
+        q.push(tracker);
+        q.push(tracker);
+        q.push(tracker);
+        std::shared_ptr<int> out;
+        EXPECT_TRUE(q.try_pop(out));
+        out.reset();
+        EXPECT_EQ(tracker.use_count(), 1 + 2);
+    }
+    // the destructor destroys whatever is left
+    EXPECT_EQ(tracker.use_count(), 1);
+
+    MichaelScottQueue<std::string> strings(domain);
+    strings.emplace(40, 'x');
+    std::string s;
+    strings.wait_pop(s);
+    EXPECT_EQ(s, std::string(40, 'x'));
+
+    // a throwing constructor never gets linked in
+    MichaelScottQueue<std::string> q(domain);
+    EXPECT_THROW(q.emplace(std::string("abc"), 10), std::out_of_range);
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(MichaelScottQueueTest, WaitPopSleepsUntilAPush) {
+    MichaelScottQueue<int> q;
+    int result = 0;
+    std::thread consumer([&] {
+        q.wait_pop(result);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    q.push(42);
+    consumer.join();
+    EXPECT_EQ(result, 42);
+}
+
+TEST(MichaelScottQueueTest, ManyProducersAndConsumers) {
+    constexpr uint64_t kProducers = 4;
+    constexpr uint64_t kConsumers = 4;
+    constexpr uint64_t kPerProducer = 50000;
+    // own domain, so the check at the end only sees this queue's nodes
+    HazardPointerDomain domain;
+    {
+        MichaelScottQueue<uint64_t> q(domain);
+        std::vector<std::thread> threads;
+        for (uint64_t p = 0; p < kProducers; ++p) {
+            threads.emplace_back([&q, p] {
+                for (uint64_t i = 0; i < kPerProducer; ++i) {
+                    q.push(p * kPerProducer + i);
+                }
+            });
+        }
+
+        // every value exactly once, and each producer's values in the order it pushed them
+        std::vector<std::vector<uint64_t>> seen(kConsumers);
+        for (uint64_t c = 0; c < kConsumers; ++c) {
+            threads.emplace_back([&q, &seen, c] {
+                for (uint64_t i = 0; i < kProducers * kPerProducer / kConsumers; ++i) {
+                    uint64_t value;
+                    if (i % 2 == 0) {
+                        q.wait_pop(value);
+                    } else {
+                        while (!q.try_pop(value)) {
+                            std::this_thread::yield();
+                        }
+                    }
+                    seen[c].push_back(value);
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        std::vector<int> count(kProducers * kPerProducer, 0);
+        bool inOrder = true;
+        for (const auto& values : seen) {
+            std::vector<uint64_t> last(kProducers, 0);
+            std::vector<bool> any(kProducers, false);
+            for (uint64_t v : values) {
+                count[v]++;
+                uint64_t p = v / kPerProducer;
+                inOrder &= !any[p] || v > last[p];
+                last[p] = v;
+                any[p] = true;
+            }
+        }
+        for (int n : count) {
+            ASSERT_EQ(n, 1);
+        }
+        EXPECT_TRUE(inOrder);
+        EXPECT_TRUE(q.empty());
+    }
+    // the old dummies dont pile up, a scan frees them in batches
+    EXPECT_LT(domain.retired_count(), 2 * HazardPointerDomain::kMinRetireBatch);
+    domain.reclaim();
+    EXPECT_EQ(domain.retired_count(), 0);
+}
@@ -0,0 +1,154 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "BoundedMpmcQueue.hpp"
+#include "ConcurrentQueue.hpp"
+#include "MichaelScottQueue.hpp"
+#include "ThreadSafeQueue.hpp"
+
+// Google Benchmark, link with -lbenchmark -lbenchmark_main -pthread
+// Wall clock everywhere (UseRealTime), the cpu time of the calling thread alone says nothing once other
+// threads do the work. Args are {producers, consumers}.
+
+namespace {
+
+constexpr uint64_t kMessages = 1 << 20;
+constexpr size_t kBoundedCapacity = 1024;
+
+// every producer pushes its share with push, every consumer takes its share with wait_pop. The sum is checked
+// so a lost or doubled message cant hide behind a fast number
+template <typename Queue>
+void runProducersConsumers(benchmark::State& state, Queue& q) {
+    const uint64_t producers = state.range(0);
+    const uint64_t consumers = state.range(1);
+    std::atomic<uint64_t> sum = 0;
+    std::vector<std::thread> threads;
+    for (uint64_t p = 0; p < producers; p++) {
+        threads.emplace_back([&q, p, producers] {
+            for (uint64_t i = p; i < kMessages; i += producers) {
+                q.push(i);
+            }
+        });
+    }
+    for (uint64_t c = 0; c < consumers; c++) {
+        threads.emplace_back([&q, &sum, c, consumers] {
+            uint64_t local = 0;
+            for (uint64_t i = c; i < kMessages; i += consumers) {
+                uint64_t value;
+                q.wait_pop(value);
+                local += value;
+            }
+            sum += local;
+        });
+    }
+    for (auto& t: threads) {
+        t.join();
+    }
+    if (sum != kMessages * (kMessages - 1) / 2) {
+        state.SkipWithError("messages lost");
+    }
+}
+
+} // namespace
+
+// ---- BoundedMpmcQueue and MichaelScottQueue vs ThreadSafeQueue (one mutex + condition variable) ----
+// messages per second through the queue with more and more threads on each side. MichaelScottQueue and
+// ThreadSafeQueue are unbounded (producers never wait), BoundedMpmcQueue makes producers wait when its full
+
+static void BM_ThreadSafeQueue(benchmark::State& state) {
+    for (auto _: state) {
+        ThreadSafeQueue<uint64_t> q;
+        runProducersConsumers(state, q);
+    }
+    state.SetItemsProcessed(state.iterations() * kMessages);
+}
+
+static void BM_BoundedMpmcQueue(benchmark::State& state) {
+    for (auto _: state) {
+        BoundedMpmcQueue<uint64_t> q(kBoundedCapacity);
+        runProducersConsumers(state, q);
+    }
+    state.SetItemsProcessed(state.iterations() * kMessages);
+}
+
+static void BM_MichaelScottQueue(benchmark::State& state) {
+    for (auto _: state) {
+        MichaelScottQueue<uint64_t> q;
+        runProducersConsumers(state, q);
+    }
+    state.SetItemsProcessed(state.iterations() * kMessages);
+}
+
+#define PRODUCER_CONSUMER_COUNTS                                                                           \
+    ->Args({1, 1})->Args({2, 2})->Args({4, 4})->Args({8, 8})->Args({1, 4})->Args({4, 1})->UseRealTime()      \
+    ->Unit(benchmark::kMillisecond)
+
+BENCHMARK(BM_ThreadSafeQueue) PRODUCER_CONSUMER_COUNTS;
+BENCHMARK(BM_BoundedMpmcQueue) PRODUCER_CONSUMER_COUNTS;
+BENCHMARK(BM_MichaelScottQueue) PRODUCER_CONSUMER_COUNTS;
+
+// ---- ConcurrentQueue, batches through producer / consumer tokens ----
+// Args are {producers, consumers, batch}. A batch of n is n element copies and one atomic store on the way
+// in, one CAS on the way out. Batch 1 is the per element cost to hold against the queues above. No blocking
+// pop, consumers yield when theres nothing
+
+static void BM_ConcurrentQueueBulk(benchmark::State& state) {
+    const uint64_t producers = state.range(0);
+    const uint64_t consumers = state.range(1);
+    const size_t batchSize = state.range(2);
+    for (auto _: state) {
+        ConcurrentQueue<uint64_t> q;
+        std::atomic<uint64_t> sum = 0;
+        std::atomic<uint64_t> remaining = kMessages;
+        std::vector<std::thread> threads;
+        for (uint64_t p = 0; p < producers; p++) {
+            threads.emplace_back([&q, p, producers, batchSize] {
+                ConcurrentQueue<uint64_t>::ProducerToken token(q);
+                std::vector<uint64_t> batch(batchSize);
+                uint64_t next = p;
+                while (next < kMessages) {
+                    size_t n = 0;
+                    for (; n < batchSize && next < kMessages; n++, next += producers) {
+                        batch[n] = next;
+                    }
+                    q.enqueue_bulk(token, batch.data(), n);
+                }
+            });
+        }
+        for (uint64_t c = 0; c < consumers; c++) {
+            threads.emplace_back([&q, &sum, &remaining, batchSize] {
+                ConcurrentQueue<uint64_t>::ConsumerToken token(q);
+                std::vector<uint64_t> batch(batchSize);
+                uint64_t local = 0;
+                while (remaining.load(std::memory_order_relaxed) > 0) {
+                    size_t n = q.try_dequeue_bulk(token, batch.data(), batchSize);
+                    if (n == 0) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    for (size_t i = 0; i < n; i++) {
+                        local += batch[i];
+                    }
+                    remaining.fetch_sub(n, std::memory_order_relaxed);
+                }
+                sum += local;
+            });
+        }
+        for (auto& t: threads) {
+            t.join();
+        }
+        if (sum != kMessages * (kMessages - 1) / 2) {
+            state.SkipWithError("messages lost");
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kMessages);
+}
+
+BENCHMARK(BM_ConcurrentQueueBulk)
+    ->ArgsProduct({{1, 4, 8}, {1, 4}, {1, 16, 256}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
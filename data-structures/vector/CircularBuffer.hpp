@@ -1,7 +1,19 @@
+#pragma once
+
 #include <vector>
+#include <algorithm>
+#include <array>
+#include <span>
+#include <utility>
 #include <stdexcept>   // for std::out_of_range
 #include <concepts>    // for std::convertible_to
 
+// What push_back does when the buffer is full
+enum class CircularBufferMode {
+    Throw,     // throws std::out_of_range (the default)
+    Overwrite, // drops the oldest element to make room, for lossy stuff like telemetry where the newest matters most
+    Grow,      // doubles the capacity, copying the elements over so they start at index 0 again
+};
 
 template<typename T>
 class CircularBuffer {
@@ -12,13 +24,17 @@ private:
     int front;
     int back;
     int size_;
+    CircularBufferMode mode;
+    // elements Overwrite mode has dropped so far
+    size_t overwritten_ = 0;
 public:
 
-    CircularBuffer(int _capacity) {
+    CircularBuffer(int _capacity, CircularBufferMode _mode = CircularBufferMode::Throw) {
         this->capacity = _capacity;
         this->front = 0;
         this->back = 0;
         this->size_ = 0;
+        this->mode = _mode;
         array.resize(capacity);
     }
     
@@ -35,9 +51,8 @@ public:
     }
 
     bool is_empty() const noexcept {
-        return front == back;
-        // or return size_ == 0;
-        // or return size() == 0;
+        // not front == back, thats also true when its full
+        return size_ == 0;
     }
     // Pass by value when you need your own copy (e.g. to store or modify it).
     // Pass by const reference when you only need read-only access (no copy).
@@ -56,48 +71,33 @@ public:
     //    U deduces to that other type, and std::forward<U>(v) passes it through to T’s constructor or assignment.
     template<std::convertible_to<T> U>
     void push_back(U&& v) {
-      if (is_full()) {
-        throw out_of_range("Circularbuffer is full");
-      }
-      array[back] = std::forward<U>(v);
-      back = (back + 1) % capacity;
-      size_++;
+      push(std::forward<U>(v));
     }
 
     // Overload for rvalues: binds to prvalues (e.g. T{}, temporaries) or xvalues
     // (e.g. std::move(x)), and moves from them into the buffer.
     void push_back(T&& v) {
-      if (is_full()) {
-        throw out_of_range("Circularbuffer is full");
-      }
       // still have to move because you have to make the lvalue reference "v" which is the argument, into an rvalue reference
       // end of the day there is only one "v" in memory - inside the array, and no where else. Original object and argument v are left in a valid but unspecified state
       // This "state" refers to how the move is dealt with within the class T itself
-      array[back] = std::move(v);
-      back = (back + 1) % capacity;
-      size_++;
+      push(std::move(v));
     }
 
     // const lvalue allows u to enter non const lvalues, const lvalues and rvalues (altho i have a more specific rvalue push back here)
     // non const lvalue allows you to only take in non const lvalues only
     void push_back(const T& v) {
-      if (is_full()) {
-        throw out_of_range("Circularbuffer is full");
-      }
-      array[back] = v; // copy constructor
-      back = (back + 1) % capacity;
-      size_++;
+      push(v); // copy assignment
     }
     
     void pop_front() {
         if (is_empty()) {
-            throw out_of_range("Circularbuffer is Empty");
+            throw std::out_of_range("Circularbuffer is Empty");
         } 
         front = (front + 1) % capacity;
         size_--;
     }
     
-    // Here the return type T is a copy, no need to overload on return type constness, just mark the method themselves const
+    // Returning a T here would be a copy, so get_front / get_back return references instead, overloaded on constness
     // Labelling the function here as const allow you to use this function on both a const and a non const caller eg
 
     //CircularBuffer<int> buf(10);   // buf is NOT const
@@ -109,19 +109,11 @@ public:
 
     // But if the method was not const, only a non const caller can call it
 
-    T get_back() const {
-        if (is_empty()) {
-            throw out_of_range("Circularbuffer is Empty");
-        } 
-
-        return (back == 0) ? array[capacity - 1] : array[back-1];        
-    }
-    
     // Returns a reference, so here you can modify the T in the internal array outside
     // Can only be called by a non const buffer
     T& get_back() {
         if (is_empty()) {
-            throw out_of_range("Circularbuffer is Empty");
+            throw std::out_of_range("Circularbuffer is Empty");
         } 
 
         return (back == 0) ? array[capacity - 1] : array[back-1];        
@@ -132,46 +124,161 @@ public:
     // can be called by both const and non const buffers
     const T& get_back() const {
         if (is_empty()) {
-            throw out_of_range("Circularbuffer is Empty");
+            throw std::out_of_range("Circularbuffer is Empty");
         } 
 
         return (back == 0) ? array[capacity - 1] : array[back-1];        
     }
 
-    T get_front() const {
+    const T& get_front() const {
         if (is_empty()) {
-            throw out_of_range("Circularbuffer is Empty");
+            throw std::out_of_range("Circularbuffer is Empty");
         } 
         return array[front];        
     }
 
-    const T& get_front() const {
+    T& get_front() {
         if (is_empty()) {
-            throw out_of_range("Circularbuffer is Empty");
+            throw std::out_of_range("Circularbuffer is Empty");
         } 
         return array[front];        
     }
 
-    T& get_front() {
+    // Moves the front element out and pops it, false (and no exception) if theres nothing there
+    bool try_pop_front(T& out) {
         if (is_empty()) {
-            throw out_of_range("Circularbuffer is Empty");
-        } 
-        return array[front];        
+            return false;
+        }
+        out = std::move(array[front]);
+        front = (front + 1) % capacity;
+        size_--;
+        return true;
+    }
+
+    // Pushes unless its full, false instead of the exception. In Overwrite and Grow mode it always pushes,
+    // except an Overwrite buffer of capacity 0: theres no oldest element to drop, so nothing ever fits
+    template<std::convertible_to<T> U>
+    bool try_push_back(U&& v) {
+      if (is_full() && (mode == CircularBufferMode::Throw
+                        || (mode == CircularBufferMode::Overwrite && capacity == 0))) {
+        return false;
+      }
+      push_back(std::forward<U>(v));
+      return true;
     }
 
     int size() const noexcept {
-        // Notice I also am using a size_ variable so I can just return size_ instead
-        // Just having different implementations
-        if (back == front) {
-            return 0;
+        // back == front both when its empty and when its full, so working it out from front and back
+        // doesnt work, size_ it is
+        return size_;
+    }
+
+    int get_capacity() const noexcept {
+        return capacity;
+    }
+
+    size_t overwritten() const noexcept {
+        return overwritten_;
+    }
+
+    // Moves the elements into a buffer of new_capacity, oldest at index 0 (so afterwards they are one contiguous
+    // run again). Grow mode does this on its own when its full
+    void resize(int new_capacity) {
+        if (new_capacity < size_) {
+            throw std::invalid_argument("Circularbuffer cant shrink below its size");
+        }
+        std::vector<T> next(new_capacity);
+        for (int i = 0; i < size_; i++) {
+            next[i] = std::move(array[(front + i) % capacity]);
+        }
+        array = std::move(next);
+        capacity = new_capacity;
+        front = 0;
+        back = capacity == 0 ? 0 : size_ % capacity;
+    }
+
+    // Zero copy access: the elements / the free slots as (at most) two contiguous runs each, in order.
+    // The second run is only non empty when they wrap around the end of the array.
+    // So a producer can memcpy / read() straight into writable_spans() and then commit_write(how many),
+    // and a consumer can write() straight out of readable_spans() and then consume(how many)
+    std::array<std::span<T>, 2> readable_spans() {
+        int first = std::min(size_, capacity - front);
+        return {std::span<T>(array.data() + front, first), std::span<T>(array.data(), size_ - first)};
+    }
+
+    std::array<std::span<const T>, 2> readable_spans() const {
+        int first = std::min(size_, capacity - front);
+        return {std::span<const T>(array.data() + front, first), std::span<const T>(array.data(), size_ - first)};
+    }
+
+    std::array<std::span<T>, 2> writable_spans() {
+        int free = capacity - size_;
+        int first = std::min(free, capacity - back);
+        return {std::span<T>(array.data() + back, first), std::span<T>(array.data(), free - first)};
+    }
+
+    // the next n free slots (written through writable_spans) are elements now
+    void commit_write(int n) {
+        if (n < 0 || n > capacity - size_) {
+            throw std::out_of_range("Circularbuffer commit past the free space");
+        }
+        if (n > 0) {
+            back = (back + n) % capacity;
+            size_ += n;
+        }
+    }
+
+    // pops the n oldest elements (after reading them through readable_spans)
+    void consume(int n) {
+        if (n < 0 || n > size_) {
+            throw std::out_of_range("Circularbuffer consume past the end");
         }
-        else if (back > front) {
-            return back - front;
+        if (n > 0) {
+            front = (front + n) % capacity;
+            size_ -= n;
         }
-        else {
-            return capacity - front + back;
+    }
+
+private:
+    template<typename U>
+    void push(U&& v) {
+      if (is_full()) {
+        if (mode == CircularBufferMode::Grow) {
+          // v can be one of our own elements (buf.push_back(buf.get_front())), and resize frees the array
+          // its in. So take the value out first and move it in after, same as std::vector::push_back
+          T value(std::forward<U>(v));
+          make_room();
+          array[back] = std::move(value);
+          back = (back + 1) % capacity;
+          size_++;
+          return;
         }
+        // Overwrite writes v over the oldest slot, which at worst is v itself: a self assignment, no realloc
+        make_room();
+      }
+      array[back] = std::forward<U>(v);
+      back = (back + 1) % capacity;
+      size_++;
+    }
 
+    // push_back on a full buffer
+    void make_room() {
+        switch (mode) {
+        case CircularBufferMode::Throw:
+            throw std::out_of_range("Circularbuffer is full");
+        case CircularBufferMode::Overwrite:
+            if (capacity == 0) {
+                throw std::out_of_range("Circularbuffer has no capacity");
+            }
+            // the push writes over the oldest slot (back == front when full), front just moves past it
+            front = (front + 1) % capacity;
+            size_--;
+            overwritten_++;
+            break;
+        case CircularBufferMode::Grow:
+            resize(capacity == 0 ? 1 : capacity * 2);
+            break;
+        }
     }
 };
 
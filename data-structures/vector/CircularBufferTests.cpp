@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "CircularBuffer.hpp"
+
+TEST(CircularBufferTest, ThrowModeIsTheDefault) {
+    CircularBuffer<int> buf(3);
+    buf.push_back(1);
+    buf.push_back(2);
+    buf.push_back(3);
+    EXPECT_TRUE(buf.is_full());
+    EXPECT_FALSE(buf.is_empty());
+    EXPECT_EQ(buf.size(), 3);
+    EXPECT_THROW(buf.push_back(4), std::out_of_range);
+    EXPECT_FALSE(buf.try_push_back(4));
+
+    EXPECT_EQ(buf.get_front(), 1);
+    EXPECT_EQ(buf.get_back(), 3);
+    buf.get_front() = 10;
+    int out = 0;
+    EXPECT_TRUE(buf.try_pop_front(out));
+    EXPECT_EQ(out, 10);
+    EXPECT_TRUE(buf.try_push_back(4));
+    EXPECT_EQ(buf.get_back(), 4);
+
+    buf.pop_front();
+    buf.pop_front();
+    buf.pop_front();
+    EXPECT_TRUE(buf.is_empty());
+    EXPECT_FALSE(buf.try_pop_front(out));
+    EXPECT_THROW(buf.pop_front(), std::out_of_range);
+}
+
+TEST(CircularBufferTest, OverwriteDropsTheOldest) {
+    CircularBuffer<std::string> buf(3, CircularBufferMode::Overwrite);
+    for (int i = 0; i < 7; ++i) {
+        buf.push_back(std::to_string(i));
+    }
+    EXPECT_EQ(buf.size(), 3);
+    EXPECT_EQ(buf.overwritten(), 4);
+    EXPECT_EQ(buf.get_front(), "4");
+    EXPECT_EQ(buf.get_back(), "6");
+    EXPECT_TRUE(buf.try_push_back("7"));
+    EXPECT_EQ(buf.get_front(), "5");
+
+    // nothing to drop, try_push_back says no instead of throwing
+    CircularBuffer<std::string> none(0, CircularBufferMode::Overwrite);
+    EXPECT_FALSE(none.try_push_back("x"));
+    EXPECT_TRUE(none.is_empty());
+    EXPECT_THROW(none.push_back("x"), std::out_of_range);
+
+    // Grow still pushes into a capacity 0 buffer
+    CircularBuffer<std::string> grows(0, CircularBufferMode::Grow);
+    EXPECT_TRUE(grows.try_push_back("x"));
+    EXPECT_EQ(grows.get_front(), "x");
+}
+
+TEST(CircularBufferTest, GrowKeepsTheOrder) {
+    CircularBuffer<int> buf(4, CircularBufferMode::Grow);
+    // wrap around first so growing has to put the elements back in order
+    for (int i = 0; i < 4; ++i) {
+        buf.push_back(i);
+    }
+    buf.pop_front();
+    buf.pop_front();
+    for (int i = 4; i < 20; ++i) {
+        buf.push_back(i);
+    }
+    EXPECT_EQ(buf.size(), 18);
+    EXPECT_EQ(buf.get_capacity(), 32);
+    for (int i = 2; i < 20; ++i) {
+        EXPECT_EQ(buf.get_front(), i);
+        buf.pop_front();
+    }
+
+    EXPECT_THROW(buf.resize(-1), std::invalid_argument);
+    buf.push_back(1);
+    buf.push_back(2);
+    EXPECT_THROW(buf.resize(1), std::invalid_argument);
+    buf.resize(2);
+    EXPECT_TRUE(buf.is_full());
+    EXPECT_EQ(buf.get_front(), 1);
+    EXPECT_EQ(buf.get_back(), 2);
+}
+
+TEST(CircularBufferTest, GrowPushOfOwnElement) {
+    // long enough to live on the heap, so reading the old array after the grow frees it shows up under ASan
+    std::string first(64, 'a');
+    std::string second(64, 'b');
+    CircularBuffer<std::string> buf(2, CircularBufferMode::Grow);
+    buf.push_back(first);
+    buf.push_back(second);
+    buf.push_back(buf.get_front());
+    ASSERT_EQ(buf.size(), 3);
+    EXPECT_EQ(buf.get_capacity(), 4);
+    EXPECT_EQ(buf.get_back(), first);
+    buf.push_back(second);
+    // full again, and the moved from element is the one the grow frees
+    buf.push_back(std::move(buf.get_back()));
+    EXPECT_EQ(buf.get_capacity(), 8);
+    EXPECT_EQ(buf.get_back(), second);
+    EXPECT_EQ(buf.get_front(), first);
+    buf.pop_front();
+    EXPECT_EQ(buf.get_front(), second);
+    buf.pop_front();
+    EXPECT_EQ(buf.get_front(), first);
+
+    // Overwrite mode writes over the oldest slot, pushing that same element is a self assignment
+    CircularBuffer<std::string> ring(2, CircularBufferMode::Overwrite);
+    ring.push_back(first);
+    ring.push_back(second);
+    ring.push_back(ring.get_front());
+    EXPECT_EQ(ring.get_front(), second);
+    EXPECT_EQ(ring.get_back(), first);
+}
+
+TEST(CircularBufferTest, SpansCoverTheWrapAround) {
+    CircularBuffer<char> buf(8);
+    auto [w1, w2] = buf.writable_spans();
+    EXPECT_EQ(w1.size(), 8);
+    EXPECT_EQ(w2.size(), 0);
+    std::memcpy(w1.data(), "abcdef", 6);
+    buf.commit_write(6);
+    buf.consume(4);
+
+    // "ef" at 4..5, free space is 6..7 and then 0..3
+    auto [r1, r2] = buf.readable_spans();
+    EXPECT_EQ(std::string(r1.begin(), r1.end()), "ef");
+    EXPECT_EQ(r2.size(), 0);
+    auto [f1, f2] = buf.writable_spans();
+    EXPECT_EQ(f1.size(), 2);
+    EXPECT_EQ(f2.size(), 4);
+    std::memcpy(f1.data(), "gh", 2);
+    std::memcpy(f2.data(), "ijk", 3);
+    buf.commit_write(5);
+    EXPECT_EQ(buf.size(), 7);
+    EXPECT_THROW(buf.commit_write(2), std::out_of_range);
+
+    const auto& cbuf = buf;
+    auto [c1, c2] = cbuf.readable_spans();
+    EXPECT_EQ(std::string(c1.begin(), c1.end()) + std::string(c2.begin(), c2.end()), "efghijk");
+    EXPECT_EQ(buf.get_back(), 'k');
+
+    buf.consume(7);
+    EXPECT_TRUE(buf.is_empty());
+    EXPECT_THROW(buf.consume(1), std::out_of_range);
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Byte ring buffer whose readable bytes and free space are always ONE contiguous span, never two.
+// (Linux only, it needs memfd_create)
+//
+// The trick is in the virtual memory: the capacity bytes of physical memory are mapped twice, back to back.
+// Address base + capacity + i is the same byte as base + i, so a run that would wrap past the end of the
+// array just keeps going into the second mapping and comes out at the start of the first one.
+// With CircularBuffer<char> a message that straddles the end comes back as two spans and a parser has to
+// copy it together first (or be written to handle a split in every field). Here readable() is always the
+// whole lot in one piece, so a parser can read frames in place, and read() / write() / recv() can fill or
+// drain the ring in one call.
+//
+//   writable()          the free space, write into it and then commit_write(n)
+//   readable()          the bytes in the ring, read them and then consume(n)
+//   write / read        copy in / out, as much as fits / as much as there is
+//   read_from(fd)       one ::read straight into the free space
+//   write_to(fd)        one ::write straight out of the readable bytes
+//
+// The capacity is rounded up to a power of two number of pages (the mappings work in whole pages).
+// Single threaded, like CircularBuffer.
+
+class MagicRingBuffer {
+public:
+    explicit MagicRingBuffer(size_t capacity) {
+        size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        mCapacity = std::bit_ceil(std::max(capacity, page));
+        mMask = mCapacity - 1;
+
+        int fd = ::memfd_create("MagicRingBuffer", MFD_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "memfd_create");
+        }
+        if (::ftruncate(fd, static_cast<off_t>(mCapacity)) != 0) {
+            int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "ftruncate");
+        }
+        // reserve 2 * capacity of address space first, so the two halves are guaranteed to end up next
+        // to each other, then map the file over each half
+        void* base = ::mmap(nullptr, 2 * mCapacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "mmap");
+        }
+        mData = static_cast<char*>(base);
+        for (size_t half = 0; half < 2; half++) {
+            void* p = ::mmap(mData + half * mCapacity, mCapacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                             fd, 0);
+            if (p == MAP_FAILED) {
+                int err = errno;
+                ::munmap(mData, 2 * mCapacity);
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), "mmap");
+            }
+        }
+        // the mappings keep the memory alive, the fd isnt needed anymore
+        ::close(fd);
+    }
+
+    MagicRingBuffer(const MagicRingBuffer&) = delete;
+    MagicRingBuffer& operator=(const MagicRingBuffer&) = delete;
+
+    MagicRingBuffer(MagicRingBuffer&& other) noexcept
+        : mData(std::exchange(other.mData, nullptr)),
+          mCapacity(std::exchange(other.mCapacity, 0)),
+          mMask(std::exchange(other.mMask, 0)),
+          mHead(std::exchange(other.mHead, 0)),
+          mTail(std::exchange(other.mTail, 0)) {}
+
+    MagicRingBuffer& operator=(MagicRingBuffer&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            mData = std::exchange(other.mData, nullptr);
+            mCapacity = std::exchange(other.mCapacity, 0);
+            mMask = std::exchange(other.mMask, 0);
+            mHead = std::exchange(other.mHead, 0);
+            mTail = std::exchange(other.mTail, 0);
+        }
+        return *this;
+    }
+
+    ~MagicRingBuffer() {
+        unmap();
+    }
+
+    std::span<char> readable() {
+        return {mData + (mHead & mMask), size()};
+    }
+
+    std::span<const char> readable() const {
+        return {mData + (mHead & mMask), size()};
+    }
+
+    std::span<char> writable() {
+        return {mData + (mTail & mMask), free_space()};
+    }
+
+    // the next n bytes of writable() are data now
+    void commit_write(size_t n) {
+        if (n > free_space()) {
+            throw std::out_of_range("MagicRingBuffer commit past the free space");
+        }
+        mTail += n;
+    }
+
+    // drops the first n bytes of readable()
+    void consume(size_t n) {
+        if (n > size()) {
+            throw std::out_of_range("MagicRingBuffer consume past the end");
+        }
+        mHead += n;
+    }
+
+    // copies in as much of data as fits, returns how much that was
+    size_t write(const void* data, size_t n) {
+        n = std::min(n, free_space());
+        if (n > 0) {
+            std::memcpy(writable().data(), data, n);
+            mTail += n;
+        }
+        return n;
+    }
+
+    // copies out (and consumes) up to n bytes, returns how many
+    size_t read(void* out, size_t n) {
+        n = std::min(n, size());
+        if (n > 0) {
+            std::memcpy(out, readable().data(), n);
+            mHead += n;
+        }
+        return n;
+    }
+
+    // one ::read(fd) into the free space, returns what ::read returned (bytes read, 0 at eof, -1 on error)
+    ssize_t read_from(int fd) {
+        std::span<char> space = writable();
+        ssize_t got = ::read(fd, space.data(), space.size());
+        if (got > 0) {
+            mTail += static_cast<size_t>(got);
+        }
+        return got;
+    }
+
+    // one ::write(fd) of the readable bytes, returns what ::write returned
+    ssize_t write_to(int fd) {
+        std::span<const char> bytes = std::as_const(*this).readable();
+        ssize_t put = ::write(fd, bytes.data(), bytes.size());
+        if (put > 0) {
+            mHead += static_cast<size_t>(put);
+        }
+        return put;
+    }
+
+    size_t size() const {
+        return mTail - mHead;
+    }
+
+    size_t free_space() const {
+        return mCapacity - size();
+    }
+
+    bool empty() const {
+        return mHead == mTail;
+    }
+
+    size_t capacity() const {
+        return mCapacity;
+    }
+
+private:
+    void unmap() {
+        if (mData) {
+            ::munmap(mData, 2 * mCapacity);
+            mData = nullptr;
+        }
+    }
+
+    char* mData = nullptr;
+    size_t mCapacity = 0;
+    size_t mMask = 0;
+    // both only grow, the offset into the mapping is index & mMask
+    size_t mHead = 0;
+    size_t mTail = 0;
+};
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include "MagicRingBuffer.hpp"
+
+TEST(MagicRingBufferTest, RoundsUpToWholePages) {
+    MagicRingBuffer ring(100);
+    EXPECT_EQ(ring.capacity(), static_cast<size_t>(::sysconf(_SC_PAGESIZE)));
+    MagicRingBuffer bigger(3 * ring.capacity());
+    EXPECT_EQ(bigger.capacity(), 4 * ring.capacity());
+}
+
+TEST(MagicRingBufferTest, BothHalvesAreTheSameMemory) {
+    MagicRingBuffer ring(4096);
+    size_t cap = ring.capacity();
+    char* base = ring.writable().data();
+    base[0] = 'a';
+    EXPECT_EQ(base[cap], 'a');
+    base[cap + 5] = 'b';
+    EXPECT_EQ(base[5], 'b');
+}
+
+TEST(MagicRingBufferTest, RunsAcrossTheEndStayContiguous) {
+    MagicRingBuffer ring(4096);
+    size_t cap = ring.capacity();
+    std::string filler(cap - 3, 'x');
+    EXPECT_EQ(ring.write(filler.data(), filler.size()), filler.size());
+    ring.consume(filler.size());
+
+    // starts 3 bytes before the end of the array and carries on at the start
+    EXPECT_EQ(ring.write("hello world", 11), 11);
+    std::span<char> bytes = ring.readable();
+    EXPECT_EQ(std::string_view(bytes.data(), bytes.size()), "hello world");
+    EXPECT_EQ(ring.writable().size(), cap - 11);
+
+    char out[5];
+    EXPECT_EQ(ring.read(out, 5), 5);
+    EXPECT_EQ(std::string_view(out, 5), "hello");
+    EXPECT_EQ(ring.size(), 6);
+
+    EXPECT_THROW(ring.consume(7), std::out_of_range);
+    EXPECT_THROW(ring.commit_write(cap), std::out_of_range);
+    std::string full(cap, 'y');
+    EXPECT_EQ(ring.write(full.data(), full.size()), cap - 6);
+    EXPECT_EQ(ring.free_space(), 0);
+}
+
+TEST(MagicRingBufferTest, FramedMessagesParseInPlace) {
+    MagicRingBuffer ring(4096);
+    uint32_t nextWrite = 0;
+    uint32_t nextRead = 0;
+    // frames of 4 byte length + that many bytes, lengths chosen so they straddle the end all the time
+    for (int round = 0; round < 2000; ++round) {
+        while (true) {
+            uint32_t len = 1 + nextWrite * 37 % 300;
+            if (ring.free_space() < sizeof(len) + len) {
+                break;
+            }
+            ring.write(&len, sizeof(len));
+            std::span<char> space = ring.writable();
+            std::memset(space.data(), static_cast<char>(nextWrite), len);
+            ring.commit_write(len);
+            nextWrite++;
+        }
+        while (ring.size() >= sizeof(uint32_t)) {
+            std::span<char> bytes = ring.readable();
+            uint32_t len;
+            std::memcpy(&len, bytes.data(), sizeof(len));
+            ASSERT_EQ(len, 1 + nextRead * 37 % 300);
+            // the whole frame is one run, even when it wrapped
+            for (uint32_t i = 0; i < len; ++i) {
+                ASSERT_EQ(bytes[sizeof(len) + i], static_cast<char>(nextRead));
+            }
+            ring.consume(sizeof(len) + len);
+            nextRead++;
+        }
+    }
+    EXPECT_EQ(nextRead, nextWrite);
+}
+
+TEST(MagicRingBufferTest, FileDescriptorsAndMoves) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    MagicRingBuffer ring(4096);
+    std::string filler(ring.capacity() - 2, '.');
+    ring.write(filler.data(), filler.size());
+    ring.consume(filler.size());
+
+    ASSERT_EQ(::write(fds[1], "wrapped", 7), 7);
+    EXPECT_EQ(ring.read_from(fds[0]), 7);
+    MagicRingBuffer moved(std::move(ring));
+    EXPECT_EQ(ring.capacity(), 0);
+    EXPECT_EQ(moved.size(), 7);
+    EXPECT_EQ(moved.write_to(fds[1]), 7);
+    EXPECT_TRUE(moved.empty());
+
+    char out[8] = {};
+    ASSERT_EQ(::read(fds[0], out, 7), 7);
+    EXPECT_STREQ(out, "wrapped");
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
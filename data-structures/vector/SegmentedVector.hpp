@@ -0,0 +1,474 @@
+#pragma once
+
+#include <atomic>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Vector that grows by adding fixed size chunks instead of moving everything into a bigger buffer (like
+// std::deque, but only growing at the back).
+//
+//   stable addresses   an element never moves once its in, so pointers / references / indices into a
+//                      SegmentedVector stay good until that element is popped (or the whole thing cleared)
+//   no growth copies   growing allocates one more chunk of ChunkSize elements, nothing already in is touched.
+//                      A Vector that doubles copies every element again and again and for a moment needs the
+//                      old and the new buffer at once
+//   concurrent append  concurrent_push_back / concurrent_emplace_back can be called from any number of
+//                      threads at the same time (see below)
+//
+// The cost is on reads: element i is chunk i / ChunkSize, slot i % ChunkSize. ChunkSize is a power of two so
+// thats a shift and a mask, but its still a load of the chunk pointer before the load of the element, and the
+// elements are only contiguous within a chunk (no data(), no SIMD over the whole thing).
+//
+// Threads: the chunk pointers live in a directory that gets replaced by one twice as big when it fills up.
+// The old directories stay around until the SegmentedVector is destroyed, so a reader still holding one
+// reads valid chunk pointers from it, and so reading elements [0, size()) is safe while other threads append
+// (with push_back from one thread, or concurrent_push_back from many). pop_back, clear, assignment and swap
+// need the vector to themselves.
+//
+// concurrent_push_back takes a slot from an atomic counter, constructs the element there and marks the slot
+// ready. size() only moves past a slot once its ready, so [0, size()) is always fully constructed elements.
+// Nobody waits for anybody: whoever finishes the slot size() is stuck at moves size() on, past it and every
+// slot after it that finished in the meantime. So a thread that gets descheduled halfway through an append
+// holds size() back for a while, but not the other appenders. That also means the element you just appended
+// can still be past size() for a moment, so concurrent_push_back hands back a reference to it rather than an
+// index to look up.
+// The value is built before a slot is taken, so a throwing constructor leaves nothing behind. Running out of
+// memory for a new chunk after the slot is taken cant be undone (size() could never get past that slot) so
+// that calls std::terminate.
+
+template <typename T, size_t ChunkSize = 1024>
+requires (ChunkSize > 0 && (ChunkSize & (ChunkSize - 1)) == 0)
+class SegmentedVector {
+public:
+    static constexpr size_t chunk_size = ChunkSize;
+
+    template <bool Const>
+    class Iterator {
+    private:
+        using Owner = std::conditional_t<Const, const SegmentedVector, SegmentedVector>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using iterator_concept = std::random_access_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        Iterator() = default;
+        Iterator(Owner* owner, size_t pos): mOwner(owner), mPos(pos) {}
+
+        // iterator -> const_iterator
+        operator Iterator<true>() const requires (!Const) {
+            return {mOwner, mPos};
+        }
+
+        reference operator*() const {
+            return mOwner->slot(mPos);
+        }
+
+        pointer operator->() const {
+            return &mOwner->slot(mPos);
+        }
+
+        reference operator[](difference_type n) const {
+            return mOwner->slot(mPos + n);
+        }
+
+        Iterator& operator++() {
+            ++mPos;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++mPos;
+            return tmp;
+        }
+
+        Iterator& operator--() {
+            --mPos;
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            Iterator tmp = *this;
+            --mPos;
+            return tmp;
+        }
+
+        Iterator& operator+=(difference_type n) {
+            mPos += n;
+            return *this;
+        }
+
+        Iterator& operator-=(difference_type n) {
+            mPos -= n;
+            return *this;
+        }
+
+        friend Iterator operator+(Iterator it, difference_type n) {
+            return it += n;
+        }
+
+        friend Iterator operator+(difference_type n, Iterator it) {
+            return it += n;
+        }
+
+        friend Iterator operator-(Iterator it, difference_type n) {
+            return it -= n;
+        }
+
+        friend difference_type operator-(const Iterator& a, const Iterator& b) {
+            return static_cast<difference_type>(a.mPos) - static_cast<difference_type>(b.mPos);
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) {
+            return a.mPos == b.mPos;
+        }
+
+        friend std::strong_ordering operator<=>(const Iterator& a, const Iterator& b) {
+            return a.mPos <=> b.mPos;
+        }
+
+    private:
+        Owner* mOwner = nullptr;
+        size_t mPos = 0;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    SegmentedVector() = default;
+
+    // chunks come from resource, see Vector (the small directories of chunk pointers stay on the heap)
+    explicit SegmentedVector(std::pmr::memory_resource* resource): mResource(resource) {}
+
+    SegmentedVector(std::initializer_list<T> lst): SegmentedVector() {
+        reserve(lst.size());
+        for (const T& x: lst) {
+            push_back(x);
+        }
+    }
+
+    SegmentedVector(const SegmentedVector& other): SegmentedVector(other, nullptr) {}
+
+    SegmentedVector(const SegmentedVector& other, std::pmr::memory_resource* resource): SegmentedVector(resource) {
+        reserve(other.size());
+        for (const T& x: other) {
+            push_back(x);
+        }
+    }
+
+    // takes over the chunks, other is left empty
+    SegmentedVector(SegmentedVector&& other) noexcept: mResource(other.mResource) {
+        steal(other);
+    }
+
+    SegmentedVector& operator=(const SegmentedVector& other) {
+        if (this != &other) {
+            SegmentedVector tmp(other, mResource);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    SegmentedVector& operator=(SegmentedVector&& other) {
+        if (this == &other) {
+            return *this;
+        }
+        if (mResource == other.mResource) {
+            releaseAll();
+            steal(other);
+        } else {
+            // other's chunks belong to another resource, move the elements over into ours instead
+            clear();
+            reserve(other.size());
+            for (T& x: other) {
+                push_back(std::move(x));
+            }
+            other.clear();
+        }
+        return *this;
+    }
+
+    ~SegmentedVector() {
+        releaseAll();
+    }
+
+    void push_back(const T& val) {
+        emplace_back(val);
+    }
+
+    void push_back(T&& val) {
+        emplace_back(std::move(val));
+    }
+
+    // one appending thread at a time (readers can run alongside)
+    template <typename... U>
+    requires std::constructible_from<T, U...>
+    T& emplace_back(U&&... args) {
+        size_t pos = mSize.load(std::memory_order_relaxed);
+        if (pos == capacity()) {
+            growTo(pos / ChunkSize + 1);
+        }
+        T* p = &slot(pos);
+        new (p) T(std::forward<U>(args)...);
+        mClaimed.store(pos + 1, std::memory_order_relaxed);
+        // release: a reader that sees the new size also sees the element
+        mSize.store(pos + 1, std::memory_order_release);
+        return *p;
+    }
+
+    // any number of threads at once
+    T& concurrent_push_back(const T& val) requires std::is_nothrow_move_constructible_v<T> {
+        return concurrent_emplace_back(val);
+    }
+
+    T& concurrent_push_back(T&& val) requires std::is_nothrow_move_constructible_v<T> {
+        return publish(std::move(val));
+    }
+
+    template <typename... U>
+    requires (std::constructible_from<T, U...> && std::is_nothrow_move_constructible_v<T>)
+    T& concurrent_emplace_back(U&&... args) {
+        // anything that throws happens here, before we hold a slot everyone after us waits on
+        T value(std::forward<U>(args)...);
+        return publish(std::move(value));
+    }
+
+    void pop_back() {
+        size_t n = size();
+        if (n > 0) {
+            slot(n - 1).~T();
+            ready(n - 1).store(false, std::memory_order_relaxed);
+            mClaimed.store(n - 1, std::memory_order_relaxed);
+            mSize.store(n - 1, std::memory_order_release);
+        }
+    }
+
+    // destroys the elements but keeps the chunks for reuse
+    void clear() {
+        size_t n = size();
+        for (size_t i = 0; i < n; i++) {
+            slot(i).~T();
+            ready(i).store(false, std::memory_order_relaxed);
+        }
+        mClaimed.store(0, std::memory_order_relaxed);
+        mSize.store(0, std::memory_order_release);
+    }
+
+    // makes sure there are chunks for at least count elements. Worth doing before a burst of concurrent
+    // appends, then none of them has to stop and take the lock to add a chunk
+    void reserve(size_t count) {
+        growTo((count + ChunkSize - 1) / ChunkSize);
+    }
+
+    size_t size() const {
+        return mSize.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t capacity() const {
+        return chunk_count() * ChunkSize;
+    }
+
+    size_t chunk_count() const {
+        return mChunkCount.load(std::memory_order_acquire);
+    }
+
+    T& operator[](size_t pos) {
+        checkIndex(pos);
+        return slot(pos);
+    }
+
+    const T& operator[](size_t pos) const {
+        checkIndex(pos);
+        return slot(pos);
+    }
+
+    T& back() {
+        return (*this)[size() - 1];
+    }
+
+    iterator begin() {
+        return {this, 0};
+    }
+
+    iterator end() {
+        return {this, size()};
+    }
+
+    const_iterator begin() const {
+        return {this, 0};
+    }
+
+    const_iterator end() const {
+        return {this, size()};
+    }
+
+    void swap(SegmentedVector& other) {
+        if (mResource != other.mResource) {
+            // chunks cant change resource, go through moves like Vector::swap
+            SegmentedVector tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+            return;
+        }
+        SegmentedVector tmp(std::move(other));
+        other.steal(*this);
+        steal(tmp);
+    }
+
+    std::pmr::memory_resource* resource() const {
+        return mResource;
+    }
+
+private:
+    // chunk pointers, atomic since readers load them while a writer fills in the next one
+    struct Directory {
+        size_t capacity;
+        Directory* previous;
+        std::unique_ptr<std::atomic<T*>[]> chunks;
+    };
+
+    // unchecked, pos has to be below a size() this thread has seen. The directory needs acquire, it can be a
+    // newer one than that size knows about (some appender further on grew it). Its chunk pointer for pos was
+    // either copied in before the directory went out or stored before that size was, so relaxed is enough there
+    T& slot(size_t pos) const {
+        Directory* dir = mDirectory.load(std::memory_order_acquire);
+        // ChunkSize is a power of two, so these are a shift and a mask
+        return dir->chunks[pos / ChunkSize].load(std::memory_order_relaxed)[pos % ChunkSize];
+    }
+
+    void checkIndex(size_t pos) const {
+        if (pos >= size()) {
+            throw std::out_of_range("Index out of range");
+        }
+    }
+
+    T& publish(T&& value) noexcept {
+        size_t pos = mClaimed.fetch_add(1, std::memory_order_relaxed);
+        if (pos >= capacity()) {
+            // throwing out of a noexcept function terminates, see the top of the file
+            growTo(pos / ChunkSize + 1);
+        }
+        T* p = &slot(pos);
+        new (p) T(std::move(value));
+        ready(pos).store(true, std::memory_order_seq_cst);
+        advanceSize();
+        return *p;
+    }
+
+    // moves size() past every ready slot. Its seq_cst because of this race: we mark pos ready and read size(),
+    // while the thread finishing pos - 1 moves size() to pos and checks if pos is ready. With anything weaker
+    // both could miss the other's write and size() would stop at pos with nobody left to move it
+    void advanceSize() {
+        size_t s = mSize.load(std::memory_order_seq_cst);
+        // past capacity() there isnt even a chunk to look at (and nothing is ready there anyway)
+        while (s < capacity() && ready(s).load(std::memory_order_seq_cst)) {
+            // fails if someone else moved it, s is then reloaded and we carry on from there
+            if (mSize.compare_exchange_weak(s, s + 1, std::memory_order_seq_cst)) {
+                s++;
+            }
+        }
+    }
+
+    // the ready flags of a chunk are right behind its elements
+    std::atomic<unsigned char>& ready(size_t pos) const {
+        T* chunk = &slot(pos - pos % ChunkSize);
+        return reinterpret_cast<std::atomic<unsigned char>*>(chunk + ChunkSize)[pos % ChunkSize];
+    }
+
+    // adds chunks until there are at least count
+    void growTo(size_t count) {
+        if (chunk_count() >= count) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mGrowMtx);
+        size_t have = mChunkCount.load(std::memory_order_relaxed);
+        while (have < count) {
+            Directory* dir = mDirectory.load(std::memory_order_relaxed);
+            if (!dir || have == dir->capacity) {
+                dir = growDirectory(dir);
+            }
+            dir->chunks[have].store(allocateChunk(), std::memory_order_release);
+            mChunkCount.store(++have, std::memory_order_release);
+        }
+    }
+
+    // a copy of dir twice the size. dir itself stays alive (and valid) until we are destroyed
+    Directory* growDirectory(Directory* dir) {
+        size_t capacity = dir ? dir->capacity * 2 : 16;
+        auto* next = new Directory{capacity, dir, std::make_unique<std::atomic<T*>[]>(capacity)};
+        for (size_t i = 0; dir && i < dir->capacity; i++) {
+            next->chunks[i].store(dir->chunks[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        mDirectory.store(next, std::memory_order_release);
+        return next;
+    }
+
+    // ChunkSize elements and then a ready flag per element
+    static constexpr size_t kChunkBytes = sizeof(T) * ChunkSize + sizeof(std::atomic<unsigned char>) * ChunkSize;
+
+    T* allocateChunk() {
+        void* raw = mResource ? mResource->allocate(kChunkBytes, alignof(T))
+                              : ::operator new(kChunkBytes, std::align_val_t{alignof(T)});
+        T* chunk = static_cast<T*>(raw);
+        for (size_t i = 0; i < ChunkSize; i++) {
+            new (reinterpret_cast<std::atomic<unsigned char>*>(chunk + ChunkSize) + i) std::atomic<unsigned char>(0);
+        }
+        return chunk;
+    }
+
+    void deallocateChunk(T* p) {
+        if (mResource) {
+            mResource->deallocate(p, kChunkBytes, alignof(T));
+        } else {
+            ::operator delete(p, std::align_val_t{alignof(T)});
+        }
+    }
+
+    // destroys the elements and frees every chunk and directory
+    void releaseAll() {
+        clear();
+        Directory* dir = mDirectory.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < mChunkCount.load(std::memory_order_relaxed); i++) {
+            deallocateChunk(dir->chunks[i].load(std::memory_order_relaxed));
+        }
+        while (dir) {
+            delete std::exchange(dir, dir->previous);
+        }
+        mDirectory.store(nullptr, std::memory_order_relaxed);
+        mChunkCount.store(0, std::memory_order_relaxed);
+    }
+
+    // takes other's chunks and elements, we have to be empty and have no chunks. Same resource
+    void steal(SegmentedVector& other) noexcept {
+        mDirectory.store(other.mDirectory.exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+        mChunkCount.store(other.mChunkCount.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        mClaimed.store(other.mClaimed.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        mSize.store(other.mSize.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    std::atomic<size_t> mSize{0};       // constructed elements, [0, mSize) is safe to read
+    std::atomic<size_t> mClaimed{0};    // slots handed out to appenders, mSize catches up to it
+    std::atomic<size_t> mChunkCount{0};
+    // the current directory, it links back to all the older ones
+    std::atomic<Directory*> mDirectory{nullptr};
+    std::mutex mGrowMtx;
+    std::pmr::memory_resource* mResource = nullptr;
+};
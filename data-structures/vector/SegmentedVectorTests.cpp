@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SegmentedVector.hpp"
+
+TEST(SegmentedVectorTest, GrowsChunkByChunk) {
+    SegmentedVector<int, 4> vec;
+    EXPECT_TRUE(vec.empty());
+    EXPECT_EQ(vec.capacity(), 0);
+    for (int i = 0; i < 10; ++i) {
+        vec.push_back(i);
+    }
+    EXPECT_EQ(vec.size(), 10);
+    EXPECT_EQ(vec.chunk_count(), 3);
+    EXPECT_EQ(vec.capacity(), 12);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(vec[i], i);
+    }
+    EXPECT_EQ(vec.back(), 9);
+    EXPECT_THROW(vec[10], std::out_of_range);
+
+    vec.pop_back();
+    EXPECT_EQ(vec.size(), 9);
+    EXPECT_THROW(vec[9], std::out_of_range);
+
+    vec.reserve(100);
+    EXPECT_EQ(vec.capacity(), 100);
+    EXPECT_EQ(vec[8], 8);
+}
+
+TEST(SegmentedVectorTest, AddressesNeverMove) {
+    SegmentedVector<std::string, 8> vec;
+    vec.push_back("first");
+    std::string* first = &vec[0];
+    const char* firstChars = vec[0].data();
+    std::vector<std::string*> early;
+    for (int i = 0; i < 20; ++i) {
+        early.push_back(&vec.emplace_back(std::to_string(i)));
+    }
+    // way past the first directory (16 chunks) too
+    for (int i = 0; i < 10000; ++i) {
+        vec.emplace_back(50, 'x');
+    }
+    EXPECT_EQ(&vec[0], first);
+    EXPECT_EQ(vec[0].data(), firstChars);
+    EXPECT_EQ(*first, "first");
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(&vec[i + 1], early[i]);
+        EXPECT_EQ(*early[i], std::to_string(i));
+    }
+}
+
+TEST(SegmentedVectorTest, CopyMoveAndClear) {
+    SegmentedVector<std::string, 4> vec{"a", "b", "c", "d", "e"};
+    SegmentedVector<std::string, 4> copy(vec);
+    EXPECT_EQ(copy.size(), 5);
+    EXPECT_EQ(copy[4], "e");
+
+    std::string* third = &vec[2];
+    SegmentedVector<std::string, 4> moved(std::move(vec));
+    EXPECT_EQ(vec.size(), 0);
+    EXPECT_EQ(vec.capacity(), 0);
+    // the chunks were handed over, not copied
+    EXPECT_EQ(&moved[2], third);
+
+    copy = moved;
+    copy.push_back("f");
+    EXPECT_EQ(moved.size(), 5);
+    EXPECT_EQ(copy.size(), 6);
+
+    moved = std::move(copy);
+    EXPECT_EQ(moved.size(), 6);
+    EXPECT_EQ(moved[5], "f");
+
+    moved.swap(vec);
+    EXPECT_EQ(vec.size(), 6);
+    EXPECT_EQ(moved.size(), 0);
+
+    size_t capacity = vec.capacity();
+    vec.clear();
+    EXPECT_TRUE(vec.empty());
+    EXPECT_EQ(vec.capacity(), capacity);
+    vec.push_back("again");
+    EXPECT_EQ(vec[0], "again");
+}
+
+TEST(SegmentedVectorTest, IteratorsWorkWithStdAlgorithms) {
+    SegmentedVector<int, 16> vec;
+    for (int i = 0; i < 1000; ++i) {
+        vec.push_back((i * 7919) % 1000);
+    }
+    std::sort(vec.begin(), vec.end());
+    EXPECT_TRUE(std::is_sorted(vec.begin(), vec.end()));
+    EXPECT_EQ(vec[0], 0);
+    EXPECT_EQ(vec[999], 999);
+    EXPECT_EQ(std::accumulate(vec.begin(), vec.end(), 0), 999 * 1000 / 2);
+
+    const auto& cvec = vec;
+    auto it = std::lower_bound(cvec.begin(), cvec.end(), 500);
+    EXPECT_EQ(it - cvec.begin(), 500);
+    EXPECT_EQ(it[10], 510);
+    static_assert(std::random_access_iterator<SegmentedVector<int>::iterator>);
+    static_assert(std::random_access_iterator<SegmentedVector<int>::const_iterator>);
+}
+
+TEST(SegmentedVectorTest, ChunksComeFromTheResource) {
+    std::pmr::monotonic_buffer_resource pool;
+    SegmentedVector<uint64_t, 64> vec(&pool);
+    for (uint64_t i = 0; i < 1000; ++i) {
+        vec.push_back(i);
+    }
+    EXPECT_EQ(vec.resource(), &pool);
+
+    SegmentedVector<uint64_t, 64> heap;
+    heap = std::move(vec);
+    // other resource, so the elements got moved over into heap chunks and vec kept its chunks
+    EXPECT_EQ(heap.resource(), nullptr);
+    EXPECT_EQ(heap.size(), 1000);
+    EXPECT_EQ(heap[999], 999);
+    EXPECT_EQ(vec.size(), 0);
+}
+
+namespace {
+
+// b is always ~a, a reader that sees anything else caught an element half written
+struct Checked {
+    uint64_t a;
+    uint64_t b;
+
+    explicit Checked(uint64_t v): a(v), b(~v) {}
+};
+
+} // namespace
+
+TEST(SegmentedVectorTest, ConcurrentAppendsWithReaders) {
+    constexpr uint64_t kThreads = 4;
+    constexpr uint64_t kPerThread = 20000;
+    SegmentedVector<Checked, 128> vec;
+    std::atomic<bool> writing{true};
+    std::atomic<bool> torn{false};
+
+    std::thread reader([&] {
+        while (writing.load()) {
+            size_t n = vec.size();
+            for (size_t i = 0; i < n; i += 97) {
+                if (vec[i].b != ~vec[i].a) {
+                    torn = true;
+                }
+            }
+        }
+    });
+    std::vector<std::thread> writers;
+    std::vector<std::vector<const Checked*>> appended(kThreads);
+    for (uint64_t t = 0; t < kThreads; ++t) {
+        writers.emplace_back([&, t] {
+            for (uint64_t i = 0; i < kPerThread; ++i) {
+                appended[t].push_back(&vec.concurrent_emplace_back(t * kPerThread + i));
+            }
+        });
+    }
+    for (auto& writer: writers) {
+        writer.join();
+    }
+    writing = false;
+    reader.join();
+
+    EXPECT_FALSE(torn);
+    ASSERT_EQ(vec.size(), kThreads * kPerThread);
+    // the references the appends returned still point at their values
+    for (uint64_t t = 0; t < kThreads; ++t) {
+        for (uint64_t i = 0; i < kPerThread; ++i) {
+            EXPECT_EQ(appended[t][i]->a, t * kPerThread + i);
+        }
+    }
+    // and every value is in there exactly once
+    std::vector<bool> seen(kThreads * kPerThread);
+    for (const Checked& c: vec) {
+        EXPECT_FALSE(seen[c.a]);
+        seen[c.a] = true;
+    }
+    EXPECT_TRUE(std::all_of(seen.begin(), seen.end(), [](bool s) { return s; }));
+
+    // clear resets the ready flags, size() has to stop at the new end again
+    vec.clear();
+    vec.push_back(Checked(1));
+    vec.concurrent_push_back(Checked(2));
+    vec.concurrent_emplace_back(3);
+    EXPECT_EQ(vec.size(), 3);
+    EXPECT_EQ(vec[2].a, 3);
+}
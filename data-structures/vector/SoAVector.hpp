@@ -0,0 +1,219 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "Vector.hpp"
+
+// Structure of arrays: SoAVector<uint64_t, double, uint32_t> stores a Vector per field instead of one Vector
+// of structs, so row i is (column<0>()[i], column<1>()[i], column<2>()[i]).
+//
+// Scanning two fields of a Vector<Record> drags every other field of every record through the cache with
+// them (a 64 byte record and two 8 byte fields -> 3/4 of every cache line is wasted). With one column per
+// field a scan only reads the columns it uses, every byte it loads is one it needs, and a column is a plain
+// contiguous array the compiler can vectorise a loop over.
+//
+// Two ways in:
+//   rows    for (auto [id, price, qty]: soa) ...   the elements are std::tuple<Field&...> proxies into the
+//           columns, so structured bindings give references and writes go straight to the columns
+//   columns soa.column<1>() is a std::span over one field, loop over that for the fast scans.
+//           soa.column_vector<1>() is the column as a const Vector, so find / count / min / max on it
+//           take Vector's SIMD paths
+//
+// Rows are always complete: push / emplace either adds a value to every column or to none of them.
+
+template <typename... Fields>
+requires (sizeof...(Fields) > 0)
+class SoAVector {
+public:
+    // a whole row by value, what push_back takes
+    using value_type = std::tuple<Fields...>;
+    // row proxies, references into the columns
+    using reference = std::tuple<Fields&...>;
+    using const_reference = std::tuple<const Fields&...>;
+
+    template <size_t I>
+    using field_type = std::tuple_element_t<I, value_type>;
+
+    template <bool Const>
+    class RowIterator {
+    private:
+        using Owner = std::conditional_t<Const, const SoAVector, SoAVector>;
+
+    public:
+        // the rows are proxies, not real references, so as far as the std categories go this is only an input
+        // iterator (thats enough for range-for and the single pass algorithms)
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = SoAVector::value_type;
+        using reference = std::conditional_t<Const, SoAVector::const_reference, SoAVector::reference>;
+
+        RowIterator() = default;
+        RowIterator(Owner* owner, size_t pos): mOwner(owner), mPos(pos) {}
+
+        reference operator*() const {
+            return mOwner->row(mPos);
+        }
+
+        RowIterator& operator++() {
+            ++mPos;
+            return *this;
+        }
+
+        RowIterator operator++(int) {
+            RowIterator tmp = *this;
+            ++mPos;
+            return tmp;
+        }
+
+        friend bool operator==(const RowIterator& a, const RowIterator& b) {
+            return a.mPos == b.mPos;
+        }
+
+    private:
+        Owner* mOwner = nullptr;
+        size_t mPos = 0;
+    };
+
+    using iterator = RowIterator<false>;
+    using const_iterator = RowIterator<true>;
+
+    SoAVector() = default;
+
+    // every column allocates from resource (see Vector)
+    explicit SoAVector(std::pmr::memory_resource* resource): mColumns(Vector<Fields>(resource)...) {}
+
+    // appends a row, one argument per column
+    template <typename... Args>
+    requires (sizeof...(Args) == sizeof...(Fields) && (std::constructible_from<Fields, Args&&> && ...))
+    reference emplace_back(Args&&... args) {
+        growIfFull();
+        emplaceImpl(std::index_sequence_for<Fields...>{}, std::forward<Args>(args)...);
+        return row(size() - 1);
+    }
+
+    void push_back(const value_type& value) {
+        std::apply([this](const Fields&... fields) { emplace_back(fields...); }, value);
+    }
+
+    void pop_back() {
+        std::apply([](Vector<Fields>&... columns) { (columns.pop_back(), ...); }, mColumns);
+    }
+
+    void clear() {
+        std::apply([](Vector<Fields>&... columns) { (columns.clear(), ...); }, mColumns);
+    }
+
+    void reserve(size_t count) {
+        std::apply([count](Vector<Fields>&... columns) { (columns.reserve(count), ...); }, mColumns);
+    }
+
+    size_t size() const {
+        return std::get<0>(mColumns).size();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t capacity() const {
+        return std::get<0>(mColumns).capacity();
+    }
+
+    // row proxies, throw std::out_of_range like Vector::operator[]
+    reference operator[](size_t pos) {
+        checkIndex(pos);
+        return row(pos);
+    }
+
+    const_reference operator[](size_t pos) const {
+        checkIndex(pos);
+        return row(pos);
+    }
+
+    // one field of every row, contiguous
+    template <size_t I>
+    std::span<field_type<I>> column() {
+        auto& col = std::get<I>(mColumns);
+        return {col.data(), col.size()};
+    }
+
+    template <size_t I>
+    std::span<const field_type<I>> column() const {
+        const auto& col = std::get<I>(mColumns);
+        return {col.data(), col.size()};
+    }
+
+    // read only (so the columns cant get out of step), but with all of Vector's bulk queries
+    template <size_t I>
+    const Vector<field_type<I>>& column_vector() const {
+        return std::get<I>(mColumns);
+    }
+
+    // f(field) on every element of column I in place, see Vector::transform
+    template <size_t I, typename F>
+    void transform(F f) {
+        std::get<I>(mColumns).transform(std::move(f));
+    }
+
+    iterator begin() {
+        return {this, 0};
+    }
+
+    iterator end() {
+        return {this, size()};
+    }
+
+    const_iterator begin() const {
+        return {this, 0};
+    }
+
+    const_iterator end() const {
+        return {this, size()};
+    }
+
+private:
+    reference row(size_t pos) {
+        return std::apply([pos](Vector<Fields>&... columns) { return reference(columns.data()[pos]...); },
+                          mColumns);
+    }
+
+    const_reference row(size_t pos) const {
+        return std::apply(
+            [pos](const Vector<Fields>&... columns) { return const_reference(columns.data()[pos]...); }, mColumns);
+    }
+
+    void checkIndex(size_t pos) const {
+        if (pos >= size()) {
+            throw std::out_of_range("Index out of range");
+        }
+    }
+
+    // grows every column up front, so once the values start going in the only thing that can throw is
+    // a constructor of a field
+    void growIfFull() {
+        if (size() == capacity()) {
+            reserve(size() == 0 ? 1 : size() * 2);
+        }
+    }
+
+    template <size_t... I, typename... Args>
+    void emplaceImpl(std::index_sequence<I...>, Args&&... args) {
+        size_t done = 0;
+        try {
+            ((std::get<I>(mColumns).emplace_back(std::forward<Args>(args)), ++done), ...);
+        } catch (...) {
+            // take the half built row back out of the columns that already got their value
+            ((I < done ? std::get<I>(mColumns).pop_back() : void()), ...);
+            throw;
+        }
+    }
+
+    std::tuple<Vector<Fields>...> mColumns;
+};
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "SoAVector.hpp"
+
+TEST(SoAVectorTest, RowsAndColumnsSeeTheSameData) {
+    SoAVector<int, double, std::string> soa;
+    for (int i = 0; i < 100; ++i) {
+        soa.emplace_back(i, i * 0.5, std::to_string(i));
+    }
+    soa.push_back({100, 50.0, "100"});
+    EXPECT_EQ(soa.size(), 101);
+
+    auto [id, price, name] = soa[42];
+    EXPECT_EQ(id, 42);
+    EXPECT_EQ(price, 21.0);
+    EXPECT_EQ(name, "42");
+
+    // the row is references into the columns
+    id = -1;
+    EXPECT_EQ(soa.column<0>()[42], -1);
+    soa[43] = std::make_tuple(7, 7.5, std::string("seven"));
+    EXPECT_EQ(soa.column<2>()[43], "seven");
+
+    EXPECT_EQ(soa.column<1>().size(), 101);
+    EXPECT_EQ(soa.column<1>().back(), 50.0);
+    EXPECT_THROW(soa[101], std::out_of_range);
+
+    soa.pop_back();
+    EXPECT_EQ(soa.size(), 100);
+    EXPECT_EQ(soa.column<2>().size(), 100);
+}
+
+TEST(SoAVectorTest, RangeForWritesThrough) {
+    SoAVector<int, int> soa;
+    for (int i = 0; i < 10; ++i) {
+        soa.emplace_back(i, 0);
+    }
+    for (auto [a, b]: soa) {
+        b = a * a;
+    }
+    const auto& view = soa;
+    int sum = 0;
+    for (auto [a, b]: view) {
+        sum += b;
+    }
+    EXPECT_EQ(sum, 285);
+    EXPECT_EQ(std::count_if(soa.begin(), soa.end(), [](auto row) { return std::get<1>(row) > 10; }), 6);
+}
+
+TEST(SoAVectorTest, ColumnVectorAndTransform) {
+    SoAVector<uint32_t, float> soa;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        soa.emplace_back(i % 7, static_cast<float>(i));
+    }
+    // Vector's SIMD bulk queries on one column
+    EXPECT_EQ(soa.column_vector<0>().count(3), 143);
+    EXPECT_EQ(soa.column_vector<1>().max(), 999.0f);
+
+    soa.transform<1>([](float x) { return x * 2; });
+    EXPECT_EQ(soa.column<1>()[10], 20.0f);
+    EXPECT_EQ(soa.column<0>()[10], 3u);
+}
+
+namespace {
+
+// throws when built from a negative number, to break a row half way through
+struct Picky {
+    int value;
+    Picky(int v): value(v) {
+        if (v < 0) {
+            throw std::invalid_argument("negative");
+        }
+    }
+};
+
+} // namespace
+
+TEST(SoAVectorTest, FailedEmplaceLeavesNoHalfRow) {
+    SoAVector<std::string, Picky, int> soa;
+    soa.emplace_back("ok", 1, 1);
+    EXPECT_THROW(soa.emplace_back("bad", -1, 2), std::invalid_argument);
+    EXPECT_EQ(soa.size(), 1);
+    EXPECT_EQ(soa.column<0>().size(), 1);
+    EXPECT_EQ(soa.column<2>().size(), 1);
+    soa.emplace_back("next", 2, 3);
+    EXPECT_EQ(std::get<0>(soa[1]), "next");
+}
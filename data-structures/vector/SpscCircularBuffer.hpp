@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Ring buffer for exactly one producer thread and one consumer thread, no locks.
+// For handing messages from one thread to another (network thread -> parser thread), where CircularBuffer
+// behind a mutex makes both threads fight over the lock (and its cache line) on every message.
+//
+//   try_push / try_emplace   producer only, false if full
+//   try_pop                  consumer only, false if empty
+//   push_n / pop_n           as many as fit / as many as there are, out of or into an array, returns how many.
+//                            One index update for the whole batch instead of one per element
+//
+// How it stays cheap:
+//   - head and tail only ever grow (size_t doesnt wrap in practice), the slot is index & mask. So the capacity
+//     is rounded up to a power of two and theres no % on every push / pop
+//   - each index is only written by one side: the producer writes tail, the consumer writes head. Each sits on
+//     its own cache line so the two threads dont invalidate each other's line on every write (false sharing)
+//   - each side keeps a cached copy of the other side's index and only reads the real one (and pulls its cache
+//     line over from the other core) when the cached one says full / empty. With the producer ahead, it reads
+//     head once per trip around the ring instead of once per push
+//   - tail is stored with release after the element is written and loaded with acquire before it is read (and
+//     the same for head and the slot being free again), thats all the synchronisation there is
+
+template <typename T>
+class SpscCircularBuffer {
+private:
+    static constexpr size_t kCacheLine = 64;
+
+public:
+    // rounded up to a power of two
+    explicit SpscCircularBuffer(size_t capacity)
+        : mCapacity(std::bit_ceil(std::max<size_t>(capacity, 1))),
+          mMask(mCapacity - 1),
+          mSlots(static_cast<T*>(::operator new(sizeof(T) * mCapacity, std::align_val_t{alignof(T)}))) {}
+
+    SpscCircularBuffer(const SpscCircularBuffer&) = delete;
+    SpscCircularBuffer& operator=(const SpscCircularBuffer&) = delete;
+
+    ~SpscCircularBuffer() {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        for (size_t i = mHead.load(std::memory_order_relaxed); i != tail; i++) {
+            mSlots[i & mMask].~T();
+        }
+        ::operator delete(mSlots, std::align_val_t{alignof(T)});
+    }
+
+    bool try_push(const T& value) {
+        return try_emplace(value);
+    }
+
+    bool try_push(T&& value) {
+        return try_emplace(std::move(value));
+    }
+
+    template <typename... U>
+    requires std::constructible_from<T, U...>
+    bool try_emplace(U&&... args) {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHeadCache == mCapacity) {
+            mHeadCache = mHead.load(std::memory_order_acquire);
+            if (tail - mHeadCache == mCapacity) {
+                return false;
+            }
+        }
+        new (&mSlots[tail & mMask]) T(std::forward<U>(args)...);
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& out) {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTailCache) {
+            mTailCache = mTail.load(std::memory_order_acquire);
+            if (head == mTailCache) {
+                return false;
+            }
+        }
+        T& slot = mSlots[head & mMask];
+        out = std::move(slot);
+        slot.~T();
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // copies up to count items in, returns how many fit. All or nothing if a copy throws: the elements already
+    // built are destroyed again and none of them get published
+    size_t push_n(const T* items, size_t count) {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        size_t room = mCapacity - (tail - mHeadCache);
+        if (room < count) {
+            mHeadCache = mHead.load(std::memory_order_acquire);
+            room = mCapacity - (tail - mHeadCache);
+        }
+        size_t n = std::min(count, room);
+        // the free slots are at most two runs: up to the end of the array, then from the start
+        size_t first = std::min(n, mCapacity - (tail & mMask));
+        // each copy cleans up after itself if it throws, but the first run is finished by the time the second
+        // starts, and its not published yet so nothing else would ever destroy it
+        std::uninitialized_copy_n(items, first, mSlots + (tail & mMask));
+        try {
+            std::uninitialized_copy_n(items + first, n - first, mSlots);
+        } catch (...) {
+            std::destroy_n(mSlots + (tail & mMask), first);
+            throw;
+        }
+        mTail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    // moves up to count items out into out, returns how many there were
+    size_t pop_n(T* out, size_t count) {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        size_t available = mTailCache - head;
+        if (available < count) {
+            mTailCache = mTail.load(std::memory_order_acquire);
+            available = mTailCache - head;
+        }
+        size_t n = std::min(count, available);
+        size_t first = std::min(n, mCapacity - (head & mMask));
+        takeOut(mSlots + (head & mMask), first, out);
+        takeOut(mSlots, n - first, out + first);
+        mHead.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // exact from either side while the other one isnt running, a snapshot otherwise
+    size_t size_approx() const {
+        size_t head = mHead.load(std::memory_order_acquire);
+        size_t tail = mTail.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : 0;
+    }
+
+    bool empty_approx() const {
+        return size_approx() == 0;
+    }
+
+    size_t capacity() const {
+        return mCapacity;
+    }
+
+private:
+    // move assigns count slots into out and destroys them, one memcpy for trivial types
+    static void takeOut(T* slots, size_t count, T* out) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            std::copy_n(slots, count, out);
+        } else {
+            std::move(slots, slots + count, out);
+            std::destroy_n(slots, count);
+        }
+    }
+
+    // read only after construction, shared by both sides
+    const size_t mCapacity;
+    const size_t mMask;
+    T* const mSlots;
+
+    // producer's line
+    alignas(kCacheLine) std::atomic<size_t> mTail{0};
+    size_t mHeadCache = 0;
+
+    // consumer's line
+    alignas(kCacheLine) std::atomic<size_t> mHead{0};
+    size_t mTailCache = 0;
+    // the alignas also rounds sizeof up to whole lines, so nothing after us lands on the consumer's line
+};
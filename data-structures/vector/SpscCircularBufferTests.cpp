@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpscCircularBuffer.hpp"
+
+TEST(SpscCircularBufferTest, FillsUpAndEmptiesInOrder) {
+    SpscCircularBuffer<int> ring(5);
+    EXPECT_EQ(ring.capacity(), 8);
+    EXPECT_TRUE(ring.empty_approx());
+
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(ring.try_push(i));
+    }
+    EXPECT_FALSE(ring.try_push(8));
+    EXPECT_EQ(ring.size_approx(), 8);
+
+    int out = -1;
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(ring.try_pop(out));
+        EXPECT_EQ(out, i);
+    }
+    EXPECT_FALSE(ring.try_pop(out));
+
+    // round and round, past the end of the array many times
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(ring.try_emplace(i));
+        EXPECT_TRUE(ring.try_pop(out));
+        EXPECT_EQ(out, i);
+    }
+}
+
+TEST(SpscCircularBufferTest, BatchesWrapAround) {
+    SpscCircularBuffer<uint32_t> ring(16);
+    std::vector<uint32_t> in(40);
+    for (uint32_t i = 0; i < 40; ++i) {
+        in[i] = i;
+    }
+    std::vector<uint32_t> out(40);
+
+    EXPECT_EQ(ring.push_n(in.data(), 10), 10);
+    EXPECT_EQ(ring.pop_n(out.data(), 6), 6);
+    // only 12 free, and they are split over the end of the array
+    EXPECT_EQ(ring.push_n(in.data() + 10, 30), 12);
+    EXPECT_EQ(ring.size_approx(), 16);
+    EXPECT_EQ(ring.push_n(in.data() + 22, 1), 0);
+
+    EXPECT_EQ(ring.pop_n(out.data() + 6, 40), 16);
+    for (uint32_t i = 0; i < 22; ++i) {
+        EXPECT_EQ(out[i], i);
+    }
+    EXPECT_EQ(ring.pop_n(out.data(), 1), 0);
+}
+
+TEST(SpscCircularBufferTest, OwnsNonTrivialElements) {
+    auto tracker = std::make_shared<int>(0);
+    {
+        SpscCircularBuffer<std::shared_ptr<int>> ring(4);
+        EXPECT_TRUE(ring.try_push(tracker));
+        EXPECT_TRUE(ring.try_push(tracker));
+        std::vector<std::shared_ptr<int>> batch(3, tracker);
+        EXPECT_EQ(ring.push_n(batch.data(), 3), 2);
+        EXPECT_EQ(tracker.use_count(), 1 + 3 + 4);
+
+        std::shared_ptr<int> out;
+        EXPECT_TRUE(ring.try_pop(out));
+        batch.clear();
+        out.reset();
+        // one popped, one never got in, the rest still in the ring
+        EXPECT_EQ(tracker.use_count(), 1 + 3);
+
+        std::vector<std::shared_ptr<int>> popped(2);
+        EXPECT_EQ(ring.pop_n(popped.data(), 2), 2);
+        EXPECT_EQ(tracker.use_count(), 1 + 3);
+    }
+    // the destructor destroys whatever is left
+    EXPECT_EQ(tracker.use_count(), 1);
+
+    SpscCircularBuffer<std::string> strings(2);
+    EXPECT_TRUE(strings.try_emplace(40, 'x'));
+    std::string s;
+    EXPECT_TRUE(strings.try_pop(s));
+    EXPECT_EQ(s, std::string(40, 'x'));
+}
+
+namespace {
+
+// copying throws once copiesLeft runs out, live counts the instances
+struct ThrowingCopy {
+    static inline int live = 0;
+    static inline int copiesLeft = 0;
+
+    explicit ThrowingCopy(int v): value(v) {
+        live++;
+    }
+    ThrowingCopy(const ThrowingCopy& other): value(other.value) {
+        if (copiesLeft-- == 0) {
+            throw std::runtime_error("copy");
+        }
+        live++;
+    }
+    ~ThrowingCopy() {
+        live--;
+    }
+
+    int value;
+};
+
+} // namespace
+
+TEST(SpscCircularBufferTest, PushNThrowingCopyPushesNothing) {
+    {
+        SpscCircularBuffer<ThrowingCopy> ring(4);
+        ThrowingCopy::copiesLeft = 100;
+        std::vector<ThrowingCopy> items;
+        for (int i = 0; i < 4; ++i) {
+            items.emplace_back(i);
+        }
+        // move the indexes to the middle so the next batch is split over the end of the array
+        EXPECT_TRUE(ring.try_push(items[0]));
+        EXPECT_TRUE(ring.try_push(items[0]));
+        std::vector<ThrowingCopy> popped(2, ThrowingCopy(0));
+        EXPECT_EQ(ring.pop_n(popped.data(), 2), 2);
+        int before = ThrowingCopy::live;
+
+        // the first run (2 slots) is copied, the throw comes in the second
+        ThrowingCopy::copiesLeft = 3;
+        EXPECT_THROW(ring.push_n(items.data(), 4), std::runtime_error);
+        EXPECT_EQ(ThrowingCopy::live, before);
+        EXPECT_EQ(ring.size_approx(), 0);
+
+        ThrowingCopy::copiesLeft = 100;
+        EXPECT_EQ(ring.push_n(items.data(), 4), 4);
+        EXPECT_EQ(ring.pop_n(popped.data(), 2), 2);
+        EXPECT_EQ(popped[0].value, 0);
+        EXPECT_EQ(popped[1].value, 1);
+    }
+    EXPECT_EQ(ThrowingCopy::live, 0);
+}
+
+TEST(SpscCircularBufferTest, ProducerAndConsumerThreads) {
+    constexpr uint64_t kCount = 1 << 20;
+    SpscCircularBuffer<uint64_t> ring(256);
+
+    std::thread producer([&] {
+        uint64_t batch[37];
+        uint64_t next = 0;
+        while (next < kCount) {
+            if (next % 3 == 0) {
+                // single pushes some of the time, batches the rest
+                if (!ring.try_push(next)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                next++;
+            } else {
+                size_t n = std::min<uint64_t>(37, kCount - next);
+                for (size_t i = 0; i < n; ++i) {
+                    batch[i] = next + i;
+                }
+                size_t pushed = ring.push_n(batch, n);
+                if (pushed == 0) {
+                    std::this_thread::yield();
+                }
+                next += pushed;
+            }
+        }
+    });
+
+    uint64_t expected = 0;
+    uint64_t batch[64];
+    bool inOrder = true;
+    while (expected < kCount) {
+        size_t n = ring.pop_n(batch, expected % 2 == 0 ? 64 : 1);
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+        for (size_t i = 0; i < n; ++i) {
+            inOrder &= batch[i] == expected++;
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(inOrder);
+    EXPECT_TRUE(ring.empty_approx());
+}
@@ -3,18 +3,86 @@
 #include <algorithm>
 #include <concepts>
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <initializer_list>
 #include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <ranges>
+#include <ratio>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
+#include "VectorSimd.hpp"
+
+// A type is trivially relocatable if moving it to a new address and then destroying the old one is the same as
+// just copying its bytes over (and never running the destructor on the old bytes).
+// Every trivially copyable type is, but so are most types that own memory through a pointer
+// (std::unique_ptr, most std::string / std::vector implementations, this Vector) since nothing points back
+// at their own address. The compiler cant know that, so specialise this for your own types:
+//   template <> struct is_trivially_relocatable<MyHandle> : std::true_type {};
+// Vector relocates these with realloc / memcpy / memmove instead of a move + destroy per element.
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+namespace vector_detail {
+
+// raw, uninitialised room for N T's inside the Vector object itself
+template <typename T, size_t N>
+struct InlineBuffer {
+    alignas(T) unsigned char bytes[N * sizeof(T)];
+
+    T* data() {
+        return reinterpret_cast<T*>(bytes);
+    }
+
+    const T* data() const {
+        return reinterpret_cast<const T*>(bytes);
+    }
+};
 
+// takes no space at all (with [[no_unique_address]]), so a plain Vector stays 3 words
 template <typename T>
+struct InlineBuffer<T, 0> {
+    T* data() const {
+        return nullptr;
+    }
+};
+
+} // namespace vector_detail
+
+// GrowthFactor is a std::ratio, how much the capacity is multiplied by when a push_back runs out of room.
+// 2 (default) means fewer reallocations, 3/2 wastes less memory and lets the allocator reuse freed blocks
+// (with 2x the new block is always bigger than all the previous ones put together)
+//   Vector<int, std::ratio<3, 2>> v;
+//
+// InlineCapacity > 0 makes it a small vector (use the SmallVector alias below): the first InlineCapacity
+// elements live inside the Vector object itself and the heap is only touched once it outgrows that.
+//
+// Pass a std::pmr::memory_resource (eg a MonotonicArena, allocators/arena) to the constructor and the buffer
+// comes from it instead of malloc / ::operator new. Like the std::pmr containers the resource stays with the
+// object: moves take it along, copies and assignment targets keep their own.
+template <typename T, typename GrowthFactor = std::ratio<2>, size_t InlineCapacity = 0>
 
 class Vector {
 private:
+    static_assert(GrowthFactor::num > GrowthFactor::den, "Vector: GrowthFactor has to be bigger than 1");
+
+    // can be moved around with realloc, over aligned types need aligned allocations which realloc cant keep
+    static constexpr bool kRelocatable = is_trivially_relocatable_v<T> && alignof(T) <= alignof(std::max_align_t);
+
     T* ptr;
     size_t m_capacity;
     size_t idx; // this is the "current size"
+    // nullptr -> malloc / ::operator new
+    std::pmr::memory_resource* m_resource = nullptr;
+    // ptr points in here while the elements still fit
+    [[no_unique_address]] vector_detail::InlineBuffer<T, InlineCapacity> m_inline;
 
 public:
 
@@ -24,23 +92,29 @@ public:
 
     // ptr is the starting address of the allocated memory block for this vector
 
-    Vector(): ptr(nullptr), m_capacity(0), idx(0) {}
+    // with an inline buffer ptr starts out pointing at it (for a plain Vector thats nullptr, capacity 0)
+
+    // (set in the body, m_inline is declared after ptr so it doesnt exist yet in the init list)
+    Vector(): m_capacity(InlineCapacity), idx(0) {
+        ptr = m_inline.data();
+    }
+
+    // buffer comes from resource (nullptr is the normal heap)
+
+    explicit Vector(std::pmr::memory_resource* resource): Vector() {
+        m_resource = resource;
+    }
 
     // Normal constructor
 
-    Vector(size_t size, const T& element): ptr(nullptr), m_capacity(0), idx(0) {
-        resize(size);
-        for (size_t i = 0; i < size; i++) {
-            // allocating the memory at this location with a new element 
-            // T(element) uses the copy constructor
-            new (&ptr[idx++]) T(element);
-        }
+    Vector(size_t size, const T& element): Vector() {
+        assign(size, element);
     }
 
     // initialiser list constructor
 
-    Vector(std::initializer_list<T> lst): ptr(nullptr), m_capacity(0), idx(0) {
-        resize(lst.size());
+    Vector(std::initializer_list<T> lst): Vector() {
+        reserve(lst.size());
         for (const auto& i: lst) {
             // & operator gets the address of the element at x basically
             new (&ptr[idx++]) T(i);
@@ -49,19 +123,43 @@ public:
 
     // copy constructor
 
-    Vector(const Vector& vec): ptr(nullptr), m_capacity(0), idx(0) {
-        resize(vec.m_capacity);
-        for (size_t i = 0; i < vec.idx; i++) {
-            new (&ptr[idx++]) T(vec.ptr[i]);
+    Vector(const Vector& vec): Vector(vec, nullptr) {}
+
+    // copy that allocates from resource
+    Vector(const Vector& vec, std::pmr::memory_resource* resource): Vector(resource) {
+        reserve(vec.m_capacity);
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (vec.idx > 0) {
+                std::memcpy(static_cast<void*>(ptr), vec.ptr, vec.idx * sizeof(T));
+            }
+            idx = vec.idx;
+        } else {
+            for (size_t i = 0; i < vec.idx; i++) {
+                new (&ptr[idx++]) T(vec.ptr[i]);
+            }
         }
     }
 
     // move constructor
 
-        Vector(Vector&& vec): ptr(vec.ptr), m_capacity(vec.m_capacity), idx(vec.idx) {
-        vec.ptr = nullptr;
-        vec.m_capacity = 0;
-        vec.idx = 0;        
+    // a heap buffer just changes owner, inline elements cant (they live inside vec) so those get moved one by one
+    // either way vec is left empty
+
+    Vector(Vector&& vec): Vector(vec.m_resource) {
+        if (vec.isInline()) {
+            relocateFrom(vec);
+        } else {
+            ptr = std::exchange(vec.ptr, vec.m_inline.data());
+            m_capacity = std::exchange(vec.m_capacity, InlineCapacity);
+            idx = std::exchange(vec.idx, 0);
+        }
+    }
+
+    ~Vector() {
+        clear();
+        if (!isInline()) {
+            deallocate(ptr, m_capacity);
+        }
     }
 
     // copy assignment
@@ -71,7 +169,7 @@ public:
     // if anything goes wrong during copying, vec remains unchanged cause ure copying
 
     Vector& operator=(const Vector& vec) {
-        Vector v{vec};
+        Vector v(vec, m_resource);
         swap(v);
         return *this;
     }
@@ -79,15 +177,28 @@ public:
     // move assignment
 
     Vector& operator=(Vector&& vec) {
-        // cast into an r value
-        Vector v{std::move(vec)};
-        swap(v);
+        if (this == &vec) {
+            return *this;
+        }
+        clear();
+        if (vec.isInline() || vec.m_resource != m_resource) {
+            // our own buffer (inline or heap) is kept, vec's elements get moved into it
+            // (a buffer from a different resource cant be taken over, we would free it into the wrong one)
+            relocateFrom(vec);
+        } else {
+            if (!isInline()) {
+                deallocate(ptr, m_capacity);
+            }
+            ptr = std::exchange(vec.ptr, vec.m_inline.data());
+            m_capacity = std::exchange(vec.m_capacity, InlineCapacity);
+            idx = std::exchange(vec.idx, 0);
+        }
         return *this;
     }
 
     void push_back(const T& val) {
         if (idx == m_capacity) {
-            resize(m_capacity == 0 ? 1 : m_capacity * 2);
+            reserve(nextCapacity(idx + 1));
         }
         new (&ptr[idx++]) T(val);
     }
@@ -118,7 +229,7 @@ public:
     requires std::constructible_from<T, U...>
     T& emplace_back(U&&... args) {
         if (idx == m_capacity) {
-            resize(m_capacity == 0 ? 1 : m_capacity * 2);
+            reserve(nextCapacity(idx + 1));
         }
         new (&ptr[idx++]) T(std::forward<U>(args)...);
         return ptr[idx - 1];
@@ -132,14 +243,10 @@ public:
 
     // 1) grow if needed
         if (idx == m_capacity) 
-            resize(m_capacity == 0 ? 1 : m_capacity * 2);
+            reserve(nextCapacity(idx + 1));
 
     // 2) shift existing elements [pos..idx-1] → [pos+1..idx]
-        for (size_t i = idx; i > pos; --i) {
-            // backwards!!!
-            new (&ptr[i]) T(std::move(ptr[i - 1]));
-            ptr[i - 1].~T();
-        }
+        shiftTail(pos, 1);
 
     // 3) in‐place construct the new T at position pos
         new (&ptr[pos]) T(std::forward<U>(args)...);
@@ -151,77 +258,131 @@ public:
 
     // insert an initializer_list of T’s at position pos
     void insert(size_t pos, std::initializer_list<T> il) {
-        if (pos > idx)
-        throw std::out_of_range("Vector::insert: position out of range");
-
-        size_t count = il.size();
-        if (count == 0) return;
+        insert_range(pos, il.begin(), il.end());
+    }
 
-        // 1) grow once for all `count` new elements
-        if (idx + count > m_capacity) {
-        // double-or-enough strategy
-            size_t newCap = std::max(m_capacity ? m_capacity * 2 : 1, idx + count);
-            resize(newCap);
+    // inserts [first, last) at pos
+    // with forward iterators the count is known up front, so it grows at most once, shifts the old tail once
+    // (a single memmove for trivially relocatable T) and copies the new elements straight into the gap
+    // (a single memcpy if they are contiguous trivially copyable T's)
+    template <std::input_iterator It, std::sentinel_for<It> Sentinel>
+    void insert_range(size_t pos, It first, Sentinel last) {
+        if (pos > idx) {
+            throw std::out_of_range("Vector::insert_range: position out of range");
         }
-
-        // 2) shift old tail [pos..idx-1] → [pos+count..idx+count-1]
-        for (size_t i = idx; i > pos; --i) {
-            new (&ptr[i + count - 1]) T(std::move(ptr[i - 1]));
-            ptr[i - 1].~T();
+        if constexpr (std::forward_iterator<It>) {
+            size_t count = static_cast<size_t>(std::ranges::distance(first, last));
+            openGap(pos, count);
+            constructFrom(ptr + pos, first, count);
+            idx += count;
+        } else {
+            // single pass iterators cant be counted without consuming them, so buffer them first
+            Vector buffer;
+            for (; first != last; ++first) {
+                buffer.emplace_back(*first);
+            }
+            openGap(pos, buffer.idx);
+            for (size_t i = 0; i < buffer.idx; i++) {
+                new (&ptr[pos + i]) T(std::move(buffer.ptr[i]));
+            }
+            idx += buffer.idx;
         }
+    }
 
-        // 3) copy-construct the new elements from the list
-        size_t i = 0;
-        for (auto& x : il) {
-            new (&ptr[pos + i]) T(x);
-            ++i;
+    // adds the range's elements at the end, pass an rvalue container to move them in instead of copying.
+    // Only a range that owns its elements gets moved from: an rvalue view (src | views::take(2)) or a borrowed
+    // range (span) still refers to elements someone else owns, those are copied / built from *it
+    template <std::ranges::input_range R>
+    void append(R&& range) {
+        constexpr bool kOwnsElements = !std::is_lvalue_reference_v<R> && !std::ranges::view<std::remove_cvref_t<R>>
+                                    && !std::ranges::borrowed_range<R>;
+        if constexpr (std::ranges::forward_range<R>) {
+            size_t count = static_cast<size_t>(std::ranges::distance(range));
+            if (idx + count > m_capacity) {
+                reserve(nextCapacity(idx + count));
+            }
+            if constexpr (!kOwnsElements || std::is_trivially_copyable_v<T>) {
+                // T(*it), so views whose elements are prvalues (views::transform) work too
+                constructFrom(ptr + idx, std::ranges::begin(range), count);
+            } else {
+                size_t i = idx;
+                for (auto&& x: range) {
+                    new (&ptr[i++]) T(std::move(x));
+                }
+            }
+            idx += count;
+        } else {
+            for (auto&& x: range) {
+                emplace_back(std::forward<decltype(x)>(x));
+            }
         }
+    }
 
-        // 4) update size
-        idx += count;
+    // replaces the contents with count copies of value
+    // std::uninitialized_fill_n turns into memset / a vectorised store loop for trivial T
+    void assign(size_t count, const T& value) {
+        // value could be one of our own elements, which clear is about to destroy
+        T copy(value);
+        clear();
+        reserve(count);
+        std::uninitialized_fill_n(ptr, count, copy);
+        idx = count;
     }
 
+    // Destroys the elements past count (if there are that many) and makes sure the capacity is at least count.
+    // Unlike std::vector::resize it never constructs new elements, size only ever goes down.
     void resize(size_t count) {
-        if (count == m_capacity) {
-            return;
-        }
-
-        if (m_capacity > count) {
-        // Destroy elements beyond the new size if they exist
         for (size_t i = count; i < idx; i++) {
             ptr[i].~T();
         }
         idx = std::min(count, idx);
-        return;
-        }
-
-
-        // ::operator new basically allocates a block of raw memory without invoking any
-        // constructors
-
-        // the return type of ::operator new is void,
-        // reinterpret cast casts it into T, and tells compiler to treat it 
-        // as if it were of type T
-
-        T* newPtr = reinterpret_cast<T*>(::operator new(sizeof(T) * count));
+        reserve(count);
+    }
 
-        // moving is more efficient than copying
-        // standard practice to use std::move when the source object does not matter anywhere
-        // signals u dont need a deep copy, compiler can optimise
-        for (size_t i = 0; i < idx; i++) {
-            new (&newPtr[i]) T(std::move(ptr[i]));
+    // Makes room for count elements without touching the size, never shrinks.
+    // Every element gets relocated into the new buffer:
+    //   trivially relocatable T -> realloc. For big buffers glibc's realloc is mremap, the pages get remapped to
+    //                              a new address without copying a single byte, and often the block can just
+    //                              grow in place
+    //   anything else           -> allocate, move construct each element over, destroy the old ones
+    void reserve(size_t count) {
+        if (count <= m_capacity) {
+            return;
         }
-
-        //Call destructors for old memory
-        for (size_t i = 0; i < idx; i++) {
-            ptr[i].~T();
+        if (isInline() || m_resource) {
+            // spilling out of the inline buffer, or the buffer belongs to a memory resource, theres nothing to realloc
+            T* newPtr = allocate(count);
+            relocate(newPtr, ptr, idx);
+            if (!isInline()) {
+                deallocate(ptr, m_capacity);
+            }
+            ptr = newPtr;
+        } else if constexpr (kRelocatable) {
+            void* newPtr = std::realloc(static_cast<void*>(ptr), sizeof(T) * count);
+            if (!newPtr) {
+                throw std::bad_alloc();
+            }
+            ptr = static_cast<T*>(newPtr);
+        } else {
+            T* newPtr = allocate(count);
+
+            // moving is more efficient than copying
+            // standard practice to use std::move when the source object does not matter anywhere
+            // signals u dont need a deep copy, compiler can optimise
+            for (size_t i = 0; i < idx; i++) {
+                new (&newPtr[i]) T(std::move(ptr[i]));
+            }
+
+            //Call destructors for old memory
+            for (size_t i = 0; i < idx; i++) {
+                ptr[i].~T();
+            }
+
+            // destroying the T objects above just freed up space for "this" array
+            // now we are destroying "this" array
+            deallocate(ptr, m_capacity);
+            ptr = newPtr;
         }
-        
-        // free this vector from memory
-        // destroying the T objects above just freed up space for "this" array
-        // now we are destroying "this" array
-        ::operator delete(ptr);
-        ptr = newPtr;
         m_capacity = count;
     }
 
@@ -235,6 +396,63 @@ public:
     T* data() {
         return ptr;
     }
+
+    const T* data() const {
+        return ptr;
+    }
+
+    // Bulk queries. For arithmetic T these run on SIMD kernels picked at runtime for the cpu
+    // (SSE2 / AVX2 / AVX-512, see VectorSimd.hpp), for anything else they are the std algorithms.
+
+    // index of the first element equal to value, or size() if there isnt one
+    size_t find(const T& value) const {
+        if constexpr (vector_simd::SimdElement<T>) {
+            return vector_simd::find(ptr, idx, value);
+        } else {
+            return static_cast<size_t>(std::find(ptr, ptr + idx, value) - ptr);
+        }
+    }
+
+    size_t count(const T& value) const {
+        if constexpr (vector_simd::SimdElement<T>) {
+            return vector_simd::count(ptr, idx, value);
+        } else {
+            return static_cast<size_t>(std::count(ptr, ptr + idx, value));
+        }
+    }
+
+    // smallest / largest element, throws std::out_of_range on an empty vector
+    T min() const {
+        if (idx == 0) {
+            throw std::out_of_range("Vector::min: empty vector");
+        }
+        if constexpr (vector_simd::SimdElement<T>) {
+            return vector_simd::minMax<T, true>(ptr, idx);
+        } else {
+            return *std::min_element(ptr, ptr + idx);
+        }
+    }
+
+    T max() const {
+        if (idx == 0) {
+            throw std::out_of_range("Vector::max: empty vector");
+        }
+        if constexpr (vector_simd::SimdElement<T>) {
+            return vector_simd::minMax<T, false>(ptr, idx);
+        } else {
+            return *std::max_element(ptr, ptr + idx);
+        }
+    }
+
+    // replaces every element x with f(x) in place. No hand written SIMD here, f is arbitrary, but its a plain
+    // loop over contiguous memory so with an inlinable f the compiler vectorises it
+    template <typename F>
+    requires std::convertible_to<std::invoke_result_t<F&, T&>, T>
+    void transform(F f) {
+        for (size_t i = 0; i < idx; i++) {
+            ptr[i] = f(ptr[i]);
+        }
+    }
     T& at(size_t pos) {
         return ptr[pos];
     }
@@ -249,9 +467,145 @@ public:
     }
     
     void swap(Vector& vec) {
+        if (isInline() || vec.isInline() || m_resource != vec.m_resource) {
+            // an inline buffer (or one from another resource) cant be handed over, go through moves instead
+            Vector tmp(std::move(vec));
+            vec = std::move(*this);
+            *this = std::move(tmp);
+            return;
+        }
         std::swap(ptr, vec.ptr);
         std::swap(m_capacity, vec.m_capacity);
         std::swap(idx, vec.idx);
     }
 
+    // where the buffer comes from, nullptr is the normal heap
+    std::pmr::memory_resource* resource() const {
+        return m_resource;
+    }
+
+    // true while the elements are still in the inline buffer (always false for a plain Vector)
+    bool is_inline() const {
+        return isInline();
+    }
+
+private:
+    bool isInline() const {
+        if constexpr (InlineCapacity > 0) {
+            return ptr == m_inline.data();
+        } else {
+            return false;
+        }
+    }
+
+    // move constructs count elements from src into raw memory at dest and destroys the originals
+    static void relocate(T* dest, T* src, size_t count) {
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if (count > 0) {
+                std::memcpy(static_cast<void*>(dest), src, count * sizeof(T));
+            }
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                new (&dest[i]) T(std::move(src[i]));
+                src[i].~T();
+            }
+        }
+    }
+
+    // takes over the elements of vec (which has to be inline) into our buffer, we have to be empty
+    void relocateFrom(Vector& vec) {
+        reserve(vec.idx);
+        relocate(ptr, vec.ptr, vec.idx);
+        idx = std::exchange(vec.idx, 0);
+    }
+
+    // capacity after growing to fit at least needed elements: m_capacity * GrowthFactor, or needed if thats more
+    size_t nextCapacity(size_t needed) const {
+        size_t grown = m_capacity * GrowthFactor::num / GrowthFactor::den;
+        return std::max({grown, needed, size_t{1}});
+    }
+
+    // with a resource the buffer comes from it, otherwise
+    // relocatable buffers come from malloc so reserve can realloc them,
+    // everything else from ::operator new (aligned if T needs it)
+    T* allocate(size_t count) {
+        if (m_resource) {
+            return static_cast<T*>(m_resource->allocate(sizeof(T) * count, alignof(T)));
+        }
+        if constexpr (kRelocatable) {
+            void* p = std::malloc(sizeof(T) * count);
+            if (!p) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(p);
+        } else if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return static_cast<T*>(::operator new(sizeof(T) * count, std::align_val_t{alignof(T)}));
+        } else {
+            // ::operator new basically allocates a block of raw memory without invoking any
+            // constructors
+            return static_cast<T*>(::operator new(sizeof(T) * count));
+        }
+    }
+
+    void deallocate(T* p, size_t count) {
+        if (m_resource) {
+            if (p) {
+                m_resource->deallocate(p, sizeof(T) * count, alignof(T));
+            }
+            return;
+        }
+        if constexpr (kRelocatable) {
+            std::free(p);
+        } else if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ::operator delete(p, std::align_val_t{alignof(T)});
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    // copy (or move, for move iterators) constructs count elements starting at first into raw memory at dest
+    template <typename It>
+    static void constructFrom(T* dest, It first, size_t count) {
+        if constexpr (std::contiguous_iterator<It> && std::is_trivially_copyable_v<T>
+                      && std::is_same_v<std::iter_value_t<It>, T>) {
+            std::memcpy(static_cast<void*>(dest), std::to_address(first), count * sizeof(T));
+        } else {
+            for (size_t i = 0; i < count; i++, ++first) {
+                new (&dest[i]) T(*first);
+            }
+        }
+    }
+
+    // makes room for count more elements and then shifts [pos, idx) out of the way
+    void openGap(size_t pos, size_t count) {
+        if (count == 0) {
+            return;
+        }
+        if (idx + count > m_capacity) {
+            reserve(nextCapacity(idx + count));
+        }
+        shiftTail(pos, count);
+    }
+
+    // opens a gap of count slots at pos by moving [pos, idx) up by count, capacity has to be there already
+    // the slots in the gap are left as raw memory
+    void shiftTail(size_t pos, size_t count) {
+        if constexpr (is_trivially_relocatable_v<T>) {
+            std::memmove(static_cast<void*>(ptr + pos + count), ptr + pos, (idx - pos) * sizeof(T));
+        } else {
+            for (size_t i = idx; i > pos; --i) {
+                // backwards!!!
+                new (&ptr[i + count - 1]) T(std::move(ptr[i - 1]));
+                ptr[i - 1].~T();
+            }
+        }
+    }
+
 };
+
+// Vector that keeps its first N elements inside the object, no heap allocation at all until it holds more than N.
+// Same API as Vector. Worth it for the many short lived vectors that almost always stay tiny, at the price of
+// a bigger object (N * sizeof(T) extra) and moves that copy the elements while they are inline.
+//   SmallVector<int, 8> v;   // 8 push_backs, 0 mallocs
+template <typename T, size_t N, typename GrowthFactor = std::ratio<2>>
+using SmallVector = Vector<T, GrowthFactor, N>;
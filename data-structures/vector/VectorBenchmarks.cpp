@@ -0,0 +1,827 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <ratio>
+#include <thread>
+#include <vector>
+#include "CircularBuffer.hpp"
+#include "MagicRingBuffer.hpp"
+#include "SegmentedVector.hpp"
+#include "SoAVector.hpp"
+#include "SpscCircularBuffer.hpp"
+#include "Vector.hpp"
+#include "VectorParallel.hpp"
+
+// Google Benchmark, link with -lbenchmark -lbenchmark_main -pthread
+// Counts every malloc / calloc / realloc in the process (operator new ends up in malloc too), so the SmallVector
+// numbers show how many trips to the heap each version makes. Not operator new like PoolAllocatorBenchmarks,
+// Vector grows trivially relocatable elements with realloc. free isnt counted, it doesnt allocate.
+// Atomic because the parallel and SPSC benchmarks allocate from several threads at once, relaxed since its
+// only a tally read after the threads are joined
+
+namespace {
+std::atomic<size_t> gHeapAllocations{0};
+}
+
+// glibc's own entry points, our malloc / calloc / realloc below replace the public ones for the whole binary
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* p, size_t size);
+
+extern "C" void* malloc(size_t size) {
+    gHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    gHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* p, size_t size) {
+    gHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+
+namespace {
+
+struct Pod {
+    uint64_t a;
+    uint64_t b;
+};
+
+// same layout, but opted out of the relocation fast path so growing takes the move + destroy loop
+struct SlowPod {
+    uint64_t a;
+    uint64_t b;
+};
+
+} // namespace
+
+template <>
+struct is_trivially_relocatable<SlowPod> : std::false_type {};
+
+// ---- push_back growth: realloc fast path vs per element relocation vs std::vector ----
+
+template <typename Vec>
+static void BM_PushBack(benchmark::State& state) {
+    const size_t n = state.range(0);
+    for (auto _: state) {
+        Vec vec;
+        for (size_t i = 0; i < n; i++) {
+            vec.push_back({i, i});
+        }
+        benchmark::DoNotOptimize(vec.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(BM_PushBack, Vector<Pod>)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PushBack, Vector<SlowPod>)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PushBack, Vector<Pod, std::ratio<3, 2>>)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PushBack, std::vector<Pod>)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+
+// push_back into a reserved Vector, never relocates
+static void BM_PushBackReserved(benchmark::State& state) {
+    const size_t n = state.range(0);
+    for (auto _: state) {
+        Vector<Pod> vec;
+        vec.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            vec.push_back({i, i});
+        }
+        benchmark::DoNotOptimize(vec.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(BM_PushBackReserved)->Arg(1 << 16)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+
+// ---- bulk operations vs std::vector ----
+// Vector's find / count / min / max dispatch to AVX-512 / AVX2 / SSE2 at runtime, std::vector goes through
+// the std algorithms, built at plain -O2 (so SSE2 at most, and gcc doesnt vectorise std::find at all)
+
+namespace {
+
+template <typename T>
+std::vector<T> bulkValues(size_t n) {
+    std::vector<T> values(n);
+    for (size_t i = 0; i < n; i++) {
+        values[i] = static_cast<T>(i % 100);
+    }
+    return values;
+}
+
+template <typename T>
+Vector<T> bulkVector(size_t n) {
+    Vector<T> vec;
+    vec.append(bulkValues<T>(n));
+    return vec;
+}
+
+} // namespace
+
+template <typename T>
+static void BM_FindVector(benchmark::State& state) {
+    auto vec = bulkVector<T>(state.range(0));
+    for (auto _: state) {
+        // never there, so every element gets looked at
+        benchmark::DoNotOptimize(vec.find(T(101)));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+}
+
+template <typename T>
+static void BM_FindStd(benchmark::State& state) {
+    auto vec = bulkValues<T>(state.range(0));
+    for (auto _: state) {
+        benchmark::DoNotOptimize(std::find(vec.begin(), vec.end(), T(101)));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+}
+
+template <typename T>
+static void BM_CountVector(benchmark::State& state) {
+    auto vec = bulkVector<T>(state.range(0));
+    for (auto _: state) {
+        benchmark::DoNotOptimize(vec.count(T(42)));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+}
+
+template <typename T>
+static void BM_CountStd(benchmark::State& state) {
+    auto vec = bulkValues<T>(state.range(0));
+    for (auto _: state) {
+        benchmark::DoNotOptimize(std::count(vec.begin(), vec.end(), T(42)));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+}
+
+template <typename T>
+static void BM_MinVector(benchmark::State& state) {
+    auto vec = bulkVector<T>(state.range(0));
+    for (auto _: state) {
+        benchmark::DoNotOptimize(vec.min());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+}
+
+template <typename T>
+static void BM_MinStd(benchmark::State& state) {
+    auto vec = bulkValues<T>(state.range(0));
+    for (auto _: state) {
+        benchmark::DoNotOptimize(*std::min_element(vec.begin(), vec.end()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(T));
+}
+
+// 16K elements stays in L1 / L2, 4M is memory bound
+#define BULK_BENCH(fn) \
+    BENCHMARK_TEMPLATE(fn, uint8_t)->Arg(1 << 14)->Arg(1 << 22); \
+    BENCHMARK_TEMPLATE(fn, int32_t)->Arg(1 << 14)->Arg(1 << 22); \
+    BENCHMARK_TEMPLATE(fn, double)->Arg(1 << 14)->Arg(1 << 22)
+
+BULK_BENCH(BM_FindVector);
+BULK_BENCH(BM_FindStd);
+BULK_BENCH(BM_CountVector);
+BULK_BENCH(BM_CountStd);
+BULK_BENCH(BM_MinVector);
+BULK_BENCH(BM_MinStd);
+
+// assign / insert_range vs the element by element versions
+static void BM_AssignVector(benchmark::State& state) {
+    Vector<int32_t> vec;
+    for (auto _: state) {
+        vec.assign(state.range(0), 7);
+        benchmark::DoNotOptimize(vec.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_AssignStd(benchmark::State& state) {
+    std::vector<int32_t> vec;
+    for (auto _: state) {
+        vec.assign(state.range(0), 7);
+        benchmark::DoNotOptimize(vec.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_InsertRangeFrontVector(benchmark::State& state) {
+    auto values = bulkValues<int32_t>(64);
+    for (auto _: state) {
+        Vector<int32_t> vec;
+        vec.reserve(state.range(0) + 64);
+        vec.append(bulkValues<int32_t>(state.range(0)));
+        vec.insert_range(0, values.begin(), values.end());
+        benchmark::DoNotOptimize(vec.data());
+    }
+}
+
+static void BM_InsertRangeFrontStd(benchmark::State& state) {
+    auto values = bulkValues<int32_t>(64);
+    for (auto _: state) {
+        std::vector<int32_t> vec;
+        vec.reserve(state.range(0) + 64);
+        auto more = bulkValues<int32_t>(state.range(0));
+        vec.insert(vec.end(), more.begin(), more.end());
+        vec.insert(vec.begin(), values.begin(), values.end());
+        benchmark::DoNotOptimize(vec.data());
+    }
+}
+
+BENCHMARK(BM_AssignVector)->Arg(1 << 20);
+BENCHMARK(BM_AssignStd)->Arg(1 << 20);
+BENCHMARK(BM_InsertRangeFrontVector)->Arg(1 << 20);
+BENCHMARK(BM_InsertRangeFrontStd)->Arg(1 << 20);
+
+// ---- SmallVector vs Vector vs std::vector for the typical handful of elements ----
+
+template <typename Vec>
+static void BM_SmallPushBack(benchmark::State& state) {
+    const size_t n = state.range(0);
+    size_t allocations = 0;
+    for (auto _: state) {
+        size_t before = gHeapAllocations.load(std::memory_order_relaxed);
+        Vec vec;
+        for (size_t i = 0; i < n; i++) {
+            vec.push_back(static_cast<int>(i));
+        }
+        benchmark::DoNotOptimize(vec.data());
+        allocations += gHeapAllocations.load(std::memory_order_relaxed) - before;
+    }
+    state.counters["heap_allocs_per_iter"] = static_cast<double>(allocations) / state.iterations();
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(BM_SmallPushBack, SmallVector<int, 8>)->Arg(1)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK_TEMPLATE(BM_SmallPushBack, Vector<int>)->Arg(1)->Arg(4)->Arg(8)->Arg(16);
+BENCHMARK_TEMPLATE(BM_SmallPushBack, std::vector<int>)->Arg(1)->Arg(4)->Arg(8)->Arg(16);
+
+// ---- partial field scans: Vector of structs vs SoAVector ----
+// sum(price * qty) over rows with flags & 1, touching 3 of the record's fields (16 of its 64 bytes)
+
+namespace {
+
+struct Record {
+    uint64_t id;
+    double price;
+    uint32_t qty;
+    uint32_t flags;
+    char note[40];
+};
+
+using RecordColumns = SoAVector<uint64_t, double, uint32_t, uint32_t, std::array<char, 40>>;
+
+} // namespace
+
+static void BM_ScanAoS(benchmark::State& state) {
+    Vector<Record> records;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        records.push_back(Record{static_cast<uint64_t>(i), i * 0.25, static_cast<uint32_t>(i % 10),
+                                 static_cast<uint32_t>(i % 3), {}});
+    }
+    for (auto _: state) {
+        double total = 0;
+        const Record* rows = records.data();
+        for (size_t i = 0; i < records.size(); i++) {
+            total += (rows[i].flags & 1) ? rows[i].price * rows[i].qty : 0.0;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_ScanSoA(benchmark::State& state) {
+    RecordColumns records;
+    records.reserve(state.range(0));
+    for (int64_t i = 0; i < state.range(0); i++) {
+        records.emplace_back(static_cast<uint64_t>(i), i * 0.25, static_cast<uint32_t>(i % 10),
+                             static_cast<uint32_t>(i % 3), std::array<char, 40>{});
+    }
+    for (auto _: state) {
+        double total = 0;
+        auto price = records.column<1>();
+        auto qty = records.column<2>();
+        auto flags = records.column<3>();
+        for (size_t i = 0; i < price.size(); i++) {
+            total += (flags[i] & 1) ? price[i] * qty[i] : 0.0;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// through the row proxies instead of the columns, same memory traffic as the column loop
+static void BM_ScanSoARows(benchmark::State& state) {
+    RecordColumns records;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        records.emplace_back(static_cast<uint64_t>(i), i * 0.25, static_cast<uint32_t>(i % 10),
+                             static_cast<uint32_t>(i % 3), std::array<char, 40>{});
+    }
+    for (auto _: state) {
+        double total = 0;
+        for (const auto& [id, price, qty, flags, note]: records) {
+            total += (flags & 1) ? price * qty : 0.0;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// 16K rows (1MB of records) sits in L2, 4M rows is memory bound
+BENCHMARK(BM_ScanAoS)->Arg(1 << 14)->Arg(1 << 22);
+BENCHMARK(BM_ScanSoA)->Arg(1 << 14)->Arg(1 << 22);
+BENCHMARK(BM_ScanSoARows)->Arg(1 << 14)->Arg(1 << 22);
+
+// ---- parallel algorithms, scaling with the number of threads ----
+// the argument is the total thread count (pool workers + the calling thread), 1 is the sequential fallback.
+// UseRealTime, the cpu time of the calling thread alone says nothing once other threads do the work
+
+namespace {
+
+Vector<uint32_t> shuffledValues(size_t n) {
+    Vector<uint32_t> vec;
+    vec.reserve(n);
+    uint32_t x = 12345;
+    for (size_t i = 0; i < n; i++) {
+        // xorshift, cheap and good enough to make std::sort work for it
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        vec.push_back(x);
+    }
+    return vec;
+}
+
+constexpr size_t kParallelSize = 1 << 23;
+
+} // namespace
+
+static void BM_ParallelSort(benchmark::State& state) {
+    ThreadPool pool(state.range(0) - 1);
+    auto original = shuffledValues(kParallelSize);
+    for (auto _: state) {
+        state.PauseTiming();
+        Vector<uint32_t> vec(original);
+        state.ResumeTiming();
+        parallel::sort(vec, std::less<>{}, pool);
+        benchmark::DoNotOptimize(vec.data());
+    }
+    state.SetItemsProcessed(state.iterations() * kParallelSize);
+}
+
+static void BM_ParallelReduce(benchmark::State& state) {
+    ThreadPool pool(state.range(0) - 1);
+    auto vec = shuffledValues(kParallelSize);
+    for (auto _: state) {
+        benchmark::DoNotOptimize(parallel::reduce(vec, uint64_t{0}, std::plus<>{}, pool));
+    }
+    state.SetItemsProcessed(state.iterations() * kParallelSize);
+}
+
+static void BM_ParallelTransform(benchmark::State& state) {
+    ThreadPool pool(state.range(0) - 1);
+    auto vec = shuffledValues(kParallelSize);
+    for (auto _: state) {
+        parallel::transform(vec, [](uint32_t x) { return x * 2654435761u + 1; }, pool);
+        benchmark::DoNotOptimize(vec.data());
+    }
+    state.SetItemsProcessed(state.iterations() * kParallelSize);
+}
+
+static void BM_ParallelPartition(benchmark::State& state) {
+    ThreadPool pool(state.range(0) - 1);
+    auto original = shuffledValues(kParallelSize);
+    for (auto _: state) {
+        state.PauseTiming();
+        Vector<uint32_t> vec(original);
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(parallel::partition(vec, [](uint32_t x) { return x % 3 == 0; }, pool));
+    }
+    state.SetItemsProcessed(state.iterations() * kParallelSize);
+}
+
+#define THREAD_COUNTS ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond)
+
+BENCHMARK(BM_ParallelSort) THREAD_COUNTS;
+BENCHMARK(BM_ParallelReduce) THREAD_COUNTS;
+BENCHMARK(BM_ParallelTransform) THREAD_COUNTS;
+BENCHMARK(BM_ParallelPartition) THREAD_COUNTS;
+
+// ---- SegmentedVector vs Vector ----
+// appending never copies anything already in, reading pays one extra load (the chunk pointer) per element
+
+namespace {
+
+// 64 bytes and not relocatable, so every Vector growth is a move loop over all of it
+struct BigRecord {
+    uint64_t fields[8];
+};
+
+} // namespace
+
+template <>
+struct is_trivially_relocatable<BigRecord> : std::false_type {};
+
+template <typename Vec>
+static void BM_Append(benchmark::State& state) {
+    const size_t n = state.range(0);
+    for (auto _: state) {
+        Vec vec;
+        for (size_t i = 0; i < n; i++) {
+            vec.push_back(BigRecord{{i, i, i, i, i, i, i, i}});
+        }
+        benchmark::DoNotOptimize(&vec[n - 1]);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(BM_Append, Vector<BigRecord>)->Arg(1 << 12)->Arg(1 << 16)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Append, SegmentedVector<BigRecord>)->Arg(1 << 12)->Arg(1 << 16)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+
+template <typename Vec>
+static void BM_RandomRead(benchmark::State& state) {
+    const size_t n = state.range(0);
+    Vec vec;
+    for (size_t i = 0; i < n; i++) {
+        vec.push_back(i);
+    }
+    uint64_t x = 88172645463325252ull;
+    uint64_t sum = 0;
+    for (auto _: state) {
+        for (size_t i = 0; i < 4096; i++) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            sum += vec[x & (n - 1)];
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * 4096);
+}
+
+// fits in L1, in L2, and way past the caches
+BENCHMARK_TEMPLATE(BM_RandomRead, Vector<uint64_t>)->Arg(1 << 10)->Arg(1 << 15)->Arg(1 << 24);
+BENCHMARK_TEMPLATE(BM_RandomRead, SegmentedVector<uint64_t>)->Arg(1 << 10)->Arg(1 << 15)->Arg(1 << 24);
+
+// every thread appends its share, SegmentedVector::concurrent_push_back vs a Vector behind a mutex
+constexpr size_t kConcurrentAppends = 1 << 20;
+
+template <typename Append>
+static void appendFromThreads(size_t threads, Append append) {
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (size_t i = t; i < kConcurrentAppends; i += threads) {
+                append(i);
+            }
+        });
+    }
+    for (auto& worker: workers) {
+        worker.join();
+    }
+}
+
+static void BM_ConcurrentAppendSegmented(benchmark::State& state) {
+    for (auto _: state) {
+        SegmentedVector<uint64_t> vec;
+        vec.reserve(kConcurrentAppends);
+        appendFromThreads(state.range(0), [&](size_t i) { vec.concurrent_push_back(i); });
+        benchmark::DoNotOptimize(vec.size());
+    }
+    state.SetItemsProcessed(state.iterations() * kConcurrentAppends);
+}
+
+static void BM_ConcurrentAppendLockedVector(benchmark::State& state) {
+    for (auto _: state) {
+        Vector<uint64_t> vec;
+        vec.reserve(kConcurrentAppends);
+        std::mutex mtx;
+        appendFromThreads(state.range(0), [&](size_t i) {
+            std::lock_guard<std::mutex> lock(mtx);
+            vec.push_back(i);
+        });
+        benchmark::DoNotOptimize(vec.size());
+    }
+    state.SetItemsProcessed(state.iterations() * kConcurrentAppends);
+}
+
+BENCHMARK(BM_ConcurrentAppendSegmented) THREAD_COUNTS;
+BENCHMARK(BM_ConcurrentAppendLockedVector) THREAD_COUNTS;
+
+// ---- SpscCircularBuffer vs CircularBuffer behind a mutex, one producer thread and one consumer thread ----
+// messages per second through the pair. Both sides yield when full / empty, which is what lets them take
+// turns at all on a machine with fewer cores than threads
+
+constexpr uint64_t kMessages = 1 << 22;
+constexpr size_t kRingCapacity = 4096;
+
+static void BM_SpscSingle(benchmark::State& state) {
+    for (auto _: state) {
+        SpscCircularBuffer<uint64_t> ring(kRingCapacity);
+        std::thread producer([&] {
+            for (uint64_t i = 0; i < kMessages; i++) {
+                while (!ring.try_push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        uint64_t sum = 0;
+        uint64_t value;
+        for (uint64_t received = 0; received < kMessages; received++) {
+            while (!ring.try_pop(value)) {
+                std::this_thread::yield();
+            }
+            sum += value;
+        }
+        producer.join();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * kMessages);
+}
+
+static void BM_SpscBatch(benchmark::State& state) {
+    const size_t batchSize = state.range(0);
+    for (auto _: state) {
+        SpscCircularBuffer<uint64_t> ring(kRingCapacity);
+        std::thread producer([&] {
+            std::vector<uint64_t> batch(batchSize);
+            for (uint64_t next = 0; next < kMessages;) {
+                size_t n = std::min<uint64_t>(batchSize, kMessages - next);
+                for (size_t i = 0; i < n; i++) {
+                    batch[i] = next + i;
+                }
+                size_t pushed = ring.push_n(batch.data(), n);
+                if (pushed == 0) {
+                    std::this_thread::yield();
+                }
+                next += pushed;
+            }
+        });
+        std::vector<uint64_t> batch(batchSize);
+        uint64_t sum = 0;
+        for (uint64_t received = 0; received < kMessages;) {
+            size_t n = ring.pop_n(batch.data(), batchSize);
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < n; i++) {
+                sum += batch[i];
+            }
+            received += n;
+        }
+        producer.join();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * kMessages);
+}
+
+static void BM_MutexCircularBuffer(benchmark::State& state) {
+    for (auto _: state) {
+        CircularBuffer<uint64_t> ring(kRingCapacity);
+        std::mutex mtx;
+        std::thread producer([&] {
+            for (uint64_t i = 0; i < kMessages;) {
+                {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if (!ring.is_full()) {
+                        ring.push_back(i++);
+                        continue;
+                    }
+                }
+                std::this_thread::yield();
+            }
+        });
+        uint64_t sum = 0;
+        for (uint64_t received = 0; received < kMessages;) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (!ring.is_empty()) {
+                    sum += ring.get_front();
+                    ring.pop_front();
+                    received++;
+                    continue;
+                }
+            }
+            std::this_thread::yield();
+        }
+        producer.join();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * kMessages);
+}
+
+BENCHMARK(BM_SpscSingle)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SpscBatch)->Arg(16)->Arg(256)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MutexCircularBuffer)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// ---- CircularBuffer under backpressure, and bulk copies through the spans ----
+// a telemetry ring that is always full: catching push_back's exception vs Overwrite mode
+
+static void BM_FullRingThrowAndCatch(benchmark::State& state) {
+    CircularBuffer<uint64_t> ring(1024);
+    for (uint64_t i = 0; i < 1024; i++) {
+        ring.push_back(i);
+    }
+    uint64_t dropped = 0;
+    for (auto _: state) {
+        try {
+            ring.push_back(dropped);
+        } catch (const std::out_of_range&) {
+            dropped++;
+        }
+    }
+    benchmark::DoNotOptimize(dropped);
+}
+
+static void BM_FullRingOverwrite(benchmark::State& state) {
+    CircularBuffer<uint64_t> ring(1024, CircularBufferMode::Overwrite);
+    uint64_t i = 0;
+    for (auto _: state) {
+        ring.push_back(i++);
+    }
+    benchmark::DoNotOptimize(ring.overwritten());
+}
+
+BENCHMARK(BM_FullRingThrowAndCatch);
+BENCHMARK(BM_FullRingOverwrite);
+
+// moving 1KB chunks of a byte stream through a 64KB ring, one push_back / pop_front per byte vs memcpy
+// straight into writable_spans() and out of readable_spans()
+
+constexpr int kStreamRing = 1 << 16;
+constexpr size_t kStreamChunk = 1024;
+
+static void BM_StreamPerByte(benchmark::State& state) {
+    CircularBuffer<char> ring(kStreamRing);
+    std::vector<char> in(kStreamChunk, 'x');
+    std::vector<char> out(kStreamChunk);
+    for (auto _: state) {
+        for (char c: in) {
+            ring.push_back(c);
+        }
+        for (size_t i = 0; i < kStreamChunk; i++) {
+            out[i] = ring.get_front();
+            ring.pop_front();
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * kStreamChunk);
+}
+
+static void BM_StreamSpans(benchmark::State& state) {
+    CircularBuffer<char> ring(kStreamRing);
+    std::vector<char> in(kStreamChunk, 'x');
+    std::vector<char> out(kStreamChunk);
+    for (auto _: state) {
+        size_t copied = 0;
+        for (std::span<char> span: ring.writable_spans()) {
+            size_t n = std::min(span.size(), kStreamChunk - copied);
+            std::memcpy(span.data(), in.data() + copied, n);
+            copied += n;
+        }
+        ring.commit_write(static_cast<int>(copied));
+        copied = 0;
+        for (std::span<char> span: ring.readable_spans()) {
+            size_t n = std::min(span.size(), kStreamChunk - copied);
+            std::memcpy(out.data() + copied, span.data(), n);
+            copied += n;
+        }
+        ring.consume(static_cast<int>(copied));
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * kStreamChunk);
+}
+
+BENCHMARK(BM_StreamPerByte);
+BENCHMARK(BM_StreamSpans);
+
+// ---- framed byte stream: MagicRingBuffer vs CircularBuffer<char> spans ----
+// frames are a 4 byte length and 16 .. max bytes of payload, fed into a 64KB ring in 16KB "recv"s that
+// dont care about frame boundaries, then every complete frame is parsed (a checksum over its payload).
+// The wrapped ring has to copy a frame that straddles the end into a scratch buffer before it can parse it,
+// the magic ring parses every frame in place
+
+namespace {
+
+constexpr size_t kFrameRing = 1 << 16;
+constexpr size_t kRecvSize = 16 * 1024;
+
+std::vector<char> makeFrameStream(size_t bytes, uint32_t maxPayload) {
+    std::vector<char> stream;
+    uint32_t x = 12345;
+    while (stream.size() < bytes) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        uint32_t len = 16 + x % (maxPayload - 15);
+        const char* header = reinterpret_cast<const char*>(&len);
+        stream.insert(stream.end(), header, header + sizeof(len));
+        stream.insert(stream.end(), len, static_cast<char>(x));
+    }
+    return stream;
+}
+
+// 8 bytes at a time, cheap enough that the ring's own overhead still shows
+uint64_t checksum(const char* payload, uint32_t len) {
+    uint64_t sum = 0;
+    uint32_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, payload + i, 8);
+        sum += word;
+    }
+    for (; i < len; i++) {
+        sum += static_cast<unsigned char>(payload[i]);
+    }
+    return sum;
+}
+
+} // namespace
+
+static void BM_FramesMagicRing(benchmark::State& state) {
+    auto stream = makeFrameStream(8 << 20, state.range(0));
+    MagicRingBuffer ring(kFrameRing);
+    uint64_t sum = 0;
+    for (auto _: state) {
+        size_t fed = 0;
+        while (fed < stream.size() || ring.size() >= sizeof(uint32_t)) {
+            fed += ring.write(stream.data() + fed, std::min(kRecvSize, stream.size() - fed));
+            while (true) {
+                std::span<char> bytes = ring.readable();
+                uint32_t len;
+                if (bytes.size() < sizeof(len)) {
+                    break;
+                }
+                std::memcpy(&len, bytes.data(), sizeof(len));
+                if (bytes.size() < sizeof(len) + len) {
+                    break;
+                }
+                sum += checksum(bytes.data() + sizeof(len), len);
+                ring.consume(sizeof(len) + len);
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(state.iterations() * stream.size());
+}
+
+static void BM_FramesWrappedRing(benchmark::State& state) {
+    auto stream = makeFrameStream(8 << 20, state.range(0));
+    CircularBuffer<char> ring(kFrameRing);
+    std::vector<char> scratch(state.range(0));
+    uint64_t sum = 0;
+    for (auto _: state) {
+        size_t fed = 0;
+        while (fed < stream.size() || ring.size() >= static_cast<int>(sizeof(uint32_t))) {
+            size_t want = std::min(kRecvSize, stream.size() - fed);
+            size_t copied = 0;
+            for (std::span<char> span: ring.writable_spans()) {
+                size_t n = std::min(span.size(), want - copied);
+                std::memcpy(span.data(), stream.data() + fed + copied, n);
+                copied += n;
+            }
+            ring.commit_write(static_cast<int>(copied));
+            fed += copied;
+            while (true) {
+                auto [first, second] = ring.readable_spans();
+                size_t available = first.size() + second.size();
+                uint32_t len;
+                if (available < sizeof(len)) {
+                    break;
+                }
+                // the header and the payload can each be split over the two spans
+                auto gather = [&](char* dest, size_t offset, size_t n) {
+                    size_t fromFirst = offset < first.size() ? std::min(n, first.size() - offset) : 0;
+                    std::memcpy(dest, first.data() + offset, fromFirst);
+                    std::memcpy(dest + fromFirst, second.data() + (offset + fromFirst - first.size()), n - fromFirst);
+                };
+                gather(reinterpret_cast<char*>(&len), 0, sizeof(len));
+                size_t frame = sizeof(len) + len;
+                if (available < frame) {
+                    break;
+                }
+                if (frame <= first.size()) {
+                    sum += checksum(first.data() + sizeof(len), len);
+                } else {
+                    gather(scratch.data(), sizeof(len), len);
+                    sum += checksum(scratch.data(), len);
+                }
+                ring.consume(static_cast<int>(frame));
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(state.iterations() * stream.size());
+}
+
+// max payload: small messages, MTU sized ones
+BENCHMARK(BM_FramesMagicRing)->Arg(128)->Arg(1500)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FramesWrappedRing)->Arg(128)->Arg(1500)->Unit(benchmark::kMillisecond);
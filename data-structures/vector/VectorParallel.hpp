@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Vector.hpp"
+#include "../../concurrency/threadpool/ThreadPool.hpp"
+
+// Parallel versions of the usual algorithms for Vector, run on a ThreadPool (ThreadPool::global() unless
+// you pass your own).
+//
+//   parallel::for_each(vec, f)           f(x) on every element
+//   parallel::transform(vec, f)          x = f(x) on every element (parallel Vector::transform)
+//   parallel::reduce(vec, init, op)      op over all elements, op has to be associative
+//   parallel::sort(vec, comp)            not stable
+//   parallel::partition(vec, pred)       elements with pred true first, returns how many there are. not stable
+//
+// The vector is cut into contiguous chunks and the pool's threads (plus the caller) take chunks until there
+// are none left. Chunk boundaries are moved to cache line boundaries wherever the element size allows it, so
+// two threads never write to the same cache line (that false sharing would bounce the line between cores
+// on every write, and a loop that writes every element would run slower on more threads than on one).
+// Below kSequentialThreshold elements, or on a pool without workers, it all just runs sequentially on the
+// caller: splitting a small vector costs more than the loop itself.
+//
+// sort and partition do their chunks in parallel and then combine neighbouring chunks pairwise,
+// log2(chunks) rounds that each run in parallel too (std::inplace_merge for sort, a std::rotate that swaps
+// one chunk's false part with the next chunk's true part for partition).
+
+namespace parallel {
+
+inline constexpr size_t kSequentialThreshold = 1 << 14;
+inline constexpr size_t kCacheLine = 64;
+
+namespace detail {
+
+// [bounds[i], bounds[i + 1]) is chunk i, about n / parts elements each
+template <typename T>
+std::vector<size_t> chunkBounds(const T* data, size_t n, size_t parts) {
+    std::vector<size_t> bounds{0};
+    size_t per = (n + parts - 1) / parts;
+    for (size_t i = 1; i < parts; i++) {
+        size_t b = i * per;
+        if constexpr (kCacheLine % sizeof(T) == 0) {
+            // push the boundary forward to the first element that starts a cache line
+            size_t misalign = reinterpret_cast<uintptr_t>(data + std::min(b, n)) % kCacheLine;
+            if (misalign != 0 && (kCacheLine - misalign) % sizeof(T) == 0) {
+                b += (kCacheLine - misalign) / sizeof(T);
+            }
+        }
+        b = std::min(b, n);
+        if (b > bounds.back()) {
+            bounds.push_back(b);
+        }
+    }
+    if (n > bounds.back()) {
+        bounds.push_back(n);
+    }
+    return bounds;
+}
+
+// a few chunks per thread for the simple loops, so a thread that gets a slow chunk doesnt hold everyone up
+inline size_t loopChunks(const ThreadPool& pool) {
+    return (pool.size() + 1) * 4;
+}
+
+inline bool sequential(size_t n, const ThreadPool& pool) {
+    return n < kSequentialThreshold || pool.size() == 0;
+}
+
+// merges neighbouring chunks pairwise until one is left: combine(begin, middle, end) joins [begin, middle)
+// and [middle, end). With an odd number of chunks the last one just waits for the next round
+template <typename Combine>
+void combineRounds(std::vector<size_t> bounds, ThreadPool& pool, Combine combine) {
+    while (bounds.size() > 2) {
+        size_t pairs = (bounds.size() - 1) / 2;
+        pool.parallel_for(pairs, [&](size_t p) {
+            combine(bounds[2 * p], bounds[2 * p + 1], bounds[2 * p + 2]);
+        });
+        std::vector<size_t> merged;
+        for (size_t i = 0; i < bounds.size(); i += 2) {
+            merged.push_back(bounds[i]);
+        }
+        if (merged.back() != bounds.back()) {
+            merged.push_back(bounds.back());
+        }
+        bounds = std::move(merged);
+    }
+}
+
+} // namespace detail
+
+template <typename T, typename G, size_t N, typename F>
+void for_each(Vector<T, G, N>& vec, F f, ThreadPool& pool = ThreadPool::global()) {
+    T* data = vec.data();
+    if (detail::sequential(vec.size(), pool)) {
+        std::for_each(data, data + vec.size(), f);
+        return;
+    }
+    auto bounds = detail::chunkBounds(data, vec.size(), detail::loopChunks(pool));
+    pool.parallel_for(bounds.size() - 1, [&](size_t c) {
+        std::for_each(data + bounds[c], data + bounds[c + 1], f);
+    });
+}
+
+template <typename T, typename G, size_t N, typename F>
+requires std::convertible_to<std::invoke_result_t<F&, T&>, T>
+void transform(Vector<T, G, N>& vec, F f, ThreadPool& pool = ThreadPool::global()) {
+    T* data = vec.data();
+    if (detail::sequential(vec.size(), pool)) {
+        vec.transform(f);
+        return;
+    }
+    auto bounds = detail::chunkBounds(data, vec.size(), detail::loopChunks(pool));
+    pool.parallel_for(bounds.size() - 1, [&](size_t c) {
+        // same plain loop as Vector::transform so the compiler can still vectorise each chunk
+        for (size_t i = bounds[c]; i < bounds[c + 1]; i++) {
+            data[i] = f(data[i]);
+        }
+    });
+}
+
+// each chunk is reduced on its own and then the partial results are combined in chunk order, so op only needs
+// to be associative, not commutative. init is used once, on the left.
+// Like std::reduce, op has to take (Acc, T) and (Acc, Acc) and Acc has to be constructible from a T
+// (every chunk but the first starts from its first element)
+template <typename T, typename G, size_t N, typename Acc, typename Op = std::plus<>>
+Acc reduce(const Vector<T, G, N>& vec, Acc init, Op op = {}, ThreadPool& pool = ThreadPool::global()) {
+    const T* data = vec.data();
+    if (detail::sequential(vec.size(), pool)) {
+        for (size_t i = 0; i < vec.size(); i++) {
+            init = op(std::move(init), data[i]);
+        }
+        return init;
+    }
+    auto bounds = detail::chunkBounds(data, vec.size(), detail::loopChunks(pool));
+    std::vector<Acc> partial(bounds.size() - 1, init);
+    pool.parallel_for(bounds.size() - 1, [&](size_t c) {
+        // chunks are never empty
+        size_t i = bounds[c];
+        Acc acc = c == 0 ? std::move(partial[0]) : Acc(data[i++]);
+        for (; i < bounds[c + 1]; i++) {
+            acc = op(std::move(acc), data[i]);
+        }
+        partial[c] = std::move(acc);
+    });
+    Acc result = std::move(partial[0]);
+    for (size_t c = 1; c < partial.size(); c++) {
+        result = op(std::move(result), std::move(partial[c]));
+    }
+    return result;
+}
+
+template <typename T, typename G, size_t N, typename Compare = std::less<>>
+void sort(Vector<T, G, N>& vec, Compare comp = {}, ThreadPool& pool = ThreadPool::global()) {
+    T* data = vec.data();
+    if (detail::sequential(vec.size(), pool)) {
+        std::sort(data, data + vec.size(), comp);
+        return;
+    }
+    // one chunk per thread, fewer chunks means fewer merge rounds
+    auto bounds = detail::chunkBounds(data, vec.size(), pool.size() + 1);
+    pool.parallel_for(bounds.size() - 1, [&](size_t c) {
+        std::sort(data + bounds[c], data + bounds[c + 1], comp);
+    });
+    detail::combineRounds(std::move(bounds), pool, [&](size_t begin, size_t middle, size_t end) {
+        std::inplace_merge(data + begin, data + middle, data + end, comp);
+    });
+}
+
+template <typename T, typename G, size_t N, typename Pred>
+size_t partition(Vector<T, G, N>& vec, Pred pred, ThreadPool& pool = ThreadPool::global()) {
+    T* data = vec.data();
+    if (detail::sequential(vec.size(), pool)) {
+        return static_cast<size_t>(std::partition(data, data + vec.size(), pred) - data);
+    }
+    auto bounds = detail::chunkBounds(data, vec.size(), pool.size() + 1);
+    // split[c] is where chunk c's false part starts. Combined chunks keep the index of their first chunk
+    std::vector<size_t> split(bounds.size() - 1);
+    auto chunkAt = [&](size_t begin) {
+        return static_cast<size_t>(std::lower_bound(bounds.begin(), bounds.end(), begin) - bounds.begin());
+    };
+    pool.parallel_for(bounds.size() - 1, [&](size_t c) {
+        split[c] = static_cast<size_t>(std::partition(data + bounds[c], data + bounds[c + 1], pred) - data);
+    });
+    // [T1 F1][T2 F2] -> [T1 T2][F1 F2]: rotate F1 and T2 past each other
+    detail::combineRounds(bounds, pool, [&](size_t begin, size_t middle, size_t) {
+        size_t left = chunkAt(begin);
+        size_t rightSplit = split[chunkAt(middle)];
+        std::rotate(data + split[left], data + middle, data + rightSplit);
+        split[left] += rightSplit - middle;
+    });
+    return split[0];
+}
+
+} // namespace parallel
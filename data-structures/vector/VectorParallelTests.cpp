@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <string>
+#include "VectorParallel.hpp"
+
+namespace {
+
+Vector<uint32_t> randomValues(size_t n, uint32_t seed = 1) {
+    std::mt19937 rng(seed);
+    Vector<uint32_t> vec;
+    vec.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        vec.push_back(rng() % 100000);
+    }
+    return vec;
+}
+
+} // namespace
+
+// odd sizes and pools, so the chunks and the merge rounds dont line up evenly
+class VectorParallelTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(VectorParallelTest, SortMatchesStdSort) {
+    ThreadPool pool(GetParam());
+    for (size_t n: {size_t{100}, size_t{70001}, size_t{300007}}) {
+        auto vec = randomValues(n);
+        std::vector<uint32_t> expected(vec.data(), vec.data() + n);
+        std::sort(expected.begin(), expected.end());
+        parallel::sort(vec, std::less<>{}, pool);
+        EXPECT_TRUE(std::equal(expected.begin(), expected.end(), vec.data()));
+    }
+}
+
+TEST_P(VectorParallelTest, PartitionSplitsAndKeepsEveryElement) {
+    ThreadPool pool(GetParam());
+    auto vec = randomValues(250003);
+    std::vector<uint32_t> before(vec.data(), vec.data() + vec.size());
+    auto isEven = [](uint32_t x) { return x % 2 == 0; };
+    size_t split = parallel::partition(vec, isEven, pool);
+    EXPECT_EQ(split, static_cast<size_t>(std::count_if(before.begin(), before.end(), isEven)));
+    EXPECT_TRUE(std::all_of(vec.data(), vec.data() + split, isEven));
+    EXPECT_TRUE(std::none_of(vec.data() + split, vec.data() + vec.size(), isEven));
+    std::sort(before.begin(), before.end());
+    std::sort(vec.data(), vec.data() + vec.size());
+    EXPECT_TRUE(std::equal(before.begin(), before.end(), vec.data()));
+}
+
+TEST_P(VectorParallelTest, ReduceTransformForEach) {
+    ThreadPool pool(GetParam());
+    Vector<uint32_t> vec;
+    for (uint32_t i = 1; i <= 100000; ++i) {
+        vec.push_back(i);
+    }
+    EXPECT_EQ(parallel::reduce(vec, uint64_t{0}, std::plus<>{}, pool), uint64_t{5000050000});
+
+    // not commutative: only works if the chunks are combined in order
+    Vector<std::string> words;
+    for (int i = 0; i < 20000; ++i) {
+        words.push_back(std::string(1, static_cast<char>('a' + i % 26)));
+    }
+    std::string joined = parallel::reduce(words, std::string(">"), std::plus<>{}, pool);
+    EXPECT_EQ(joined.size(), 20001);
+    EXPECT_EQ(joined.substr(0, 4), ">abc");
+    EXPECT_EQ(joined.substr(26 * 700 - 2, 3), "xyz");
+
+    parallel::transform(vec, [](uint32_t x) { return x * 2; }, pool);
+    EXPECT_EQ(vec[99999], 200000);
+
+    std::atomic<uint64_t> sum{0};
+    parallel::for_each(vec, [&](uint32_t x) { sum += x; }, pool);
+    EXPECT_EQ(sum.load(), uint64_t{10000100000});
+}
+
+INSTANTIATE_TEST_SUITE_P(Pools, VectorParallelTest, ::testing::Values(0, 1, 3, 6));
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// SIMD kernels behind Vector::find / count / min / max for arithmetic element types.
+//
+// Every kernel is written once with GCC vector extensions (VectorSimdKernels.hpp), then compiled three times
+// under #pragma GCC target(...) for SSE2 (16 byte registers), AVX2 (32) and AVX-512 (64).
+// (the pragma has to be around the definitions, inlining a generic vector function into a target(...)
+// function doesnt work, gcc splits the vector ops into scalar ones before it inlines)
+// The cpu is checked once at runtime and every call jumps to the widest version it supports,
+// so one binary built without -mavx2 still uses AVX2 / AVX-512 where its available.
+// SwissHashmap picks its SIMD at compile time instead, this is the runtime version of the same idea.
+
+namespace vector_simd {
+
+// bool and long double have no vector registers
+template <typename T>
+concept SimdElement = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && sizeof(T) <= 8
+                   && !std::is_same_v<T, long double>;
+
+enum class Isa {
+    Scalar,
+    Sse2,
+    Avx2,
+    Avx512,
+};
+
+inline Isa detectIsa() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const Isa isa = [] {
+        __builtin_cpu_init();
+        // bw adds the 8 and 16 bit lane instructions
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+            return Isa::Avx512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return Isa::Avx2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return Isa::Sse2;
+        }
+        return Isa::Scalar;
+    }();
+    return isa;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#define VECTOR_SIMD_NAMESPACE sse2
+#define VECTOR_SIMD_BYTES 16
+#include "VectorSimdKernels.hpp"
+#undef VECTOR_SIMD_NAMESPACE
+#undef VECTOR_SIMD_BYTES
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#define VECTOR_SIMD_NAMESPACE avx2
+#define VECTOR_SIMD_BYTES 32
+#include "VectorSimdKernels.hpp"
+#undef VECTOR_SIMD_NAMESPACE
+#undef VECTOR_SIMD_BYTES
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
+#define VECTOR_SIMD_NAMESPACE avx512
+#define VECTOR_SIMD_BYTES 64
+#include "VectorSimdKernels.hpp"
+#undef VECTOR_SIMD_NAMESPACE
+#undef VECTOR_SIMD_BYTES
+#pragma GCC pop_options
+
+#endif
+
+template <SimdElement T>
+size_t find(const T* data, size_t n, T value) {
+    switch (detectIsa()) {
+#if defined(__x86_64__) || defined(__i386__)
+    case Isa::Avx512: return avx512::find(data, n, value);
+    case Isa::Avx2: return avx2::find(data, n, value);
+    case Isa::Sse2: return sse2::find(data, n, value);
+#endif
+    default: return static_cast<size_t>(std::find(data, data + n, value) - data);
+    }
+}
+
+template <SimdElement T>
+size_t count(const T* data, size_t n, T value) {
+    switch (detectIsa()) {
+#if defined(__x86_64__) || defined(__i386__)
+    case Isa::Avx512: return avx512::count(data, n, value);
+    case Isa::Avx2: return avx2::count(data, n, value);
+    case Isa::Sse2: return sse2::count(data, n, value);
+#endif
+    default: return static_cast<size_t>(std::count(data, data + n, value));
+    }
+}
+
+template <SimdElement T, bool IsMin>
+T minMax(const T* data, size_t n) {
+    switch (detectIsa()) {
+#if defined(__x86_64__) || defined(__i386__)
+    case Isa::Avx512: return avx512::minMax<T, IsMin>(data, n);
+    case Isa::Avx2: return avx2::minMax<T, IsMin>(data, n);
+    case Isa::Sse2: return sse2::minMax<T, IsMin>(data, n);
+#endif
+    default: return IsMin ? *std::min_element(data, data + n) : *std::max_element(data, data + n);
+    }
+}
+
+} // namespace vector_simd
@@ -0,0 +1,102 @@
+// No #pragma once on purpose: VectorSimd.hpp includes this three times, once per instruction set,
+// with VECTOR_SIMD_NAMESPACE and VECTOR_SIMD_BYTES (the register width) defined and a
+// #pragma GCC target(...) around it, so the same source compiles to SSE2, AVX2 and AVX-512.
+//
+// T __attribute__((vector_size(Bytes))) is a register of Bytes / sizeof(T) lanes, and +, ==, <, ?: work
+// lane by lane on it. A comparison gives back a mask: all ones / all zeros per lane, in a signed int as wide as T.
+
+namespace VECTOR_SIMD_NAMESPACE {
+
+constexpr size_t kBytes = VECTOR_SIMD_BYTES;
+
+template <typename T>
+size_t find(const T* data, size_t n, T value) {
+    typedef T Vec __attribute__((vector_size(kBytes)));
+    constexpr size_t kLanes = kBytes / sizeof(T);
+    const Vec needle = Vec{} + value;
+    size_t i = 0;
+    // 4 registers per iteration, the compares are independent and theres only one branch per 4
+    for (; i + 4 * kLanes <= n; i += 4 * kLanes) {
+        Vec v[4];
+        std::memcpy(v, data + i, sizeof(v));
+        auto hit = (v[0] == needle) | (v[1] == needle) | (v[2] == needle) | (v[3] == needle);
+        uint64_t words[kBytes / 8];
+        std::memcpy(words, &hit, kBytes);
+        uint64_t any = 0;
+        for (uint64_t word: words) {
+            any |= word;
+        }
+        if (any) {
+            break;
+        }
+    }
+    // the block with the match (or the tail) one element at a time
+    for (; i < n; i++) {
+        if (data[i] == value) {
+            return i;
+        }
+    }
+    return n;
+}
+
+template <typename T>
+size_t count(const T* data, size_t n, T value) {
+    typedef T Vec __attribute__((vector_size(kBytes)));
+    // mask lanes are as wide as T, the counts are kept in unsigned lanes of the same width so they wrap
+    // instead of overflowing (signed lanes would be UB past 127 matches)
+    using Lane = std::conditional_t<sizeof(T) == 1, uint8_t,
+                 std::conditional_t<sizeof(T) == 2, uint16_t, std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+    typedef Lane Counts __attribute__((vector_size(kBytes)));
+    constexpr size_t kLanes = kBytes / sizeof(T);
+    const Vec needle = Vec{} + value;
+    size_t total = 0;
+    size_t i = 0;
+    while (i + kLanes <= n) {
+        // a match is all ones (-1) in its lane, so subtracting the mask as unsigned counts it. An 8 bit lane
+        // holds at most 255, so the lanes get added up into total every 255 registers
+        Counts counts{};
+        for (size_t block = 0; block < 255 && i + kLanes <= n; block++, i += kLanes) {
+            Vec v;
+            std::memcpy(&v, data + i, kBytes);
+            counts -= reinterpret_cast<Counts>(v == needle);
+        }
+        for (size_t lane = 0; lane < kLanes; lane++) {
+            total += counts[lane];
+        }
+    }
+    for (; i < n; i++) {
+        total += data[i] == value;
+    }
+    return total;
+}
+
+// n has to be at least 1. With NaNs in a float range the result is unspecified
+template <typename T, bool IsMin>
+T minMax(const T* data, size_t n) {
+    typedef T Vec __attribute__((vector_size(kBytes)));
+    constexpr size_t kLanes = kBytes / sizeof(T);
+    T best = data[0];
+    size_t i = 0;
+    if (n >= kLanes) {
+        Vec acc;
+        std::memcpy(&acc, data, kBytes);
+        for (i = kLanes; i + kLanes <= n; i += kLanes) {
+            Vec v;
+            std::memcpy(&v, data + i, kBytes);
+            if constexpr (IsMin) {
+                acc = v < acc ? v : acc;
+            } else {
+                acc = v > acc ? v : acc;
+            }
+        }
+        for (size_t lane = 0; lane < kLanes; lane++) {
+            best = IsMin ? std::min(best, acc[lane]) : std::max(best, acc[lane]);
+        }
+    }
+    for (; i < n; i++) {
+        best = IsMin ? std::min(best, data[i]) : std::max(best, data[i]);
+    }
+    return best;
+}
+
+} // namespace VECTOR_SIMD_NAMESPACE
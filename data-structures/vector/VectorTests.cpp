@@ -1,5 +1,14 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <ranges>
+#include <ratio>
+#include <span>
+#include <sstream>
 #include <string>
+#include <vector>
 #include "Vector.hpp"
 
 TEST(VectorTest, DefaultConstructorCreatesEmptyVector) {
@@ -159,4 +168,271 @@ TEST(VectorTest, SwapExchangesContents) {
     EXPECT_EQ(b.size(), 2);
     EXPECT_EQ(a[0], 3);
     EXPECT_EQ(b[0], 1);
-}
\ No newline at end of file
+}
+TEST(VectorTest, ReserveDoesNotChangeSize) {
+    Vector<std::string> vec{"a", "b"};
+    vec.reserve(10);
+    EXPECT_EQ(vec.capacity(), 10);
+    EXPECT_EQ(vec.size(), 2);
+    EXPECT_EQ(vec[1], "b");
+    vec.reserve(4); // never shrinks
+    EXPECT_EQ(vec.capacity(), 10);
+}
+
+TEST(VectorTest, GrowthFactor) {
+    Vector<int, std::ratio<3, 2>> vec;
+    std::vector<size_t> capacities;
+    for (int i = 0; i < 10; ++i) {
+        vec.push_back(i);
+        if (capacities.empty() || capacities.back() != vec.capacity()) {
+            capacities.push_back(vec.capacity());
+        }
+    }
+    EXPECT_EQ(capacities, (std::vector<size_t>{1, 2, 3, 4, 6, 9, 13}));
+    EXPECT_EQ(vec[9], 9);
+}
+
+namespace {
+
+// owns memory through a pointer, nothing points back at it, so its safe to relocate with memcpy
+struct Handle {
+    int* value;
+    explicit Handle(int v): value(new int(v)) {}
+    Handle(const Handle& other): value(new int(*other.value)) {}
+    Handle(Handle&& other) noexcept: value(other.value) { other.value = nullptr; }
+    ~Handle() { delete value; }
+};
+
+} // namespace
+
+template <>
+struct is_trivially_relocatable<Handle> : std::true_type {};
+
+TEST(VectorTest, TriviallyRelocatableGrowthAndInsert) {
+    Vector<Handle> vec;
+    for (int i = 0; i < 1000; ++i) {
+        vec.emplace_back(i);
+    }
+    vec.emplace_insert(0, -1);
+    vec.insert(500, {Handle(7), Handle(8)});
+    EXPECT_EQ(vec.size(), 1003);
+    EXPECT_EQ(*vec[0].value, -1);
+    EXPECT_EQ(*vec[1].value, 0);
+    EXPECT_EQ(*vec[500].value, 7);
+    EXPECT_EQ(*vec[502].value, 499);
+    EXPECT_EQ(*vec[1002].value, 999);
+
+    Vector<Handle> copy(vec);
+    EXPECT_NE(copy[0].value, vec[0].value);
+    EXPECT_EQ(*copy[1002].value, 999);
+}
+
+TEST(VectorTest, PodGrowthKeepsValues) {
+    struct Point {
+        int x;
+        double y;
+    };
+    Vector<Point> vec;
+    for (int i = 0; i < 100000; ++i) {
+        vec.push_back(Point{i, i * 0.5});
+    }
+    Vector<Point> copy(vec);
+    for (int i = 0; i < 100000; i += 999) {
+        EXPECT_EQ(vec[i].x, i);
+        EXPECT_EQ(copy[i].y, i * 0.5);
+    }
+}
+
+TEST(VectorTest, AssignAppendAndInsertRange) {
+    Vector<std::string> vec{"x"};
+    vec.assign(3, "a");
+    EXPECT_EQ(vec.size(), 3);
+    EXPECT_EQ(vec[2], "a");
+
+    std::vector<std::string> more{"b", "c"};
+    vec.append(more);
+    EXPECT_EQ(more[0], "b"); // lvalue range is copied
+    vec.append(std::move(more));
+    EXPECT_TRUE(more[0].empty()); // rvalue range is moved from
+    EXPECT_EQ(vec.size(), 7);
+    EXPECT_EQ(vec[6], "c");
+
+    // an rvalue view doesnt own its elements, they stay where they are
+    std::vector<std::string> src{"d", "e", "f"};
+    vec.append(src | std::views::take(2));
+    EXPECT_EQ(src[0], "d");
+    EXPECT_EQ(src[1], "e");
+    vec.append(std::span<std::string>(src).subspan(2));
+    EXPECT_EQ(src[2], "f");
+    // elements that are prvalues get built straight from *it
+    std::vector<int> numbers{7, 8};
+    vec.append(numbers | std::views::transform([](int i) { return std::to_string(i); }));
+    EXPECT_EQ(vec.size(), 12);
+    EXPECT_EQ(vec[7], "d");
+    EXPECT_EQ(vec[9], "f");
+    EXPECT_EQ(vec[11], "8");
+    vec.resize(7);
+
+    std::vector<std::string> middle{"m1", "m2"};
+    vec.insert_range(1, middle.begin(), middle.end());
+    EXPECT_EQ(vec.size(), 9);
+    EXPECT_EQ(vec[0], "a");
+    EXPECT_EQ(vec[1], "m1");
+    EXPECT_EQ(vec[2], "m2");
+    EXPECT_EQ(vec[3], "a");
+    EXPECT_THROW(vec.insert_range(100, middle.begin(), middle.end()), std::out_of_range);
+
+    // single pass iterators get buffered first
+    std::istringstream in("4 5 6");
+    Vector<int> ints{1, 2, 3};
+    ints.insert_range(1, std::istream_iterator<int>(in), std::istream_iterator<int>());
+    EXPECT_EQ(ints.size(), 6);
+    EXPECT_EQ(ints[1], 4);
+    EXPECT_EQ(ints[3], 6);
+    EXPECT_EQ(ints[4], 2);
+
+    ints.assign(0, 0);
+    EXPECT_EQ(ints.size(), 0);
+}
+
+TEST(VectorTest, TransformInPlace) {
+    Vector<int> vec{1, 2, 3};
+    vec.transform([](int x) { return x * 10; });
+    EXPECT_EQ(vec[2], 30);
+}
+
+template <typename T>
+class VectorSimdTest : public testing::Test {};
+
+using SimdTypes = testing::Types<int8_t, uint8_t, int16_t, uint16_t, int32_t, uint32_t, int64_t, uint64_t, float, double>;
+TYPED_TEST_SUITE(VectorSimdTest, SimdTypes);
+
+// every instruction set is called directly as well, the dispatcher only ever picks one of them on a given cpu
+TYPED_TEST(VectorSimdTest, MatchesStdAlgorithms) {
+    using T = TypeParam;
+    std::mt19937 rng(3);
+    for (size_t n: {size_t{1}, size_t{7}, size_t{64}, size_t{1000}, size_t{5000}}) {
+        Vector<T> vec;
+        std::vector<T> ref;
+        for (size_t i = 0; i < n; ++i) {
+            T value = static_cast<T>(rng() % 100);
+            vec.push_back(value);
+            ref.push_back(value);
+        }
+        for (T needle: {T(0), T(42), T(99), T(100)}) {
+            size_t expected = std::find(ref.begin(), ref.end(), needle) - ref.begin();
+            size_t expectedCount = std::count(ref.begin(), ref.end(), needle);
+            EXPECT_EQ(vec.find(needle), expected);
+            EXPECT_EQ(vec.count(needle), expectedCount);
+            EXPECT_EQ(vector_simd::sse2::find(ref.data(), n, needle), expected);
+            EXPECT_EQ(vector_simd::sse2::count(ref.data(), n, needle), expectedCount);
+            if (__builtin_cpu_supports("avx2")) {
+                EXPECT_EQ(vector_simd::avx2::find(ref.data(), n, needle), expected);
+                EXPECT_EQ(vector_simd::avx2::count(ref.data(), n, needle), expectedCount);
+            }
+        }
+        EXPECT_EQ(vec.min(), *std::min_element(ref.begin(), ref.end()));
+        EXPECT_EQ(vec.max(), *std::max_element(ref.begin(), ref.end()));
+        EXPECT_EQ((vector_simd::sse2::minMax<T, true>(ref.data(), n)), *std::min_element(ref.begin(), ref.end()));
+    }
+
+    // more than 255 matches per lane, the 8 bit counters have to be flushed (and go past 127 on the way,
+    // run this under -fsanitize=undefined to see the lanes dont overflow)
+    Vector<T> same(100000, T(7));
+    EXPECT_EQ(same.count(T(7)), 100000);
+    EXPECT_EQ(vector_simd::sse2::count(same.data(), same.size(), T(7)), 100000);
+    EXPECT_EQ(same.find(T(8)), same.size());
+}
+
+TEST(VectorTest, MinMaxOnEmptyAndNonArithmetic) {
+    Vector<int> empty;
+    EXPECT_THROW(empty.min(), std::out_of_range);
+    EXPECT_THROW(empty.max(), std::out_of_range);
+    EXPECT_EQ(empty.find(1), 0);
+
+    Vector<std::string> words{"pear", "apple", "zoo"};
+    EXPECT_EQ(words.min(), "apple");
+    EXPECT_EQ(words.max(), "zoo");
+    EXPECT_EQ(words.find("zoo"), 2);
+    EXPECT_EQ(words.count("fig"), 0);
+}
+
+TEST(VectorTest, SmallVectorStaysInlineThenSpills) {
+    SmallVector<std::string, 4> vec;
+    EXPECT_EQ(vec.capacity(), 4);
+    for (int i = 0; i < 4; ++i) {
+        vec.push_back(std::to_string(i));
+    }
+    EXPECT_TRUE(vec.is_inline());
+    EXPECT_EQ(vec.capacity(), 4);
+
+    vec.push_back("4");
+    EXPECT_FALSE(vec.is_inline());
+    EXPECT_EQ(vec.capacity(), 8);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(vec[i], std::to_string(i));
+    }
+    vec.emplace_insert(0, "front");
+    EXPECT_EQ(vec[0], "front");
+    EXPECT_EQ(vec[5], "4");
+
+    // plain Vector doesnt pay for the inline buffer
+    EXPECT_EQ(sizeof(SmallVector<int, 4>), sizeof(Vector<int>) + 4 * sizeof(int));
+}
+
+TEST(VectorTest, SmallVectorMoveBothModes) {
+    // inline: elements are moved over one by one, the source is left empty
+    SmallVector<std::string, 4> small{"a", "b"};
+    SmallVector<std::string, 4> movedSmall(std::move(small));
+    EXPECT_TRUE(movedSmall.is_inline());
+    EXPECT_EQ(movedSmall.size(), 2);
+    EXPECT_EQ(movedSmall[1], "b");
+    EXPECT_EQ(small.size(), 0);
+    small.push_back("reused");
+    EXPECT_EQ(small[0], "reused");
+
+    // spilled: the heap buffer changes owner, no element is touched
+    SmallVector<std::string, 4> big{"0", "1", "2", "3", "4", "5"};
+    const std::string* heap = big.data();
+    SmallVector<std::string, 4> movedBig(std::move(big));
+    EXPECT_EQ(movedBig.data(), heap);
+    EXPECT_EQ(movedBig[5], "5");
+    EXPECT_EQ(big.size(), 0);
+    EXPECT_TRUE(big.is_inline());
+
+    // move assignment in every combination
+    SmallVector<std::string, 4> target{"x"};
+    target = std::move(movedBig);
+    EXPECT_EQ(target.data(), heap);
+    target = std::move(movedSmall);
+    EXPECT_EQ(target.size(), 2);
+    EXPECT_EQ(target[0], "a");
+    EXPECT_EQ(target.data(), heap); // kept its heap buffer and moved the inline elements into it
+
+    SmallVector<std::string, 4> other{"only"};
+    target.swap(other);
+    EXPECT_EQ(target.size(), 1);
+    EXPECT_EQ(target[0], "only");
+    EXPECT_EQ(other[1], "b");
+}
+
+TEST(VectorTest, SmallVectorCopyAndRelocatable) {
+    SmallVector<Handle, 2> vec;
+    vec.emplace_back(1);
+    vec.emplace_back(2);
+    SmallVector<Handle, 2> copy(vec);
+    EXPECT_TRUE(copy.is_inline());
+    EXPECT_NE(copy[0].value, vec[0].value);
+
+    // spilling a trivially relocatable type memcpy's out of the inline buffer, later growth reallocs
+    for (int i = 3; i <= 100; ++i) {
+        vec.emplace_back(i);
+    }
+    EXPECT_FALSE(vec.is_inline());
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(*vec[i].value, i + 1);
+    }
+    copy = vec;
+    EXPECT_EQ(copy.size(), 100);
+    EXPECT_EQ(*copy[99].value, 100);
+}
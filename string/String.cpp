@@ -10,6 +10,10 @@ String::String() {
     smallBuffer[0] = '\0';
 }
 
+String::String(std::pmr::memory_resource* r) : String() {
+    resource = r;
+}
+
 String::String(const char* s) {
     // need to have the guard cause pointers can be null unlike references
     if (s == nullptr) {
@@ -21,7 +25,7 @@ String::String(const char* s) {
         ptr = smallBuffer;
     } else {
         sso = false;
-        ptr = new char[inputLen + 1];
+        ptr = allocateBuffer(inputLen + 1);
     }
     len = inputLen;
     // copies a block of memory from s array to ptr array 
@@ -38,7 +42,7 @@ String::String(const char* s, size_t l) : len(l) {
         ptr = smallBuffer;
     } else {
         sso = false;
-        ptr = new char[l + 1];
+        ptr = allocateBuffer(l + 1);
     }
     // copying only l characters -> so u dont copy the null terminator
     std::memcpy(ptr, s, l);
@@ -52,13 +56,13 @@ String::String(const String& other) : len(other.len) {
         ptr = smallBuffer;
     } else {
         sso = false;
-        ptr = new char[other.len + 1];
+        ptr = allocateBuffer(other.len + 1);
     }
     std::memcpy(ptr, other.ptr, other.len + 1);
 }
 
 // Move constructor.
-String::String(String&& other) noexcept : len(other.len), sso(other.sso) {
+String::String(String&& other) noexcept : len(other.len), sso(other.sso), resource(other.resource) {
     if (other.sso) {
         // If other is in SSO mode, copy its buffer.
         ptr = smallBuffer;
@@ -76,7 +80,9 @@ String::String(String&& other) noexcept : len(other.len), sso(other.sso) {
 }
 
 // string view is just 2 words: char pointer and size, and has lots of util methods
-String::String(std::string_view sv) : len(sv.size()), sso(len <= SSO_SIZE) {
+String::String(std::string_view sv) : String(sv, nullptr) {}
+
+String::String(std::string_view sv, std::pmr::memory_resource* r) : len(sv.size()), sso(len <= SSO_SIZE), resource(r) {
 
     if (sso) {
         // Copy into small buffer
@@ -87,7 +93,7 @@ String::String(std::string_view sv) : len(sv.size()), sso(len <= SSO_SIZE) {
         ptr[len] = '\0';
     } else {
         // Heap allocation path
-        ptr = new char[len + 1];
+        ptr = allocateBuffer(len + 1);
         std::memcpy(ptr, sv.data(), len);
         ptr[len] = '\0';
     }
@@ -101,7 +107,8 @@ String::String(const std::string& str)
 
 String& String::operator=(const String& other) {
     if (this != &other) {
-        String temp(other);
+        // the copy is made in our resource, so swapping keeps every buffer with the resource it came from
+        String temp(std::string_view(other.ptr, other.len), resource);
         // swap is exception safe bc it only performs low level non throwing operations like swapping pointers and no dynamic memory manipulation
         swap(temp);
     }
@@ -112,7 +119,7 @@ String& String::operator=(const String& other) {
 String& String::operator=(String&& other) noexcept {
     if (this != &other) {
         if (!sso) {
-            delete[] ptr;
+            freeBuffer(ptr, len + 1);
         }
         // Move data from other.
         len = other.len;
@@ -122,10 +129,17 @@ String& String::operator=(String&& other) noexcept {
             std::memcpy(ptr, other.ptr, other.len + 1);
         // dont have to delete memory and allocate new memory, just shifting
         // the pointers suffice for this use case!
-        } else {
+        } else if (other.resource == resource) {
             ptr = other.ptr;
             other.ptr = other.smallBuffer; // other goes to SSO mode
             other.sso = true;
+        } else {
+            // the buffer belongs to other's resource, we keep ours so it has to be copied after all
+            ptr = allocateBuffer(len + 1);
+            std::memcpy(ptr, other.ptr, len + 1);
+            other.freeBuffer(other.ptr, other.len + 1);
+            other.ptr = other.smallBuffer;
+            other.sso = true;
         }
         other.len = 0;
         other.smallBuffer[0] = '\0';
@@ -158,6 +172,8 @@ void String::swap(String& other) {
         std::swap(this->len, other.len);
         std::memcpy(this->smallBuffer, other.ptr, (this->len < SSO_SIZE ? this->len + 1 : SSO_SIZE + 1));
         std::memcpy(other.smallBuffer, tempSmall, SSO_SIZE + 1);
+        // the heap buffer changed owner, its resource has to go with it
+        std::swap(this->resource, other.resource);
     }
     else if (!this->sso && other.sso) {
         other.swap(*this);
@@ -166,6 +182,7 @@ void String::swap(String& other) {
     else {
         std::swap(this->ptr, other.ptr);
         std::swap(this->len, other.len);
+        std::swap(this->resource, other.resource);
     }
 }
 
@@ -183,7 +200,7 @@ String& String::append(const char* s) {
     if (useSSO) {
         newBuffer = smallBuffer;  // Use our internal buffer.
     } else {
-        newBuffer = new char[newLen + 1];
+        newBuffer = allocateBuffer(newLen + 1);
     }
 
     // Copy existing content.
@@ -194,7 +211,7 @@ String& String::append(const char* s) {
 
     // Free old heap memory if used.
     if (!sso) {
-        delete[] ptr;
+        freeBuffer(ptr, len + 1);
     }
 
     len = newLen;
@@ -207,7 +224,7 @@ String& String::append(const char* s) {
         // For safety, if newBuffer != smallBuffer, copy the contents.
         if (newBuffer != smallBuffer) {
             std::memcpy(smallBuffer, newBuffer, newLen + 1);
-            delete[] newBuffer;  // Clean up temporary allocation.
+            freeBuffer(newBuffer, newLen + 1);  // Clean up temporary allocation.
         }
     }
 
@@ -253,13 +270,17 @@ size_t String::size() const {
     return len;
 }
 
+std::pmr::memory_resource* String::get_resource() const {
+    return resource;
+}
+
 const char* String::c_str() const {
     return ptr;
 }
 
 void String::clear() {
     if (!sso) {
-        delete[] ptr;
+        freeBuffer(ptr, len + 1);
     }
     len = 0;
     sso = true;
@@ -342,14 +363,22 @@ const String::Iterator String::end() const {
 // --- Destructor ---
 String::~String() {
     if (!sso) {
-        delete[] ptr;
+        freeBuffer(ptr, len + 1);
     }
     // the rest of thr stuff is not dynamic memory on the heap, does not need to be deleted.
 }
 
+char* String::allocateBuffer(size_t n) {
+    if (resource) {
+        return static_cast<char*>(resource->allocate(n, alignof(char)));
+    }
+    return new char[n];
+}
 
-
-
-
-
-
+void String::freeBuffer(char* p, size_t n) {
+    if (resource) {
+        resource->deallocate(p, n, alignof(char));
+    } else {
+        delete[] p;
+    }
+}
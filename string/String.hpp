@@ -5,6 +5,7 @@
 #include <string>
 #include <iostream>
 #include <cstring> 
+#include <memory_resource>
 #include <string_view>   
 
 
@@ -19,7 +20,12 @@ private:
     // +1 for null terminator
     char smallBuffer[SSO_SIZE + 1];
     bool sso; // using sso if the string is <= 128 bytes
+    // where heap buffers come from, nullptr means new[] / delete[]
+    // (a heap buffer is always len + 1 bytes, thats the size handed back to the resource)
+    std::pmr::memory_resource* resource = nullptr;
     void swap(String& other); // fr exception safe assignment
+    char* allocateBuffer(size_t n);
+    void freeBuffer(char* p, size_t n);
 
 
 public:
@@ -60,6 +66,11 @@ public:
     // Default constructor (creates an empty string).
     String();
 
+    // Strings too long for the small buffer get their memory from resource (eg a MonotonicArena,
+    // allocators/arena) instead of new[]. Moves take the resource along, copies use the normal heap.
+    explicit String(std::pmr::memory_resource* resource);
+    String(std::string_view sv, std::pmr::memory_resource* resource);
+
     // Below, there is const in the arguments because
     // const in general accepts const and non const
     // but non const cannot accept const
@@ -128,6 +139,9 @@ public:
     // Return the size (length) of the string.
     size_t size() const;
 
+    // nullptr if heap buffers come from new[]
+    std::pmr::memory_resource* get_resource() const;
+
     // Return a C-style null-terminated string.
     const char* c_str() const;
 